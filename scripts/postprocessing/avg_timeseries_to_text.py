@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Converts the binary volume average time series file (Visualizations.avg_binary_fname)
+over to the usual avg_stress.txt, avg_pl_work.txt, avg_def_grad.txt, avg_dp_tensor.txt,
+and auto dt text files. The auto dt file is only written out if the run picked
+its time steps automatically.
+
+usage: avg_timeseries_to_text.py <time series file> [output directory]
+"""
+
+import os
+import struct
+import sys
+
+import numpy as np
+
+def read_timeseries(fname):
+    '''
+    Reads in the time series file and returns the column names, a 2D array
+    of the data with a row per time step, and whether dt_auto was on.
+    '''
+    with open(fname, 'rb') as f:
+        magic = f.read(8)
+        if magic not in (b'EXATS01\n', b'EXATS02\n'):
+            raise ValueError(fname + ' is not an ExaConstit time series file')
+        ncols = struct.unpack('i', f.read(4))[0]
+        # The older files didn't record if dt_auto was on, and they always
+        # had the auto dt file written out for them
+        dt_auto = True
+        if magic == b'EXATS02\n':
+            dt_auto = struct.unpack('i', f.read(4))[0] != 0
+        columns = []
+        for i in range(ncols):
+            length = struct.unpack('i', f.read(4))[0]
+            columns.append(f.read(length).decode('ascii'))
+        data = np.fromfile(f, dtype=np.float64)
+    # A partially written last record is just dropped
+    nrecords = data.size // ncols
+    return columns, data[0:nrecords * ncols].reshape((nrecords, ncols)), dt_auto
+
+def write_columns(fname, columns, data, prefix, fmt='%.8g'):
+    '''
+    Writes out all of the columns starting with prefix if there are any
+    '''
+    inds = [i for i, name in enumerate(columns) if name.startswith(prefix)]
+    if len(inds) == 0:
+        return
+    np.savetxt(fname, data[:, inds], fmt=fmt)
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+
+    outdir = sys.argv[2] if len(sys.argv) > 2 else '.'
+    columns, data, dt_auto = read_timeseries(sys.argv[1])
+
+    write_columns(os.path.join(outdir, 'avg_stress.txt'), columns, data, 'stress_')
+    write_columns(os.path.join(outdir, 'avg_pl_work.txt'), columns, data, 'pl_work')
+    write_columns(os.path.join(outdir, 'avg_def_grad.txt'), columns, data, 'def_grad_')
+    write_columns(os.path.join(outdir, 'avg_dp_tensor.txt'), columns, data, 'dp_tensor_')
+    if dt_auto:
+        write_columns(os.path.join(outdir, 'auto_dt_out.txt'), columns, data, 'dt', fmt='%.12g')
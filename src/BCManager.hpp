@@ -70,6 +70,10 @@ class BCManager
             return false;
          }
       }
+      /// The step of the last boundary condition update, which is saved in the
+      /// checkpoints so a restart picks up the same boundary conditions
+      int getStep() const { return step; }
+      void setStep(const int step_) { step = step_; }
    private:
       BCManager() {}
       BCManager(const BCManager&) = delete;
@@ -0,0 +1,129 @@
+#include "mechanics_async_output.hpp"
+#include "mechanics_log.hpp"
+
+#include <algorithm>
+
+using namespace mfem;
+
+AsyncOutputWriter::AsyncOutputWriter(const std::vector<DataCollection*> &data_colls, const int max_queue)
+   : dcs(data_colls), max_queue(std::max(max_queue, 1))
+{
+   MFEM_VERIFY(dcs.size() > 0, "AsyncOutputWriter needs at least one data collection");
+   src_mesh = dynamic_cast<ParMesh*>(dcs[0]->GetMesh());
+   MFEM_VERIFY(src_mesh != nullptr, "AsyncOutputWriter needs a parallel mesh");
+
+   dc_fields.resize(dcs.size());
+   for (size_t i = 0; i < dcs.size(); i++) {
+      MFEM_VERIFY(dcs[i]->GetMesh() == src_mesh, "AsyncOutputWriter data collections need to share a mesh");
+      for (const auto &field : dcs[i]->GetFieldMap()) {
+         auto pgf = dynamic_cast<ParGridFunction*>(field.second);
+         MFEM_VERIFY(pgf != nullptr, "AsyncOutputWriter fields need to be ParGridFunctions");
+         dc_fields[i].push_back(field.first);
+         src_fields[field.first] = pgf;
+      }
+   }
+
+   MPI_Comm_dup(src_mesh->GetComm(), &io_comm);
+   worker = std::thread(&AsyncOutputWriter::Run, this);
+}
+
+void AsyncOutputWriter::Enqueue(const int cycle, const double time)
+{
+   CALI_CXX_MARK_SCOPE("async_output_enqueue");
+   {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv_done.wait(lock, [this] { return queue.size() < max_queue; });
+   }
+
+   // The snapshot is made entirely on this thread, so any communication needed
+   // to set up its spaces still happens on the mesh's original communicator.
+   std::unique_ptr<Snapshot> snap(new Snapshot());
+   snap->cycle = cycle;
+   snap->time = time;
+   snap->mesh.reset(new SnapshotMesh(*src_mesh));
+
+   std::unordered_map<const ParFiniteElementSpace*, ParFiniteElementSpace*> space_map;
+   for (const auto &field : src_fields) {
+      const ParFiniteElementSpace *src_fes = field.second->ParFESpace();
+      auto it = space_map.find(src_fes);
+      if (it == space_map.end()) {
+         snap->spaces.emplace_back(new ParFiniteElementSpace(snap->mesh.get(), src_fes->FEColl(),
+                                                             src_fes->GetVDim(), src_fes->GetOrdering()));
+         it = space_map.emplace(src_fes, snap->spaces.back().get()).first;
+      }
+      ParGridFunction *gf = new ParGridFunction(it->second);
+      const double* src_data = field.second->HostRead();
+      double* data = gf->HostWrite();
+      std::copy(src_data, src_data + gf->Size(), data);
+      snap->fields[field.first].reset(gf);
+   }
+   snap->mesh->SetComm(io_comm);
+
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      queue.push_back(std::move(snap));
+   }
+   cv_work.notify_one();
+}
+
+void AsyncOutputWriter::Run()
+{
+   while (true) {
+      std::unique_ptr<Snapshot> snap;
+      {
+         std::unique_lock<std::mutex> lock(mtx);
+         cv_work.wait(lock, [this] { return stop || !queue.empty(); });
+         if (queue.empty()) {
+            return;
+         }
+         snap = std::move(queue.front());
+         queue.pop_front();
+         busy = true;
+      }
+
+      for (size_t i = 0; i < dcs.size(); i++) {
+         dcs[i]->SetMesh(snap->mesh.get());
+         for (const auto &name : dc_fields[i]) {
+            dcs[i]->RegisterField(name, snap->fields[name].get());
+         }
+         dcs[i]->SetCycle(snap->cycle);
+         dcs[i]->SetTime(snap->time);
+         dcs[i]->Save();
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(mtx);
+         // The data collections point at this snapshot until the next one is written
+         current = std::move(snap);
+         busy = false;
+      }
+      cv_done.notify_all();
+   }
+}
+
+void AsyncOutputWriter::Flush()
+{
+   CALI_CXX_MARK_SCOPE("async_output_flush");
+   std::unique_lock<std::mutex> lock(mtx);
+   cv_done.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+AsyncOutputWriter::~AsyncOutputWriter()
+{
+   Flush();
+   {
+      std::lock_guard<std::mutex> lock(mtx);
+      stop = true;
+   }
+   cv_work.notify_one();
+   worker.join();
+
+   for (size_t i = 0; i < dcs.size(); i++) {
+      dcs[i]->SetMesh(src_mesh);
+      for (const auto &name : dc_fields[i]) {
+         dcs[i]->RegisterField(name, src_fields[name]);
+      }
+   }
+   current.reset();
+   MPI_Comm_free(&io_comm);
+}
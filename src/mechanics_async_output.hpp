@@ -0,0 +1,88 @@
+#ifndef MECHANICS_ASYNC_OUTPUT
+#define MECHANICS_ASYNC_OUTPUT
+
+#include "mfem.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// Writes out the data collections on a background thread, so the solver can
+/// move on to the next time step while the visualization files are being written.
+///
+/// Each call to Enqueue copies the mesh and all of the fields registered with the
+/// data collections into a snapshot, which is then handed off to the I/O thread.
+/// At most max_queue snapshots can be waiting to be written at any given time, and
+/// Enqueue blocks until there's room for a new one. A max_queue of 1 gives us
+/// the usual double buffering where one snapshot is being written while the
+/// solver works on the next step.
+///
+/// The data collections' MPI calls on the I/O thread happen on their own
+/// duplicate of the mesh's communicator, so MPI needs to provide
+/// MPI_THREAD_MULTIPLE. Once the writer is created the data collections belong
+/// to it and shouldn't be touched until it's destroyed, at which point they
+/// point back at the original mesh and fields.
+class AsyncOutputWriter
+{
+   private:
+      /// A copy of the mesh whose communicator can be swapped out for the I/O
+      /// thread's communicator once all of the snapshot's spaces are created.
+      class SnapshotMesh : public mfem::ParMesh
+      {
+         public:
+            SnapshotMesh(const mfem::ParMesh &pmesh) : mfem::ParMesh(pmesh, true) {}
+            void SetComm(MPI_Comm comm) { MyComm = comm; }
+      };
+
+      struct Snapshot
+      {
+         std::unique_ptr<SnapshotMesh> mesh;
+         std::vector<std::unique_ptr<mfem::ParFiniteElementSpace> > spaces;
+         std::unordered_map<std::string, std::unique_ptr<mfem::ParGridFunction> > fields;
+         int cycle;
+         double time;
+      };
+
+      std::vector<mfem::DataCollection*> dcs;
+      /// The mesh and fields that the data collections were set up with
+      mfem::ParMesh *src_mesh;
+      std::unordered_map<std::string, mfem::ParGridFunction*> src_fields;
+      /// The names of the fields registered with each data collection
+      std::vector<std::vector<std::string> > dc_fields;
+
+      MPI_Comm io_comm;
+      size_t max_queue;
+      std::deque<std::unique_ptr<Snapshot> > queue;
+      /// The last snapshot written, which the data collections still point to
+      std::unique_ptr<Snapshot> current;
+      bool busy = false;
+      bool stop = false;
+      std::mutex mtx;
+      std::condition_variable cv_work;
+      std::condition_variable cv_done;
+      std::thread worker;
+
+      /// The I/O thread's main loop
+      void Run();
+
+   public:
+      AsyncOutputWriter(const std::vector<mfem::DataCollection*> &data_colls, const int max_queue);
+
+      /// Takes a snapshot of the current mesh and fields and queues it up to be
+      /// written with the given cycle and time.
+      void Enqueue(const int cycle, const double time);
+
+      /// Blocks until every queued snapshot has been written.
+      void Flush();
+
+      /// Flushes the queue and hands the data collections back their original
+      /// mesh and fields.
+      ~AsyncOutputWriter();
+};
+
+#endif
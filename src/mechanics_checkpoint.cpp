@@ -0,0 +1,386 @@
+#include "mechanics_checkpoint.hpp"
+#include "mechanics_log.hpp"
+#include "TOML_Reader/toml.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+using namespace mfem;
+
+CheckpointManager::CheckpointManager(ParMesh *_pmesh, const Array<int> &_elem_ids,
+                                     const std::string &_basename, const bool _async)
+   : pmesh(_pmesh), basename(_basename), async(_async), comm(_pmesh->GetComm())
+{
+   MFEM_VERIFY(_elem_ids.Size() == pmesh->GetNE(),
+               "CheckpointManager needs a serial element id for every local element");
+   elem_ids = _elem_ids;
+   MPI_Comm_rank(comm, &myid);
+
+   const int nelems = pmesh->GetNE();
+   elem_order.resize(nelems);
+   std::iota(elem_order.begin(), elem_order.end(), 0);
+   std::sort(elem_order.begin(), elem_order.end(),
+             [this](const int a, const int b) { return elem_ids[a] < elem_ids[b]; });
+   sorted_ids.resize(nelems);
+   for (int i = 0; i < nelems; i++) {
+      sorted_ids[i] = elem_ids[elem_order[i]];
+      MFEM_VERIFY(sorted_ids[i] >= 0 && (i == 0 || sorted_ids[i] > sorted_ids[i - 1]),
+                  "CheckpointManager needs a different serial element id for every local element");
+   }
+}
+
+void CheckpointManager::RegisterField(const std::string &name, QuadratureFunction *qf,
+                                      const int pt_stride, const int var_stride)
+{
+   Field field = { name, qf, nullptr, pt_stride, var_stride, 0 };
+   field.elem_size = ElemSize(field);
+   fields.push_back(field);
+}
+
+void CheckpointManager::RegisterField(const std::string &name, QuadratureFunction *qf)
+{
+   RegisterField(name, qf, qf->GetVDim(), 1);
+}
+
+void CheckpointManager::RegisterField(const std::string &name, ParGridFunction *gf)
+{
+   Field field = { name, nullptr, gf, 0, 0, 0 };
+   field.elem_size = ElemSize(field);
+   fields.push_back(field);
+}
+
+int CheckpointManager::ElemSize(const Field &field) const
+{
+   const int nelems = pmesh->GetNE();
+   if (nelems == 0) {
+      return 0;
+   }
+   int elem_size = 0;
+   if (field.qf) {
+      elem_size = field.qf->Size() / nelems;
+      MFEM_VERIFY(elem_size * nelems == field.qf->Size() && elem_size % field.qf->GetVDim() == 0,
+                  "CheckpointManager needs the same number of quadrature points in every element");
+   }
+   else {
+      const ParFiniteElementSpace *fes = field.gf->ParFESpace();
+      Array<int> vdofs;
+      fes->GetElementVDofs(0, vdofs);
+      elem_size = vdofs.Size();
+      for (int i = 1; i < nelems; i++) {
+         fes->GetElementVDofs(i, vdofs);
+         MFEM_VERIFY(vdofs.Size() == elem_size,
+                     "CheckpointManager needs the same number of dofs in every element");
+      }
+   }
+   return elem_size;
+}
+
+void CheckpointManager::PackField(const Field &field, std::vector<double> &buf) const
+{
+   const int nelems = pmesh->GetNE();
+   buf.resize(nelems * field.elem_size);
+   if (field.qf) {
+      const int vdim = field.qf->GetVDim();
+      const int npts = (vdim > 0) ? field.elem_size / vdim : 0;
+      const double* data = field.qf->HostRead();
+      for (int i = 0; i < nelems; i++) {
+         const int ie = elem_order[i];
+         for (int iq = 0; iq < npts; iq++) {
+            const int ipt = ie * npts + iq;
+            for (int k = 0; k < vdim; k++) {
+               buf[i * field.elem_size + iq * vdim + k] = data[ipt * field.pt_stride + k * field.var_stride];
+            }
+         }
+      }
+   }
+   else {
+      const ParFiniteElementSpace *fes = field.gf->ParFESpace();
+      field.gf->HostRead();
+      Array<int> vdofs;
+      Vector vals;
+      for (int i = 0; i < nelems; i++) {
+         fes->GetElementVDofs(elem_order[i], vdofs);
+         field.gf->GetSubVector(vdofs, vals);
+         std::copy(vals.GetData(), vals.GetData() + field.elem_size, &buf[i * field.elem_size]);
+      }
+   }
+}
+
+void CheckpointManager::UnpackField(Field &field, const std::vector<double> &buf) const
+{
+   const int nelems = pmesh->GetNE();
+   if (field.qf) {
+      const int vdim = field.qf->GetVDim();
+      const int npts = (vdim > 0) ? field.elem_size / vdim : 0;
+      double* data = field.qf->HostReadWrite();
+      for (int i = 0; i < nelems; i++) {
+         const int ie = elem_order[i];
+         for (int iq = 0; iq < npts; iq++) {
+            const int ipt = ie * npts + iq;
+            for (int k = 0; k < vdim; k++) {
+               data[ipt * field.pt_stride + k * field.var_stride] = buf[i * field.elem_size + iq * vdim + k];
+            }
+         }
+      }
+   }
+   else {
+      const ParFiniteElementSpace *fes = field.gf->ParFESpace();
+      field.gf->HostReadWrite();
+      Array<int> vdofs;
+      Vector vals(field.elem_size);
+      for (int i = 0; i < nelems; i++) {
+         fes->GetElementVDofs(elem_order[i], vdofs);
+         std::copy(&buf[i * field.elem_size], &buf[i * field.elem_size] + field.elem_size, vals.GetData());
+         field.gf->SetSubVector(vdofs, vals);
+      }
+   }
+}
+
+void CheckpointManager::SetFileView(MPI_File file, const std::vector<int64_t> &offsets,
+                                    const std::vector<int64_t> &elem_bytes) const
+{
+   // The sections come one after another in the file and our ids are sorted,
+   // so the displacements only ever increase like the file view needs
+   const int nelems = sorted_ids.size();
+   std::vector<int> block_lens;
+   std::vector<MPI_Aint> displs;
+   block_lens.reserve(offsets.size() * nelems);
+   displs.reserve(offsets.size() * nelems);
+   for (size_t j = 0; j < offsets.size(); j++) {
+      for (int i = 0; i < nelems; i++) {
+         block_lens.push_back(elem_bytes[j]);
+         displs.push_back(offsets[j] + sorted_ids[i] * elem_bytes[j]);
+      }
+   }
+
+   MPI_Datatype file_type;
+   MPI_Type_create_hindexed(block_lens.size(), block_lens.data(), displs.data(), MPI_BYTE, &file_type);
+   MPI_Type_commit(&file_type);
+   MPI_File_set_view(file, 0, MPI_BYTE, file_type, "native", MPI_INFO_NULL);
+   // The view holds on to the type for as long as it needs it
+   MPI_Type_free(&file_type);
+}
+
+void CheckpointManager::CreateMemType(const int64_t *ids, std::vector<std::vector<double> > &bufs,
+                                      MPI_Datatype *mem_type) const
+{
+   const int nbufs = bufs.size() + 1;
+   std::vector<int> block_lens(nbufs);
+   std::vector<MPI_Aint> addrs(nbufs);
+   std::vector<MPI_Datatype> types(nbufs, MPI_DOUBLE);
+   block_lens[0] = sorted_ids.size();
+   types[0] = MPI_INT64_T;
+   MPI_Get_address(const_cast<int64_t*>(ids), &addrs[0]);
+   for (size_t j = 0; j < bufs.size(); j++) {
+      block_lens[j + 1] = bufs[j].size();
+      MPI_Get_address(bufs[j].data(), &addrs[j + 1]);
+   }
+   MPI_Type_create_struct(nbufs, block_lens.data(), addrs.data(), types.data(), mem_type);
+   MPI_Type_commit(mem_type);
+}
+
+void CheckpointManager::Save(const int step, const std::map<std::string, double> &state)
+{
+   // Only one checkpoint is ever in flight
+   Finish();
+   CALI_CXX_MARK_SCOPE("checkpoint_save");
+
+   const int nelems = pmesh->GetNE();
+   int64_t nelems_local = nelems;
+   int64_t nelems_global = 0;
+   MPI_Allreduce(&nelems_local, &nelems_global, 1, MPI_INT64_T, MPI_SUM, comm);
+
+   // Processes without any elements don't know the element sizes
+   std::vector<int> elem_sizes(fields.size());
+   for (size_t j = 0; j < fields.size(); j++) {
+      elem_sizes[j] = fields[j].elem_size;
+   }
+   MPI_Allreduce(MPI_IN_PLACE, elem_sizes.data(), elem_sizes.size(), MPI_INT, MPI_MAX, comm);
+   for (size_t j = 0; j < fields.size(); j++) {
+      fields[j].elem_size = elem_sizes[j];
+   }
+
+   data_bufs.resize(fields.size());
+   for (size_t j = 0; j < fields.size(); j++) {
+      PackField(fields[j], data_bufs[j]);
+   }
+
+   const std::string fname = basename + "." + std::to_string(step) + ".bin";
+   int err = MPI_File_open(comm, fname.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+   if (err != MPI_SUCCESS) {
+      MFEM_ABORT("Cannot open the checkpoint file: " << fname);
+   }
+
+   int64_t total_size = sizeof(int64_t) * nelems_global;
+   for (const auto &field : fields) {
+      total_size += sizeof(double) * nelems_global * field.elem_size;
+   }
+   // Gets rid of anything left over from an older file of the same name
+   MPI_File_set_size(fh, total_size);
+
+   std::ostringstream manifest;
+   manifest << std::setprecision(17) << std::scientific;
+   manifest << "# ExaConstit checkpoint manifest\n";
+   manifest << "version = 2\n";
+   manifest << "data_file = \"" << fname.substr(fname.find_last_of('/') + 1) << "\"\n";
+   manifest << "step = " << step << "\n";
+   int nprocs;
+   MPI_Comm_size(comm, &nprocs);
+   manifest << "nprocs = " << nprocs << "\n";
+   manifest << "nelems = " << nelems_global << "\n";
+
+   std::vector<int64_t> offsets(1, 0);
+   std::vector<int64_t> elem_bytes(1, sizeof(int64_t));
+   int64_t offset = sizeof(int64_t) * nelems_global;
+   std::ostringstream manifest_fields;
+   for (size_t j = 0; j < fields.size(); j++) {
+      const int elem_size = fields[j].elem_size;
+      offsets.push_back(offset);
+      elem_bytes.push_back(sizeof(double) * elem_size);
+      manifest_fields << "\n[[Fields]]\n";
+      manifest_fields << "name = \"" << fields[j].name << "\"\n";
+      manifest_fields << "elem_size = " << elem_size << "\n";
+      manifest_fields << "offset = " << offset << "\n";
+      offset += sizeof(double) * nelems_global * elem_size;
+   }
+
+   // Every element goes straight to its serial id's slot in each section
+   SetFileView(fh, offsets, elem_bytes);
+   MPI_Datatype mem_type;
+   CreateMemType(sorted_ids.data(), data_bufs, &mem_type);
+   MPI_File_iwrite_all(fh, MPI_BOTTOM, 1, mem_type, &req);
+   MPI_Type_free(&mem_type);
+
+   manifest << "\n[State]\n";
+   for (const auto &value : state) {
+      manifest << value.first << " = " << value.second << "\n";
+   }
+   manifest << manifest_fields.str();
+
+   pending_manifest = manifest.str();
+   pending_manifest_fname = basename + "." + std::to_string(step) + ".toml";
+   pending = true;
+
+   if (!async) {
+      Finish();
+   }
+}
+
+void CheckpointManager::Finish()
+{
+   if (!pending) {
+      return;
+   }
+   CALI_CXX_MARK_SCOPE("checkpoint_finish");
+   MPI_Wait(&req, MPI_STATUS_IGNORE);
+   // Closing the file is collective, so every process's data is out once it returns
+   MPI_File_close(&fh);
+   if (myid == 0) {
+      // The manifest is moved into place in one go, so a partially written one
+      // is never left behind
+      const std::string tmp_fname = pending_manifest_fname + ".tmp";
+      {
+         std::ofstream file(tmp_fname, std::ios_base::out | std::ios_base::trunc);
+         if (!file) {
+            MFEM_ABORT("Cannot open the checkpoint manifest file: " << tmp_fname);
+         }
+         file << pending_manifest;
+      }
+      if (std::rename(tmp_fname.c_str(), pending_manifest_fname.c_str()) != 0) {
+         MFEM_ABORT("Cannot move the checkpoint manifest file " << tmp_fname << " to "
+                    << pending_manifest_fname << ": " << std::strerror(errno));
+      }
+   }
+   pending = false;
+}
+
+void CheckpointManager::Load(const std::string &manifest_fname, std::map<std::string, double> &state)
+{
+   CALI_CXX_MARK_SCOPE("checkpoint_load");
+   const auto data = toml::parse(manifest_fname);
+   const int version = toml::find<int>(data, "version");
+   MFEM_VERIFY(version == 2, "Unknown checkpoint manifest version in " << manifest_fname);
+
+   // The data file lives next to the manifest
+   std::string data_fname = toml::find<std::string>(data, "data_file");
+   const size_t dir_end = manifest_fname.find_last_of('/');
+   if (dir_end != std::string::npos) {
+      data_fname = manifest_fname.substr(0, dir_end + 1) + data_fname;
+   }
+
+   const int64_t nelems_file = toml::find<int64_t>(data, "nelems");
+   const int nprocs_file = toml::find<int>(data, "nprocs");
+   const int nelems = pmesh->GetNE();
+   int64_t nelems_local = nelems;
+   int64_t nelems_global = 0;
+   MPI_Allreduce(&nelems_local, &nelems_global, 1, MPI_INT64_T, MPI_SUM, comm);
+   MFEM_VERIFY(nelems_file == nelems_global,
+               "The checkpoint's number of elements doesn't match the mesh's number of elements");
+   int nprocs;
+   MPI_Comm_size(comm, &nprocs);
+
+   state.clear();
+   for (const auto &value : toml::find(data, "State").as_table()) {
+      state[value.first] = toml::get<double>(value.second);
+   }
+
+   MPI_File fh_read;
+   int err = MPI_File_open(comm, data_fname.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh_read);
+   if (err != MPI_SUCCESS) {
+      MFEM_ABORT("Cannot open the checkpoint file: " << data_fname);
+   }
+
+   std::map<std::string, std::pair<int, int64_t> > file_fields;
+   for (const auto &table : toml::find<std::vector<toml::value> >(data, "Fields")) {
+      file_fields[toml::find<std::string>(table, "name")] =
+         std::make_pair(toml::find<int>(table, "elem_size"), toml::find<int64_t>(table, "offset"));
+   }
+
+   std::vector<int64_t> offsets(1, 0);
+   std::vector<int64_t> elem_bytes(1, sizeof(int64_t));
+   std::vector<std::vector<double> > bufs(fields.size());
+   for (size_t j = 0; j < fields.size(); j++) {
+      const Field &field = fields[j];
+      const auto file_field = file_fields.find(field.name);
+      MFEM_VERIFY(file_field != file_fields.end(), "The checkpoint is missing the field " << field.name);
+      const int elem_size = field.elem_size;
+      // Elements with the same number of values on different partitions only
+      // line up if their dofs are ordered the same way
+      MFEM_VERIFY(file_field->second.first == elem_size || nelems == 0,
+                  "The checkpoint field " << field.name << " has a different size than expected");
+      MFEM_VERIFY(!field.gf || nprocs_file == nprocs || field.gf->ParFESpace()->GetOrder(0) <= 2,
+                  "Checkpoints can only be read in on a different number of processes for orders up to 2");
+      offsets.push_back(file_field->second.second);
+      elem_bytes.push_back(sizeof(double) * file_field->second.first);
+      bufs[j].resize(nelems * elem_size);
+   }
+
+   // Our elements are read straight from their serial id's slots, so nothing
+   // else in the file is ever touched
+   std::vector<int64_t> file_ids(nelems);
+   SetFileView(fh_read, offsets, elem_bytes);
+   MPI_Datatype mem_type;
+   CreateMemType(file_ids.data(), bufs, &mem_type);
+   MPI_File_read_all(fh_read, MPI_BOTTOM, 1, mem_type, MPI_STATUS_IGNORE);
+   MPI_Type_free(&mem_type);
+
+   for (int i = 0; i < nelems; i++) {
+      MFEM_VERIFY(file_ids[i] == sorted_ids[i], "The checkpoint file's element ids don't match the mesh's");
+   }
+   for (size_t j = 0; j < fields.size(); j++) {
+      UnpackField(fields[j], bufs[j]);
+   }
+
+   MPI_File_close(&fh_read);
+}
+
+CheckpointManager::~CheckpointManager()
+{
+   Finish();
+}
@@ -0,0 +1,119 @@
+#ifndef MECHANICS_CHECKPOINT
+#define MECHANICS_CHECKPOINT
+
+#include "mfem.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/// Writes out checkpoints of the simulation state, and reads them back in to
+/// restart a simulation.
+///
+/// Each checkpoint is a single binary file, basename.<step>.bin, that all of the
+/// processes write their part of through MPI-IO along with a small TOML manifest,
+/// basename.<step>.toml, that describes the file and holds the scalar state (time,
+/// dt, step, ...). The manifest is only written once the binary file is complete,
+/// so it's what a restart should be pointed at.
+///
+/// The registered fields are stored element by element in the order of the
+/// serial mesh element ids provided, so the file doesn't depend on how the mesh
+/// was partitioned. Every process writes and reads its elements straight from
+/// their slots in the file through an indexed MPI-IO file view, which means no
+/// process ever needs anything more than its own elements. So, a checkpoint can
+/// be read back in on a different number of processes as long as the same serial
+/// mesh is partitioned. The binary file is laid out as follows in native byte order:
+///    int64 serial_elem_ids[nelems]
+///    for each field: double data[nelems][elem_size]
+/// where the element with serial id i is at index i of every section. The id
+/// section is only there as a check that the file was written out the way it's
+/// read back in. Each field's elem_size and byte offset are given in the manifest.
+///
+/// The checkpoint data is packed into buffers when Save is called and written
+/// out with a non-blocking collective MPI-IO write, so the time step loop can move
+/// on. The write is finished off at the next Save or Finish call.
+class CheckpointManager
+{
+   private:
+      /// A quadrature function or grid function saved in the checkpoints
+      struct Field {
+         std::string name;
+         mfem::QuadratureFunction *qf;
+         mfem::ParGridFunction *gf;
+         /// Where the value k of quadrature point i lives for quadrature functions
+         int pt_stride;
+         int var_stride;
+         int elem_size;
+      };
+
+      mfem::ParMesh *pmesh;
+      mfem::Array<int> elem_ids;
+      /// Our local elements sorted by their serial element ids, since MPI-IO file
+      /// views need increasing offsets. The packed buffers use this order.
+      std::vector<int> elem_order;
+      std::vector<int64_t> sorted_ids;
+      std::string basename;
+      bool async;
+
+      MPI_Comm comm;
+      int myid;
+
+      std::vector<Field> fields;
+
+      /// The state of the checkpoint that is currently being written
+      MPI_File fh;
+      MPI_Request req;
+      std::vector<std::vector<double> > data_bufs;
+      std::string pending_manifest;
+      std::string pending_manifest_fname;
+      bool pending = false;
+
+      /// Number of values per element of a field, which needs to be the same for
+      /// every element
+      int ElemSize(const Field &field) const;
+      /// Packs the values of the local elements of a field element by element
+      /// in the elem_order order
+      void PackField(const Field &field, std::vector<double> &buf) const;
+      /// Unpacks values packed element by element in the elem_order order into a field
+      void UnpackField(Field &field, const std::vector<double> &buf) const;
+      /// Sets the file view to our elements' slots in each of the sections of the
+      /// file, which start at the byte offsets given with elem_bytes bytes per element
+      void SetFileView(MPI_File file, const std::vector<int64_t> &offsets,
+                       const std::vector<int64_t> &elem_bytes) const;
+      /// Creates the memory datatype that lines up with the file view from the ids
+      /// of our elements and the field buffers, which is used with MPI_BOTTOM
+      void CreateMemType(const int64_t *ids, std::vector<std::vector<double> > &bufs,
+                         MPI_Datatype *mem_type) const;
+
+   public:
+      /// The serial mesh element id of each of our local elements needs to be
+      /// provided in _elem_ids. If _async is false the checkpoint file is completely
+      /// written before Save returns.
+      CheckpointManager(mfem::ParMesh *_pmesh, const mfem::Array<int> &_elem_ids,
+                        const std::string &_basename, const bool _async);
+
+      /// Adds a quadrature function to the checkpoints. The value k of quadrature
+      /// point i is expected at i * pt_stride + k * var_stride.
+      void RegisterField(const std::string &name, mfem::QuadratureFunction *qf,
+                         const int pt_stride, const int var_stride);
+      /// Adds a quadrature function stored as all of the values of a point together
+      void RegisterField(const std::string &name, mfem::QuadratureFunction *qf);
+      /// Adds a grid function to the checkpoints, which is saved through the
+      /// values of each element's vdofs.
+      void RegisterField(const std::string &name, mfem::ParGridFunction *gf);
+
+      /// Saves all of the registered fields and the scalar state values
+      void Save(const int step, const std::map<std::string, double> &state);
+
+      /// Finishes writing out the last checkpoint if it's still in progress
+      void Finish();
+
+      /// Reads in all of the registered fields from the checkpoint described by
+      /// the manifest file, and returns its scalar state values
+      void Load(const std::string &manifest_fname, std::map<std::string, double> &state);
+
+      ~CheckpointManager();
+};
+
+#endif
@@ -57,11 +57,16 @@
 #include "mfem/general/forall.hpp"
 #include "mechanics_log.hpp"
 #include "system_driver.hpp"
+#include "mechanics_async_output.hpp"
+#include "mechanics_io_aggregator.hpp"
+#include "mechanics_checkpoint.hpp"
 #include "BCData.hpp"
 #include "BCManager.hpp"
 #include "option_parser.hpp"
+#include <map>
 #include <string>
 #include <sstream>
+#include <sys/resource.h>
 
 using namespace std;
 using namespace mfem;
@@ -109,6 +114,16 @@ void reorderMeshElements(Mesh *mesh, const int *nxyz);
 // This also assumes the GridFunction is an L2 FE space
 void projectElemAttr2GridFunc(Mesh *mesh, ParGridFunction *elem_attr);
 
+// partition the serial mesh into nparts pieces of roughly equal total element
+// weight by cutting up a space filling curve through the elements
+void weightedPartitioning(Mesh *mesh, const Vector &weights, const int nparts,
+                          Array<int> &partition);
+
+// gathers the per-element material cost onto rank 0 in the serial mesh element
+// ordering and writes it out, along with printing the process load imbalance
+void writeElementCosts(const Vector &elem_cost, const Array<int> &serial_elem_ids,
+                       const int nelems_serial, const std::string &fname, const int step);
+
 int main(int argc, char *argv[])
 {
    CALI_INIT
@@ -116,7 +131,21 @@ int main(int argc, char *argv[])
    CALI_MARK_BEGIN("main_driver_init");
    // Initialize MPI.
    int num_procs, myid;
-   MPI_Init(&argc, &argv);
+   // Only the asynchronous visualization output makes MPI calls from a thread
+   // other than the main one, so MPI_THREAD_MULTIPLE is only asked for when it's
+   // turned on, since it can be slower or unavailable. MPI is initialized before
+   // the options are parsed, so the option file is checked for it up front.
+   std::string opt_file = "options.toml";
+   for (int i = 1; i < argc - 1; i++) {
+      const std::string arg = argv[i];
+      if (arg == "-opt" || arg == "--option") {
+         opt_file = argv[i + 1];
+      }
+   }
+   const int mpi_thread_req = async_output_requested(opt_file) ? MPI_THREAD_MULTIPLE
+                                                               : MPI_THREAD_FUNNELED;
+   int mpi_thread_level;
+   MPI_Init_thread(&argc, &argv, mpi_thread_req, &mpi_thread_level);
    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 // Used to scope the main program away from the main MPI Init and Finalize calls
@@ -153,6 +182,14 @@ int main(int argc, char *argv[])
    ExaOptions toml_opt(toml_file);
    toml_opt.parse_options(myid);
 
+   if (toml_opt.vis_async && mpi_thread_level < MPI_THREAD_MULTIPLE) {
+      if (myid == 0) {
+         std::cout << "MPI_THREAD_MULTIPLE isn't supported so the visualization files "
+                   << "will be written without the background thread" << std::endl;
+      }
+      toml_opt.vis_async = false;
+   }
+
    // Set the device info here:
    // Enable hardware devices such as GPUs, and programming models such as
    // CUDA, OCCA, RAJA and OpenMP based on command line options.
@@ -220,6 +257,10 @@ int main(int argc, char *argv[])
    }
    // declare pointer to parallel mesh object
    ParMesh *pmesh = NULL;
+   // serial mesh element ids of our local elements, which are only set if
+   // we're using the element material cost output or the checkpoints
+   Array<int> serial_elem_ids;
+   int nelems_serial = 0;
    {
       Mesh mesh;
       Vector g_map;
@@ -296,7 +337,39 @@ int main(int argc, char *argv[])
          mesh.UniformRefinement();
       }
 
-      pmesh = new ParMesh(MPI_COMM_WORLD, mesh);
+      // The partitioning is only generated here if we need to know which serial
+      // elements end up on each process. Otherwise, ParMesh takes care of it.
+      Array<int> partition;
+      nelems_serial = mesh.GetNE();
+      if (toml_opt.part_weights_file != "") {
+         ifstream iweights(toml_opt.part_weights_file.c_str());
+         if (!iweights && myid == 0) {
+            cerr << "\nCannot open partition weights file: " << toml_opt.part_weights_file << '\n' << endl;
+         }
+         Vector weights;
+         weights.Load(iweights, nelems_serial);
+         iweights.close();
+         weightedPartitioning(&mesh, weights, num_procs, partition);
+      }
+      else if (toml_opt.part_cost_steps > 0 || toml_opt.chkpt_steps > 0 || toml_opt.restart_file != "") {
+         int* part = mesh.GeneratePartitioning(num_procs);
+         partition.SetSize(nelems_serial);
+         partition.Assign(part);
+         delete[] part;
+      }
+
+      if (partition.Size() > 0) {
+         // ParMesh keeps the serial ordering of the elements it owns
+         for (int i = 0; i < nelems_serial; i++) {
+            if (partition[i] == myid) {
+               serial_elem_ids.Append(i);
+            }
+         }
+         pmesh = new ParMesh(MPI_COMM_WORLD, mesh, partition.GetData());
+      }
+      else {
+         pmesh = new ParMesh(MPI_COMM_WORLD, mesh);
+      }
       for (int lev = 0; lev < toml_opt.par_ref_levels; lev++) {
          pmesh->UniformRefinement();
       }
@@ -594,7 +667,35 @@ int main(int argc, char *argv[])
                      kinVars0, q_vonMises, &elemMatVars, x_ref, x_beg, x_cur,
                      matProps, matVarsOffset);
 
-   if (toml_opt.visit || toml_opt.conduit || toml_opt.paraview || toml_opt.adios2) {
+   // The checkpoints need to know which serial mesh element each of our elements is,
+   // so they can be read back in on a different partitioning of the mesh.
+   std::unique_ptr<CheckpointManager> chkpt;
+   std::map<std::string, double> restart_state;
+   int start_step = 0;
+   if (toml_opt.chkpt_steps > 0 || toml_opt.restart_file != "") {
+      chkpt.reset(new CheckpointManager(pmesh, serial_elem_ids, toml_opt.chkpt_basename, toml_opt.chkpt_async));
+      oper.RegisterCheckpointFields(*chkpt);
+      chkpt->RegisterField("x_ref", &x_ref);
+      chkpt->RegisterField("x_beg", &x_beg);
+      chkpt->RegisterField("x_cur", &x_cur);
+      chkpt->RegisterField("velocity", &v_cur);
+
+      if (toml_opt.restart_file != "") {
+         if (myid == 0) {
+            printf("Restarting from checkpoint %s \n", toml_opt.restart_file.c_str());
+         }
+         chkpt->Load(toml_opt.restart_file, restart_state);
+         start_step = static_cast<int>(restart_state.at("step"));
+         oper.SetCheckpointState(restart_state);
+         // The boundary conditions need to be the ones that were active at the checkpoint
+         BCManager::getInstance().setStep(static_cast<int>(restart_state.at("bc_step")));
+         oper.UpdateEssBdr();
+         subtract(x_cur, x_ref, x_diff);
+      }
+   }
+
+   if (toml_opt.visit || toml_opt.conduit || toml_opt.paraview || toml_opt.adios2 ||
+       toml_opt.vis_aggregate) {
       oper.ProjectVolume(volume);
    }
    if (myid == 0) {
@@ -608,6 +709,9 @@ int main(int argc, char *argv[])
    Vector v_sol(fe_space.TrueVSize()); v_sol.UseDevice(true);
    Vector v_prev(fe_space.TrueVSize()); v_prev.UseDevice(true);// this sizing is correct
    v_sol = 0.0;
+   if (start_step > 0) {
+      v_cur.GetTrueDofs(v_sol);
+   }
 
    // Save data for VisIt visualization.
    // The below is used to take advantage of mfem's custom Visit plugin
@@ -802,12 +906,55 @@ int main(int argc, char *argv[])
       }
    }
 #endif
+   // The visit, paraview, and conduit files can be written on a background thread
+   std::unique_ptr<AsyncOutputWriter> async_writer;
+   if (toml_opt.vis_async) {
+      std::vector<DataCollection*> async_dcs;
+      if (toml_opt.visit) {
+         async_dcs.push_back(&visit_dc);
+      }
+      if (toml_opt.paraview) {
+         async_dcs.push_back(&paraview_dc);
+      }
+#ifdef MFEM_USE_CONDUIT
+      if (toml_opt.conduit) {
+         async_dcs.push_back(&conduit_dc);
+      }
+#endif
+      if (async_dcs.size() > 0) {
+         async_writer.reset(new AsyncOutputWriter(async_dcs, toml_opt.vis_async_queue));
+      }
+   }
+   // The element fields can also be written out through aggregator processes
+   std::unique_ptr<ElemFieldAggregator> elem_aggregator;
+   if (toml_opt.vis_aggregate) {
+      elem_aggregator.reset(new ElemFieldAggregator(pmesh, toml_opt.basename, toml_opt.vis_agg_group_size));
+      elem_aggregator->RegisterField("ElementVolume", &volume);
+      elem_aggregator->RegisterField("Stress", &stress);
+      elem_aggregator->RegisterField("VonMisesStress", &vonMises);
+      elem_aggregator->RegisterField("HydrostaticStress", &hydroStress);
+      if (toml_opt.mech_type == MechType::EXACMECH) {
+         if (toml_opt.light_up) {
+            elem_aggregator->RegisterField("ElemCentroid", elem_centroid);
+            elem_aggregator->RegisterField("XtalElasticStrain", elastic_strain);
+         }
+         elem_aggregator->RegisterField("DpEff", &dpeff);
+         elem_aggregator->RegisterField("EffPlasticStrain", &pleff);
+         elem_aggregator->RegisterField("LatticeOrientation", &quats);
+         elem_aggregator->RegisterField("ShearRate", &gdots);
+         elem_aggregator->RegisterField("Hardness", &hardness);
+      }
+   }
+
    if (myid == 0) {
       printf("after visualization if-block \n");
    }
    CALI_MARK_END("main_vis_init");
    // initialize/set the time
    double t = 0.0;
+   if (start_step > 0) {
+      t = restart_state.at("time");
+   }
    oper.SetTime(t);
 
    bool last_step = false;
@@ -821,7 +968,7 @@ int main(int argc, char *argv[])
 
    double dt_real;
 
-   for (int ti = 1; ti <= toml_opt.nsteps; ti++) {
+   for (int ti = start_step + 1; ti <= toml_opt.nsteps; ti++) {
       if (myid == 0) {
          printf("inside timestep loop %d \n", ti);
       }
@@ -893,12 +1040,32 @@ int main(int argc, char *argv[])
       // Update our beginning time step coords with our end time step coords
       x_beg = x_cur;
 
+      // Everything is now set up for the next step, so this is where the simulation
+      // picks back up from on a restart
+      if (toml_opt.chkpt_steps > 0 && !last_step && (ti % toml_opt.chkpt_steps) == 0) {
+         std::map<std::string, double> state;
+         oper.GetCheckpointState(state);
+         state["step"] = ti;
+         state["time"] = t;
+         state["dt"] = dt_real;
+         state["bc_step"] = BCManager::getInstance().getStep();
+         chkpt->Save(ti, state);
+      }
+
+      if (toml_opt.part_cost_steps > 0 && (last_step || (ti % toml_opt.part_cost_steps) == 0)) {
+         CALI_CXX_MARK_SCOPE("main_elem_costs");
+         Vector elem_cost;
+         oper.CalcElementCosts(elem_cost);
+         writeElementCosts(elem_cost, serial_elem_ids, nelems_serial, toml_opt.part_cost_file, ti);
+      }
+
       if (last_step || (ti % toml_opt.vis_steps) == 0) {
          if (myid == 0) {
             cout << "step " << ti << ", t = " << t << endl;
          }
          CALI_MARK_BEGIN("main_vis_update");
-         if (toml_opt.visit || toml_opt.conduit || toml_opt.paraview || toml_opt.adios2) {
+         if (toml_opt.visit || toml_opt.conduit || toml_opt.paraview || toml_opt.adios2 ||
+             toml_opt.vis_aggregate) {
             // mesh and stress output. Consider moving this to a separate routine
             // We might not want to update the vonMises stuff
             oper.ProjectModelStress(stress);
@@ -919,20 +1086,26 @@ int main(int argc, char *argv[])
             }
          }
 
-         if (toml_opt.visit) {
+         if (elem_aggregator) {
+            elem_aggregator->Save(ti, t);
+         }
+         if (async_writer) {
+            async_writer->Enqueue(ti, t);
+         }
+         if (toml_opt.visit && !async_writer) {
             visit_dc.SetCycle(ti);
             visit_dc.SetTime(t);
             // Our visit data is now saved off
             visit_dc.Save();
          }
-         if (toml_opt.paraview) {
+         if (toml_opt.paraview && !async_writer) {
             paraview_dc.SetCycle(ti);
             paraview_dc.SetTime(t);
             // Our paraview data is now saved off
             paraview_dc.Save();
          }
 #ifdef MFEM_USE_CONDUIT
-         if (toml_opt.conduit) {
+         if (toml_opt.conduit && !async_writer) {
             conduit_dc.SetCycle(ti);
             conduit_dc.SetTime(t);
             // Our conduit data is now saved off
@@ -954,6 +1127,16 @@ int main(int argc, char *argv[])
       }
    } // end loop over time steps
 
+   // Make sure everything has been written out before the mesh goes away
+   async_writer.reset();
+   elem_aggregator.reset();
+   chkpt.reset();
+
+   if (toml_opt.mech_type == MechType::EXACMECH && toml_opt.ecmech_chunk_size > 0 &&
+       toml_opt.rtmodel == RTModel::OPENMP) {
+      oper.PrintKernelThreadImbalance();
+   }
+
    // Free the used memory.
    delete pmesh;
    // Now find out how long everything took to run roughly
@@ -989,6 +1172,20 @@ int main(int argc, char *argv[])
       printf("The process took %lf seconds to run\n", (avg_sim_time / world_size));
    }
 
+   // The peak resident memory of the largest process, which is handy for
+   // checking the effect of the different state variable storage options
+   {
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      // ru_maxrss is given in kilobytes on Linux
+      long max_rss = usage.ru_maxrss;
+      long max_rss_global;
+      MPI_Reduce(&max_rss, &max_rss_global, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+      if (myid == 0) {
+         printf("The peak resident memory of a process was %lf MB\n", max_rss_global / 1024.0);
+      }
+   }
+
    if(toml_opt.light_up) {
       delete elem_centroid;
       delete elastic_strain;
@@ -1276,3 +1473,92 @@ void projectElemAttr2GridFunc(Mesh *mesh, ParGridFunction *elem_attr) {
       elem_attr->SetSubVector(vdofs, ea);
    }
 }
+
+void weightedPartitioning(Mesh *mesh, const Vector &weights, const int nparts,
+                          Array<int> &partition)
+{
+   const int nelems = mesh->GetNE();
+   MFEM_VERIFY(nelems >= nparts, "weightedPartitioning needs at least one element per process");
+
+   // ordering[i] is the location of element i along the Hilbert curve
+   Array<int> ordering;
+   mesh->GetHilbertElementOrdering(ordering);
+   Array<int> curve(nelems);
+   for (int i = 0; i < nelems; i++) {
+      curve[ordering[i]] = i;
+   }
+
+   const double* wts = weights.HostRead();
+   double total = 0.0;
+   for (int i = 0; i < nelems; i++) {
+      MFEM_VERIFY(wts[i] >= 0.0, "Partition weights can not be negative");
+      total += wts[i];
+   }
+   MFEM_VERIFY(total > 0.0, "Partition weights need to sum to a positive value");
+
+   // Each element goes to the part that the middle of its weight falls in along
+   // the curve. The parts are kept contiguous and non-empty.
+   partition.SetSize(nelems);
+   double running = 0.0;
+   int prev = -1;
+   for (int i = 0; i < nelems; i++) {
+      const int ie = curve[i];
+      int part = static_cast<int>(nparts * (running + 0.5 * wts[ie]) / total);
+      part = std::min(part, prev + 1);
+      part = std::max(part, std::max(prev, nparts - (nelems - i)));
+      partition[ie] = part;
+      prev = part;
+      running += wts[ie];
+   }
+}
+
+void writeElementCosts(const Vector &elem_cost, const Array<int> &serial_elem_ids,
+                       const int nelems_serial, const std::string &fname, const int step)
+{
+   int num_procs, myid;
+   MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+   MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+   const int nelems = elem_cost.Size();
+   MFEM_VERIFY(serial_elem_ids.Size() == nelems, "writeElementCosts needs the serial element ids");
+   const double* cost = elem_cost.HostRead();
+
+   double local_cost = 0.0;
+   for (int i = 0; i < nelems; i++) {
+      local_cost += cost[i];
+   }
+   double max_cost, total_cost;
+   MPI_Reduce(&local_cost, &max_cost, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+   MPI_Reduce(&local_cost, &total_cost, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+   Array<int> counts(num_procs), displs(num_procs);
+   MPI_Gather(&nelems, 1, MPI_INT, counts.GetData(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+   Array<int> ids;
+   Vector costs;
+   if (myid == 0) {
+      displs[0] = 0;
+      for (int i = 1; i < num_procs; i++) {
+         displs[i] = displs[i - 1] + counts[i - 1];
+      }
+      ids.SetSize(nelems_serial);
+      costs.SetSize(nelems_serial);
+   }
+   MPI_Gatherv(serial_elem_ids.GetData(), nelems, MPI_INT, ids.GetData(), counts.GetData(),
+               displs.GetData(), MPI_INT, 0, MPI_COMM_WORLD);
+   MPI_Gatherv(cost, nelems, MPI_DOUBLE, costs.HostWrite(), counts.GetData(),
+               displs.GetData(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+   if (myid == 0) {
+      const double imbalance = max_cost * num_procs / total_cost;
+      std::cout << "Material cost load imbalance (max / mean process cost) at step "
+                << step << ": " << imbalance << std::endl;
+
+      Vector serial_cost(nelems_serial);
+      for (int i = 0; i < nelems_serial; i++) {
+         serial_cost[ids[i]] = costs[i];
+      }
+      std::ofstream file(fname);
+      file.precision(8);
+      serial_cost.Print(file, 1);
+   }
+}
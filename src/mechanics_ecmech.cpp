@@ -11,6 +11,9 @@
 #include <iostream> // cerr
 #include "RAJA/RAJA.hpp"
 #include "mechanics_kernels.hpp"
+#if defined(RAJA_ENABLE_OPENMP)
+#include <omp.h>
+#endif
 
 using namespace mfem;
 using namespace std;
@@ -18,126 +21,206 @@ using namespace ecmech;
 
 namespace {
 
+// Copies a point's stored state variables over to the double precision and
+// contiguous layout ExaCMech expects. The num_reduced state variables starting at
+// ind_reduced are stored as packed floats, and the ones after them are shifted down.
+MFEM_HOST_DEVICE inline
+void gather_state_vars(const int nstatev, const int var_stride, const int ind_reduced,
+                       const int num_reduced, const double* state_vars, double* batch_state_vars)
+{
+   const int shift_reduced = (num_reduced + 1) / 2 - num_reduced;
+   for (int i = 0; i < ind_reduced; i++) {
+      batch_state_vars[i] = state_vars[i * var_stride];
+   }
+   if (num_reduced > 0) {
+      const float* reduced = reinterpret_cast<const float*>(&(state_vars[ind_reduced]));
+      for (int i = 0; i < num_reduced; i++) {
+         batch_state_vars[ind_reduced + i] = reduced[i];
+      }
+   }
+   for (int i = ind_reduced + num_reduced; i < nstatev; i++) {
+      batch_state_vars[i] = state_vars[(i + shift_reduced) * var_stride];
+   }
+}
+
+// Converts the Voigt notation stress over to the 6-vec deviatoric + pressure form
+MFEM_HOST_DEVICE inline
+void stress_to_svec_p(const double* stress, double* stress_svec_p)
+{
+   for (int i = 0; i < ecmech::nsvec; i++) {
+      stress_svec_p[i] = stress[i];
+   }
+
+   double stress_mean = -ecmech::onethird * (stress[0] + stress[1] + stress[2]);
+   stress_svec_p[0] += stress_mean;
+   stress_svec_p[1] += stress_mean;
+   stress_svec_p[2] += stress_mean;
+   stress_svec_p[ecmech::iSvecP] = stress_mean;
+}
+
 // Sets-up everything for the kernel
-void kernel_setup(const int npts, const int nstatev,
-                  const double dt, const double temp_k, const double* vel_grad_array,
-                  const double* stress_array, const double* state_vars_array,
+// The velocity gradient is calculated per point from the element velocities and
+// is only ever held in registers, so there's no need for an npts-sized scratch array.
+// The kernel inputs are placed in the first npts_batch entries of the scratch arrays,
+// and the beginning step state variables of those points are gathered into
+// batch_state_vars_array. ExaCMech updates them in place, so when nothing is compacted
+// batch_state_vars_array is just the end step state variables, and otherwise the
+// post-processing scatters the batch out to them. Either way, there's no separate
+// pass copying the beginning step stress and state variables over to the end step.
+// If pts_index is provided then only those points are set-up, and otherwise it's
+// the npts_batch points starting at pts_offset.
+// The state variable k of point i is at state_vars_array[i * pt_stride + k * var_stride],
+// while the batch is always laid out the way ExaCMech expects with the state variables
+// of a point being contiguous. The num_reduced state variables starting at ind_reduced
+// are stored as packed floats, and they're converted back to doubles in the batch.
+void kernel_setup(const int nqpts, const int npts_batch, const int nnodes, const int nstatev,
+                  const double dt, const double temp_k, const int* pts_index,
+                  const int pts_offset, const int pt_stride, const int var_stride,
+                  const int ind_reduced, const int num_reduced,
+                  const double* jacobian_array,
+                  const double* loc_grad_array, const double* vel_array,
+                  const double* stress_beg_array, const double* state_vars_beg_array,
+                  double* batch_state_vars_array,
                   double* stress_svec_p_array, double* d_svec_p_array,
                   double* w_vec_array, double* vol_ratio_array,
-                  double* eng_int_array, double* tempk_array, double* dEff)
+                  double* tempk_array)
 {
-   // vgrad is kinda a pain to deal with as a raw 1d array, so we're
-   // going to just use a RAJA view here. The data is taken to be in col. major format.
-   // It might be nice to eventually create a type alias for the below or
-   // maybe something like it.
-
    const int ind_int_eng = nstatev - ecmech::ne;
    const int ind_vols = ind_int_eng - 1;
+   const bool has_index = (pts_index != nullptr);
+   // Shift of the state variables after the single precision block
+   const int ind_end_reduced = ind_reduced + num_reduced;
+   const int shift_reduced = (num_reduced + 1) / 2 - num_reduced;
+   const int ind_vols_stored = (ind_vols >= ind_end_reduced) ? ind_vols + shift_reduced : ind_vols;
 
-   const int DIM = 3;
-   std::array<RAJA::idx_t, DIM> perm {{ 2, 1, 0 } };
-   RAJA::Layout<DIM> layout = RAJA::make_permuted_layout({{ ecmech::ndim, ecmech::ndim, npts } }, perm);
-   RAJA::View<const double, RAJA::Layout<DIM, RAJA::Index_type, 0> > vgrad_view(vel_grad_array, layout);
-
-   MFEM_FORALL(i_pts, npts, {
-         // Might want to eventually set these all up using RAJA views. It might simplify
-         // things later on.
+   MFEM_FORALL(i_batch, npts_batch, {
+         const int i_pts = has_index ? pts_index[i_batch] : pts_offset + i_batch;
+         const int i_elems = i_pts / nqpts;
+         const int j_qpts = i_pts % nqpts;
+         // The velocity gradient is in col. major format
+         double vgrad[ecmech::ndim * ecmech::ndim];
+         exaconstit::kernel::grad_calc_pt(nqpts, nnodes, i_elems, j_qpts, jacobian_array,
+                                          loc_grad_array, vel_array, vgrad);
          // These are our inputs
-         const double* state_vars = &(state_vars_array[i_pts * nstatev]);
-         const double* stress = &(stress_array[i_pts * ecmech::nsvec]);
+         const double* state_vars = &(state_vars_beg_array[i_pts * pt_stride]);
+         const double* stress = &(stress_beg_array[i_pts * ecmech::nsvec]);
          // Here is all of our ouputs
-         double* eng_int = &(eng_int_array[i_pts * ecmech::ne]);
-         double* w_vec = &(w_vec_array[i_pts * ecmech::nwvec]);
-         double* vol_ratio = &(vol_ratio_array[i_pts * ecmech::nvr]);
+         double* w_vec = &(w_vec_array[i_batch * ecmech::nwvec]);
+         double* vol_ratio = &(vol_ratio_array[i_batch * ecmech::nvr]);
          // A few variables are set up as the 6-vec deviatoric + tr(tens) values
-         int ind_svecp = i_pts * ecmech::nsvp;
+         int ind_svecp = i_batch * ecmech::nsvp;
          double* stress_svec_p = &(stress_svec_p_array[ind_svecp]);
          double* d_svec_p = &(d_svec_p_array[ind_svecp]);
 
-         tempk_array[i_pts] = temp_k;
+         tempk_array[i_batch] = temp_k;
 
-         for (int i = 0; i < ecmech::ne; i++) {
-            eng_int[i] = state_vars[ind_int_eng + i];
-         }
+         gather_state_vars(nstatev, var_stride, ind_reduced, num_reduced, state_vars,
+                           &(batch_state_vars_array[i_batch * nstatev]));
 
          // Here we have the skew portion of our velocity gradient as represented as an
          // axial vector.
-         w_vec[0] = 0.5 * (vgrad_view(2, 1, i_pts) - vgrad_view(1, 2, i_pts));
-         w_vec[1] = 0.5 * (vgrad_view(0, 2, i_pts) - vgrad_view(2, 0, i_pts));
-         w_vec[2] = 0.5 * (vgrad_view(1, 0, i_pts) - vgrad_view(0, 1, i_pts));
+         w_vec[0] = 0.5 * (vgrad[2 + 3 * 1] - vgrad[1 + 3 * 2]);
+         w_vec[1] = 0.5 * (vgrad[0 + 3 * 2] - vgrad[2 + 3 * 0]);
+         w_vec[2] = 0.5 * (vgrad[1 + 3 * 0] - vgrad[0 + 3 * 1]);
 
          // Really we're looking at the negative of J but this will do...
-         double d_mean = -ecmech::onethird * (vgrad_view(0, 0, i_pts) + vgrad_view(1, 1, i_pts) + vgrad_view(2, 2, i_pts));
+         double d_mean = -ecmech::onethird * (vgrad[0] + vgrad[4] + vgrad[8]);
          // The 1st 6 components are the symmetric deviatoric portion of our velocity gradient
          // The last value is simply the trace of the deformation rate
-         d_svec_p[0] = vgrad_view(0, 0, i_pts) + d_mean;
-         d_svec_p[1] = vgrad_view(1, 1, i_pts) + d_mean;
-         d_svec_p[2] = vgrad_view(2, 2, i_pts) + d_mean;
-         d_svec_p[3] = 0.5 * (vgrad_view(2, 1, i_pts) + vgrad_view(1, 2, i_pts));
-         d_svec_p[4] = 0.5 * (vgrad_view(2, 0, i_pts) + vgrad_view(0, 2, i_pts));
-         d_svec_p[5] = 0.5 * (vgrad_view(1, 0, i_pts) + vgrad_view(0, 1, i_pts));
+         d_svec_p[0] = vgrad[0] + d_mean;
+         d_svec_p[1] = vgrad[4] + d_mean;
+         d_svec_p[2] = vgrad[8] + d_mean;
+         d_svec_p[3] = 0.5 * (vgrad[2 + 3 * 1] + vgrad[1 + 3 * 2]);
+         d_svec_p[4] = 0.5 * (vgrad[2 + 3 * 0] + vgrad[0 + 3 * 2]);
+         d_svec_p[5] = 0.5 * (vgrad[1 + 3 * 0] + vgrad[0 + 3 * 1]);
          d_svec_p[6] = -3.0 * d_mean;
 
-         double d_vecd_sm[ecmech::ntvec];
-         ecmech::svecToVecd(d_vecd_sm, d_svec_p);
-         dEff[i_pts] = ecmech::vecd_Deff(d_vecd_sm);
-
-         vol_ratio[0] = state_vars[ind_vols];
+         vol_ratio[0] = state_vars[ind_vols_stored * var_stride];
          vol_ratio[1] = vol_ratio[0] * exp(d_svec_p[ecmech::iSvecP] * dt);
          vol_ratio[3] = vol_ratio[1] - vol_ratio[0];
          vol_ratio[2] = vol_ratio[3] / (dt * 0.5 * (vol_ratio[0] + vol_ratio[1]));
 
-         for (int i = 0; i < ecmech::nsvec; i++) {
-            stress_svec_p[i] = stress[i];
-         }
-
-         double stress_mean = -ecmech::onethird * (stress[0] + stress[1] + stress[2]);
-         stress_svec_p[0] += stress_mean;
-         stress_svec_p[1] += stress_mean;
-         stress_svec_p[2] += stress_mean;
-         stress_svec_p[ecmech::iSvecP] = stress_mean;
+         stress_to_svec_p(stress, stress_svec_p);
       }); // end of npts loop
 } // end of set-up func
 
-// Retrieves the stress and reorders it into the desired 6 vec format. A copy of that vector
-// is sent back to the CPU for the time being. It also stores all of the state variables into their
-// appropriate vector. Finally, it saves off the material tangent stiffness vector. In the future,
+// Retrieves the stress and reorders it into the desired 6 vec format. It also updates
+// the volume and plastic work state variables. The internal energy was already updated
+// in place by the material model. Finally, it saves off the transpose of the material
+// tangent stiffness matrix all within the same pass over the points. In the future,
 // if PA is used then the 4D 3x3x3x3 tensor is saved off rather than the 6x6 2D matrix.
-void kernel_postprocessing(const int npts, const int nstatev, const double dt, const double* dEff,
+// If compact is true then the kernel outputs were compacted, and the results are
+// scattered back out from the batch arrays to their actual points, which are given
+// by pts_index if it's provided or start at pts_offset otherwise. The full state
+// variable arrays use the same pt_stride, var_stride, and single precision block
+// layout as in kernel_setup.
+void kernel_postprocessing(const int npts_batch, const int nstatev, const double dt,
+                           const bool tangent, const bool compact, const int* pts_index,
+                           const int pts_offset, const int pt_stride, const int var_stride,
+                           const int ind_reduced, const int num_reduced,
+                           const double* d_svec_p_array,
                            const double* stress_svec_p_array, const double* vol_ratio_array,
-                           const double* eng_int_array, const double* beg_state_vars_array,
+                           const double* beg_state_vars_array,
+                           double* batch_state_vars_array,
+                           const double* batch_ddsdde_array,
                            double* state_vars_array, double* stress_array,
                            double* ddsdde_array)
 {
    const int ind_int_eng = nstatev - ecmech::ne;
    const int ind_pl_work = ecmech::evptn::iHistA_flowStr;
    const int ind_vols = ind_int_eng - 1;
+   const bool has_index = (pts_index != nullptr);
+   const int ind_end_reduced = ind_reduced + num_reduced;
+   const int shift_reduced = (num_reduced + 1) / 2 - num_reduced;
+   const int ind_pl_work_stored = (ind_pl_work >= ind_end_reduced) ? ind_pl_work + shift_reduced : ind_pl_work;
 
-   MFEM_FORALL(i_pts, npts, {
-         // These are our outputs
-         double* state_vars = &(state_vars_array[i_pts * nstatev]);
-         const double* beg_state_vars = &(beg_state_vars_array[i_pts * nstatev]);
+   MFEM_FORALL(i_batch, npts_batch, {
+         const int i_pts = has_index ? pts_index[i_batch] : pts_offset + i_batch;
+         // These are our outputs. The state variables are updated within the batch
+         // and then scattered back out at the end if we're compacted.
+         double* state_vars = compact ? &(batch_state_vars_array[i_batch * nstatev])
+                                      : &(state_vars_array[i_pts * nstatev]);
+         const double* beg_state_vars = &(beg_state_vars_array[i_pts * pt_stride]);
          double* stress = &(stress_array[i_pts * ecmech::nsvec]);
-         // Here is all of our ouputs
-         const double* eng_int = &(eng_int_array[i_pts * ecmech::ne]);
-         const double* vol_ratio = &(vol_ratio_array[i_pts * ecmech::nvr]);
+         double* ddsdde = tangent ? &(ddsdde_array[i_pts * ecmech::nsvec * ecmech::nsvec]) : nullptr;
+         // Here is all of our inputs
+         const double* vol_ratio = &(vol_ratio_array[i_batch * ecmech::nvr]);
          // A few variables are set up as the 6-vec deviatoric + tr(tens) values
-         int ind_svecp = i_pts * ecmech::nsvp;
+         int ind_svecp = i_batch * ecmech::nsvp;
          const double* stress_svec_p = &(stress_svec_p_array[ind_svecp]);
+         const double* d_svec_p = &(d_svec_p_array[ind_svecp]);
+
+         // The effective deformation rate is cheap enough to recompute here
+         // rather than store off during the set-up
+         double d_vecd_sm[ecmech::ntvec];
+         ecmech::svecToVecd(d_vecd_sm, d_svec_p);
+         const double dEff = ecmech::vecd_Deff(d_vecd_sm);
 
-         // We need to update our state variables to include the volume ratio and
-         // internal energy portions
+         // We need to update our state variables to include the volume ratio
          state_vars[ind_vols] = vol_ratio[1];
-         for (int i = 0; i < ecmech::ne; i++) {
-            state_vars[ind_int_eng + i] = eng_int[i];
-         }
 
-         if(dEff[i_pts] > ecmech::idp_tiny_sqrt) {
-            state_vars[ind_pl_work] *= dEff[i_pts] * dt;
+         if(dEff > ecmech::idp_tiny_sqrt) {
+            state_vars[ind_pl_work] *= dEff * dt;
          } else {
             state_vars[ind_pl_work] = 0.0;
          }
-         state_vars[ind_pl_work] += beg_state_vars[ind_pl_work];
+         state_vars[ind_pl_work] += beg_state_vars[ind_pl_work_stored * var_stride];
+
+         if (compact) {
+            double* full_state_vars = &(state_vars_array[i_pts * pt_stride]);
+            for (int i = 0; i < ind_reduced; i++) {
+               full_state_vars[i * var_stride] = state_vars[i];
+            }
+            if (num_reduced > 0) {
+               float* reduced = reinterpret_cast<float*>(&(full_state_vars[ind_reduced]));
+               for (int i = 0; i < num_reduced; i++) {
+                  reduced[i] = static_cast<float>(state_vars[ind_reduced + i]);
+               }
+            }
+            for (int i = ind_end_reduced; i < nstatev; i++) {
+               full_state_vars[(i + shift_reduced) * var_stride] = state_vars[i];
+            }
+         }
 
          // Here we're converting back from our deviatoric + pressure representation of our
          // Cauchy stress back to the Voigt notation of stress.
@@ -149,104 +232,517 @@ void kernel_postprocessing(const int npts, const int nstatev, const double dt, c
          stress[0] += stress_mean;
          stress[1] += stress_mean;
          stress[2] += stress_mean;
-      }); // end of npts loop
 
-   MFEM_FORALL(i_pts, npts, {
          // ExaCMech saves this in Row major, so we need to get out the transpose.
          // The good thing is we can do this all in place no problem.
-         double* ddsdde = &(ddsdde_array[i_pts * ecmech::nsvec * ecmech::nsvec]);
-         for (int i = 0; i < ecmech::nsvec; ++i) {
-            for (int j = i + 1; j < ecmech::nsvec; ++j) {
-               double tmp = ddsdde[(ecmech::nsvec * j) +i];
-               ddsdde[(ecmech::nsvec * j) +i] = ddsdde[(ecmech::nsvec * i) +j];
-               ddsdde[(ecmech::nsvec * i) +j] = tmp;
+         if (tangent && compact) {
+            const double* batch_ddsdde = &(batch_ddsdde_array[i_batch * ecmech::nsvec * ecmech::nsvec]);
+            for (int i = 0; i < ecmech::nsvec; ++i) {
+               for (int j = 0; j < ecmech::nsvec; ++j) {
+                  ddsdde[(ecmech::nsvec * j) +i] = batch_ddsdde[(ecmech::nsvec * i) +j];
+               }
             }
          }
-      });
+         else if (tangent) {
+            for (int i = 0; i < ecmech::nsvec; ++i) {
+               for (int j = i + 1; j < ecmech::nsvec; ++j) {
+                  double tmp = ddsdde[(ecmech::nsvec * j) +i];
+                  ddsdde[(ecmech::nsvec * j) +i] = ddsdde[(ecmech::nsvec * i) +j];
+                  ddsdde[(ecmech::nsvec * i) +j] = tmp;
+               }
+            }
+         }
+      }); // end of npts loop
 } // end of post-processing func
 
 // The different CPU, OpenMP, and GPU kernels aren't needed here, since they're
 // defined in ExaCMech itself.
+// The internal energy lives within the state variables, so ExaCMech updates it in place.
+// ExaCMech skips the material tangent stiffness calculation if ddsdde_array is a nullptr.
 void kernel(const ecmech::matModelBase* mat_model_base,
-            const int npts, const double dt, double* state_vars_array,
+            const int npts, const int nstatev, const double dt, double* state_vars_array,
             double* stress_svec_p_array, double* d_svec_p_array,
             double* w_vec_array, double* ddsdde_array,
-            double* vol_ratio_array, double* eng_int_array,
-            double* tempk_array, double* sdd_array)
+            double* vol_ratio_array, double* tempk_array, double* sdd_array)
 {
+  double* eng_int_array = &(state_vars_array[nstatev - ecmech::ne]);
   mat_model_base->getResponseECM(dt, d_svec_p_array, w_vec_array, vol_ratio_array,
                                eng_int_array, stress_svec_p_array, state_vars_array,
                                tempk_array, sdd_array, ddsdde_array, npts);
 }
 
+// Runs the material model kernel in chunks of chunk_size points that are spread
+// across the OpenMP threads. Each call to ExaCMech runs serially on its chunk, so
+// the points need to be in the order we want them scheduled in. The time each
+// thread spends in the kernel is added to thread_times.
+void kernel_chunked(const ecmech::matModelBase* mat_model_base,
+                    const int npts, const int nstatev, const double dt,
+                    const int chunk_size, const bool dynamic, double* thread_times,
+                    double* state_vars_array, double* stress_svec_p_array,
+                    double* d_svec_p_array, double* w_vec_array, double* ddsdde_array,
+                    double* vol_ratio_array, double* tempk_array, double* sdd_array)
+{
+#if defined(RAJA_ENABLE_OPENMP)
+   const int nchunks = (npts + chunk_size - 1) / chunk_size;
+   const int nsvec2 = ecmech::nsvec * ecmech::nsvec;
+   auto run_chunk = [=] (const int ichunk) {
+      const int start = ichunk * chunk_size;
+      const int n = std::min(chunk_size, npts - start);
+      double* ddsdde = (ddsdde_array != nullptr) ? &ddsdde_array[start * nsvec2] : nullptr;
+      kernel(mat_model_base, n, nstatev, dt, &state_vars_array[start * nstatev],
+             &stress_svec_p_array[start * ecmech::nsvp], &d_svec_p_array[start * ecmech::nsvp],
+             &w_vec_array[start * ecmech::nwvec], ddsdde, &vol_ratio_array[start * ecmech::nvr],
+             &tempk_array[start], &sdd_array[start * ecmech::nsdd]);
+   };
+   // The two schedules are separate loops rather than a schedule(runtime) loop,
+   // since setting the runtime schedule would change it for every other
+   // schedule(runtime) loop in the process as well.
+   #pragma omp parallel
+   {
+      double busy = 0.0;
+      if (dynamic) {
+         #pragma omp for schedule(dynamic, 1) nowait
+         for (int ichunk = 0; ichunk < nchunks; ichunk++) {
+            const double t0 = omp_get_wtime();
+            run_chunk(ichunk);
+            busy += omp_get_wtime() - t0;
+         }
+      }
+      else {
+         #pragma omp for schedule(static) nowait
+         for (int ichunk = 0; ichunk < nchunks; ichunk++) {
+            const double t0 = omp_get_wtime();
+            run_chunk(ichunk);
+            busy += omp_get_wtime() - t0;
+         }
+      }
+      thread_times[omp_get_thread_num()] += busy;
+   }
+#else
+   (void) chunk_size;
+   (void) dynamic;
+   (void) thread_times;
+   kernel(mat_model_base, npts, nstatev, dt, state_vars_array, stress_svec_p_array,
+          d_svec_p_array, w_vec_array, ddsdde_array, vol_ratio_array, tempk_array, sdd_array);
+#endif
+}
+
 } // End private namespace
 
+void ExaCMechModel::SetChunkedScheduling(const int _chunk_size, const bool dynamic)
+{
+#if defined(RAJA_ENABLE_OPENMP)
+   chunk_size = _chunk_size;
+   chunk_dynamic = dynamic;
+   auto it = qf_mapping.find("num_evals");
+   MFEM_VERIFY(it != qf_mapping.end(), "Chunked scheduling needs the number of evaluations state variable");
+   ind_cost = it->second.first;
+   thread_times.assign(omp_get_max_threads(), 0.0);
+   // The threading is now done by us, so each call to ExaCMech runs serially
+   mat_model_base->setExecutionStrategy(ecmech::ExecutionStrategy::CPU);
+#else
+   (void) _chunk_size;
+   (void) dynamic;
+#endif
+}
+
+void ExaCMechModel::SetSubstepping(const int _max_evals, const int _max_substeps)
+{
+   substep_max_evals = _max_evals;
+   max_substeps = _max_substeps;
+}
+
+void ExaCMechModel::SubstepUpdate(const int npts_batch, const int* pts_list, const int pts_offset,
+                                  const double* stress_beg,
+                                  const double* state_vars_beg, double* batch_state_vars,
+                                  double* stress_svec_p_array, const double* d_svec_p_array,
+                                  const double* w_vec_array, const double* vol_ratio_array,
+                                  double* sdd_array, double* batch_ddsdde)
+{
+   const int nstatev = numStateVars;
+   const int nsvec2 = ecmech::nsvec * ecmech::nsvec;
+   // The batch is always in the full double precision layout ExaCMech uses, so
+   // these are the ExaCMech history indices rather than the stored ones.
+   const int ind_evals = ecmech::evptn::iHistA_nFEval;
+   const int ind_pl_work = ecmech::evptn::iHistA_flowStr;
+   const int pt_stride = GetStatePtStride();
+   const int var_stride = GetStateVarStride();
+   const bool tangent = (batch_ddsdde != nullptr);
+
+   std::vector<int> &sub_pts = substep_pts;
+   std::vector<int> &next_pts = substep_next_pts;
+   sub_pts.clear();
+   for (int i = 0; i < npts_batch; i++) {
+      if (batch_state_vars[i * nstatev + ind_evals] > substep_max_evals) {
+         sub_pts.push_back(i);
+      }
+   }
+
+   int nsub_steps = 2;
+   while (!sub_pts.empty() && nsub_steps <= max_substeps) {
+      const int npts_sub = sub_pts.size();
+      const double dt_sub = dt / nsub_steps;
+
+      // The scratch space is kept around between calls, and it's split up into
+      // the per point arrays for this round of sub-steps
+      const int nddsdde = tangent ? nsvec2 : 0;
+      const size_t nscratch = static_cast<size_t>(npts_sub) *
+                              (nstatev + 2 * ecmech::nsvp + ecmech::nwvec + ecmech::nvr + 1 +
+                               ecmech::nsdd + 2 * nddsdde + 3);
+      if (substep_scratch.size() < nscratch) {
+         substep_scratch.resize(nscratch);
+      }
+      double* hist = substep_scratch.data();
+      double* stress_svec_p = hist + npts_sub * nstatev;
+      double* d_svec_p = stress_svec_p + npts_sub * ecmech::nsvp;
+      double* w_vec = d_svec_p + npts_sub * ecmech::nsvp;
+      double* vol_ratio = w_vec + npts_sub * ecmech::nwvec;
+      double* tempk = vol_ratio + npts_sub * ecmech::nvr;
+      double* sdd = tempk + npts_sub;
+      double* ddsdde = sdd + npts_sub * ecmech::nsdd;
+      double* ddsdde_sum = ddsdde + npts_sub * nddsdde;
+      double* pl_work_sum = ddsdde_sum + npts_sub * nddsdde;
+      double* evals_sum = pl_work_sum + npts_sub;
+      double* evals_max = evals_sum + npts_sub;
+      std::fill(ddsdde_sum, evals_max + npts_sub, 0.0);
+
+      // Every sub-stepped point starts over from the beginning of the step
+      for (int is = 0; is < npts_sub; is++) {
+         const int ib = sub_pts[is];
+         const int i_pts = (pts_list != nullptr) ? pts_list[ib] : pts_offset + ib;
+         gather_state_vars(nstatev, var_stride, ind_reduced, num_reduced,
+                           &(state_vars_beg[i_pts * pt_stride]), &(hist[is * nstatev]));
+         stress_to_svec_p(&(stress_beg[i_pts * ecmech::nsvec]), &(stress_svec_p[is * ecmech::nsvp]));
+         for (int i = 0; i < ecmech::nsvp; i++) {
+            d_svec_p[is * ecmech::nsvp + i] = d_svec_p_array[ib * ecmech::nsvp + i];
+         }
+         for (int i = 0; i < ecmech::nwvec; i++) {
+            w_vec[is * ecmech::nwvec + i] = w_vec_array[ib * ecmech::nwvec + i];
+         }
+      }
+
+      for (int istep = 0; istep < nsub_steps; istep++) {
+         for (int is = 0; is < npts_sub; is++) {
+            const int ib = sub_pts[is];
+            const double tr_d = d_svec_p[is * ecmech::nsvp + ecmech::iSvecP];
+            double* vr = &(vol_ratio[is * ecmech::nvr]);
+            vr[0] = vol_ratio_array[ib * ecmech::nvr] * exp(tr_d * istep * dt_sub);
+            vr[1] = vr[0] * exp(tr_d * dt_sub);
+            vr[3] = vr[1] - vr[0];
+            vr[2] = vr[3] / (dt_sub * 0.5 * (vr[0] + vr[1]));
+            tempk[is] = temp_k;
+         }
+
+         kernel(mat_model_base, npts_sub, nstatev, dt_sub, hist, stress_svec_p,
+                d_svec_p, w_vec, tangent ? ddsdde : nullptr,
+                vol_ratio, tempk, sdd);
+
+         for (int is = 0; is < npts_sub; is++) {
+            const double evals = hist[is * nstatev + ind_evals];
+            pl_work_sum[is] += hist[is * nstatev + ind_pl_work];
+            evals_sum[is] += evals;
+            evals_max[is] = std::max(evals_max[is], evals);
+         }
+         for (int i = 0; i < npts_sub * nddsdde; i++) {
+            ddsdde_sum[i] += ddsdde[i];
+         }
+      }
+
+      // Points that still take too many evaluations get tried again with twice as many
+      // sub-steps. Once we're at the max number of sub-steps we take what we have.
+      next_pts.clear();
+      for (int is = 0; is < npts_sub; is++) {
+         const int ib = sub_pts[is];
+         if (evals_max[is] > substep_max_evals && 2 * nsub_steps <= max_substeps) {
+            next_pts.push_back(ib);
+            continue;
+         }
+         double* state_vars = &(batch_state_vars[ib * nstatev]);
+         for (int i = 0; i < nstatev; i++) {
+            state_vars[i] = hist[is * nstatev + i];
+         }
+         // The post-processing turns the flow strength into the plastic work
+         // increment over the whole step, so it gets the sub-step average.
+         state_vars[ind_pl_work] = pl_work_sum[is] / nsub_steps;
+         state_vars[ind_evals] = evals_sum[is];
+         for (int i = 0; i < ecmech::nsvp; i++) {
+            stress_svec_p_array[ib * ecmech::nsvp + i] = stress_svec_p[is * ecmech::nsvp + i];
+         }
+         for (int i = 0; i < ecmech::nsdd; i++) {
+            sdd_array[ib * ecmech::nsdd + i] = sdd[is * ecmech::nsdd + i];
+         }
+         // Each sub-step tangent is with respect to its own strain increment,
+         // which is 1 / nsub_steps of the full step's increment. So by the chain
+         // rule the tangent of the whole step is their average.
+         if (tangent) {
+            for (int i = 0; i < nsvec2; i++) {
+               batch_ddsdde[ib * nsvec2 + i] = ddsdde_sum[is * nsvec2 + i] / nsub_steps;
+            }
+         }
+      }
+      sub_pts.swap(next_pts);
+      nsub_steps *= 2;
+   }
+}
+
+void ExaCMechModel::GetThreadTimes(std::vector<double> &times) const
+{
+   if (times.size() < thread_times.size()) {
+      times.resize(thread_times.size(), 0.0);
+   }
+   for (size_t i = 0; i < thread_times.size(); i++) {
+      times[i] += thread_times[i];
+   }
+}
+
 // Our model set-up makes use of several preprocessing kernels,
 // the actual material model kernel, and finally a post-processing kernel.
+void ExaCMechModel::SetupBatchArrays(const int npts_batch)
+{
+   // The compacted arrays only ever grow, so we only pay for the allocation the
+   // first time we see a given batch size.
+   const int nsvec2 = ecmech::nsvec * ecmech::nsvec;
+   if (c_state_vars_array == nullptr) {
+      c_state_vars_array = new Vector(npts_batch * numStateVars, Device::GetMemoryType());
+      c_ddsdde_array = new Vector(npts_batch * nsvec2, Device::GetMemoryType());
+      c_state_vars_array->UseDevice(true);
+      c_ddsdde_array->UseDevice(true);
+   }
+   else if (c_state_vars_array->Size() < npts_batch * numStateVars) {
+      c_state_vars_array->SetSize(npts_batch * numStateVars);
+      c_ddsdde_array->SetSize(npts_batch * nsvec2);
+   }
+}
+
 void ExaCMechModel::ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
                                const int nnodes, const Vector &jacobian,
                                const Vector &loc_grad, const Vector &vel)
 {
-   const int nstatev = numStateVars;
-
-   const double *jacobian_array = jacobian.Read();
-   const double *loc_grad_array = loc_grad.Read();
-   const double *vel_array = vel.Read();
-
-   // Here we call an initialization function which sets the end step stress
-   // and state variable variables to the initial time step values.
-   // Then the pointer to the underlying data array is returned and
-   // operated on to those end time step variables
-   double* state_vars_array = StateVarsSetup();
+   // The beginning step stress and state variables are only read, and the
+   // kernels write out every point's end step values. So, there's no need to
+   // copy the beginning step values over to the end step arrays first.
    const double *state_vars_beg = matVars0->Read();
-   double* stress_array = StressSetup();
+   const double *stress_beg = stress0->Read();
+   double* state_vars_array = matVars1->Write();
+   double* stress_array = stress1->Write();
    // If we require a 4D tensor for PA applications then we might
    // need to use something other than this for our applications.
-   QuadratureFunction* matGrad_qf = matGrad;
-   *matGrad_qf = 0.0;
-   double* ddsdde_array = matGrad_qf->ReadWrite();
+   // When only the stress is needed we don't touch the tangent at all, and
+   // ExaCMech skips computing it.
+   double* ddsdde_array = nullptr;
+   if (tangent_required) {
+      QuadratureFunction* matGrad_qf = matGrad;
+      *matGrad_qf = 0.0;
+      ddsdde_array = matGrad_qf->ReadWrite();
+   }
+
+   RegionModelSetup(nqpts, nelems, nnodes, jacobian.Read(), loc_grad.Read(), vel.Read(),
+                    stress_beg, state_vars_beg, state_vars_array, stress_array, ddsdde_array);
+} // End of ModelSetup function
+
+void ExaCMechModel::RegionModelSetup(const int nqpts, const int nelems, const int nnodes,
+                                     const double* jacobian_array, const double* loc_grad_array,
+                                     const double* vel_array, const double* stress_beg,
+                                     const double* state_vars_beg,
+                                     double* state_vars_array, double* stress_array,
+                                     double* ddsdde_array)
+{
+   const int nstatev = numStateVars;
+   const bool tangent = tangent_required && (ddsdde_array != nullptr);
+   if (!tangent) {
+      ddsdde_array = nullptr;
+   }
+
    // All of these variables are stored on the material model class using
    // the vector class.
-   *vel_grad_array = 0.0;
-   double* vel_grad_array_data = vel_grad_array->ReadWrite();
-   double* stress_svec_p_array_data = stress_svec_p_array->ReadWrite();
-   double* d_svec_p_array_data = d_svec_p_array->ReadWrite();
-   double* w_vec_array_data = w_vec_array->ReadWrite();
-   double* vol_ratio_array_data = vol_ratio_array->ReadWrite();
-   double* eng_int_array_data = eng_int_array->ReadWrite();
-   double* tempk_array_data = tempk_array->ReadWrite();
+   double* stress_svec_p_array_data = stress_svec_p_array->Write();
+   double* d_svec_p_array_data = d_svec_p_array->Write();
+   double* w_vec_array_data = w_vec_array->Write();
+   double* vol_ratio_array_data = vol_ratio_array->Write();
+   double* tempk_array_data = tempk_array->Write();
    double* sdd_array_data = sdd_array->ReadWrite();
 
-   const int npts = nqpts * nelems;
-   double* dEff = eff_def_rate->Write();
-
-   // If we're on the initial step we need to first calculate a
-   // solution where our vgrad is the 0 tensor across the entire
-   // body. After we obtain this we calculate our actual velocity
-   // gradient and use that to obtain the appropriate stress field
-   // but don't calculate the material tangent stiffness tensor.
-   // Any other step is much simpler, and we just calculate the
-   // velocity gradient, run our model, and then obtain our material
-   // tangent stiffness matrix.
-   CALI_MARK_BEGIN("ecmech_setup");
-   exaconstit::kernel::grad_calc(nqpts, nelems, nnodes, jacobian_array, loc_grad_array,
-                                 vel_array, vel_grad_array_data);
-
-   kernel_setup(npts, nstatev, dt, temp_k, vel_grad_array_data,
-                stress_array, state_vars_array, stress_svec_p_array_data,
-                d_svec_p_array_data, w_vec_array_data,
-                vol_ratio_array_data, eng_int_array_data, tempk_array_data, dEff);
-   CALI_MARK_END("ecmech_setup");
-   CALI_MARK_BEGIN("ecmech_kernel");
-   kernel(mat_model_base, npts, dt, state_vars_array,
-            stress_svec_p_array_data, d_svec_p_array_data, w_vec_array_data,
-            ddsdde_array, vol_ratio_array_data, eng_int_array_data,
-            tempk_array_data, sdd_array_data);
-   CALI_MARK_END("ecmech_kernel");
-
-   CALI_MARK_BEGIN("ecmech_postprocessing");
-   kernel_postprocessing(npts, nstatev, dt, dEff, stress_svec_p_array_data,
-                         vol_ratio_array_data, eng_int_array_data, state_vars_beg, state_vars_array,
-                         stress_array, ddsdde_array);
-   CALI_MARK_END("ecmech_postprocessing");
-} // End of ModelSetup function
+   // If we only own a region of the points then those are the points we
+   // evaluate, and they get compacted into a contiguous batch for ExaCMech.
+   // ExaCMech needs all of the state variables of a point to be contiguous and
+   // in double precision, so the structure of arrays layout and the single
+   // precision state variables always go through the batch as well.
+   const bool has_region = region_only;
+   const int pt_stride = GetStatePtStride();
+   const int var_stride = GetStateVarStride();
+   const int npts_cand = has_region ? region_pts.Size() : nqpts * nelems;
+   const int* cand_index = has_region ? region_pts.Read() : nullptr;
+
+   int npts_batch = npts_cand;
+   const int* pts_index = cand_index;
+   // Host side copy of the batch point list if we have one
+   const mfem::Array<int>* batch_list = has_region ? &region_pts : nullptr;
+   bool compact = has_region || soa_state || num_reduced > 0;
+
+   // For the dynamically scheduled chunks the batch is sorted so the points that
+   // took the most evaluations last step are handed out first. This is a cheap
+   // stand-in for their cost this step, and it keeps the threads from sitting idle
+   // waiting on a few expensive chunks at the end. The number of evaluations only
+   // changes between steps, so the order is computed once per step on the host,
+   // and every residual and Jacobian evaluation within the step reuses it.
+   const bool cost_order = (chunk_size > 0 && chunk_dynamic);
+   if (cost_order && !cost_order_valid) {
+      CALI_MARK_BEGIN("ecmech_cost_sort");
+      const int* cand = has_region ? region_pts.HostRead() : nullptr;
+      cost_pos.SetSize(npts_cand, Device::GetMemoryType());
+      cost_index.SetSize(npts_cand, Device::GetMemoryType());
+      int* pos = cost_pos.HostWrite();
+      for (int i = 0; i < npts_cand; i++) {
+         pos[i] = i;
+      }
+      const double* cost_vars = matVars0->HostRead();
+      const int icost = GetStoredStateIndex(ind_cost);
+      auto cost = [=] (const int i) {
+         const int i_pts = has_region ? cand[i] : i;
+         return cost_vars[i_pts * pt_stride + icost * var_stride];
+      };
+      std::stable_sort(pos, pos + npts_cand, [=] (const int a, const int b) {
+         return cost(a) > cost(b);
+      });
+      int* index = cost_index.HostWrite();
+      for (int i = 0; i < npts_cand; i++) {
+         index[i] = has_region ? cand[pos[i]] : pos[i];
+      }
+      cost_order_valid = true;
+      CALI_MARK_END("ecmech_cost_sort");
+   }
+   if (cost_order) {
+      pts_index = cost_index.Read();
+      batch_list = &cost_index;
+      compact = true;
+   }
+
+   // With the elastic fast path the elastic points are updated in closed form,
+   // and only the plastic points are compacted into a batch for ExaCMech. The
+   // plastic points keep the cost order if we have one.
+   if (elastic_fast_path) {
+      CALI_MARK_BEGIN("ecmech_elastic_trial");
+      ElasticTrialUpdate(nqpts, npts_cand, nnodes, cand_index, jacobian_array, loc_grad_array,
+                         vel_array, stress_beg, state_vars_beg, stress_array,
+                         state_vars_array, ddsdde_array, elastic_flag.Write());
+      // The compaction of the plastic point indices is a serial scan, so it's done
+      // on the host.
+      const int* flags = elastic_flag.HostRead();
+      const int* cand = has_region ? region_pts.HostRead() : nullptr;
+      const int* pos = cost_order ? cost_pos.HostRead() : nullptr;
+      const int* cost_pts = cost_order ? cost_index.HostRead() : nullptr;
+      int* index = plastic_index.HostWrite();
+      npts_batch = 0;
+      for (int k = 0; k < npts_cand; k++) {
+         const int i = cost_order ? pos[k] : k;
+         if (flags[i] == 0) {
+            index[npts_batch] = cost_order ? cost_pts[k] : (has_region ? cand[i] : i);
+            npts_batch++;
+         }
+      }
+      pts_index = plastic_index.Read();
+      batch_list = &plastic_index;
+      compact = true;
+      CALI_MARK_END("ecmech_elastic_trial");
+   }
+
+   if (npts_batch == 0) {
+      return;
+   }
+
+   // A compacted batch is gathered into double precision scratch arrays with
+   // all of a point's state variables contiguous, since ExaCMech has no way of
+   // reading strided or single precision state variables. The batch is run through
+   // the set-up, kernel, and post-processing in pieces of at most batch_size points,
+   // so the scratch arrays stay a fixed size no matter how many points there are.
+   // Otherwise, they'd cost more memory than the structure of arrays layout or the
+   // single precision shear rates save. Without compaction the kernel works on the
+   // end step state variables in place and everything is run at once.
+   const int npts_piece = (compact && batch_size > 0) ? std::min(npts_batch, batch_size) : npts_batch;
+   double* batch_state_vars = state_vars_array;
+   double* batch_ddsdde = ddsdde_array;
+   if (compact) {
+      SetupBatchArrays(npts_piece);
+      batch_state_vars = c_state_vars_array->Write();
+      batch_ddsdde = tangent ? c_ddsdde_array->Write() : nullptr;
+   }
+   const int* batch_list_data = (batch_list != nullptr) ? batch_list->HostRead() : nullptr;
+
+   for (int start = 0; start < npts_batch; start += npts_piece) {
+      const int npts = std::min(npts_piece, npts_batch - start);
+      const int* index = (pts_index != nullptr) ? &pts_index[start] : nullptr;
+      // The set-up kernel forms the velocity gradient for each point and
+      // converts it into the deviatoric deformation rate and spin forms
+      // ExaCMech expects. The post-processing kernel then returns the Voigt
+      // stress, the updated state variables, and the transposed material
+      // tangent stiffness matrix in a single pass.
+      CALI_MARK_BEGIN("ecmech_setup");
+      kernel_setup(nqpts, npts, nnodes, nstatev, dt, temp_k, index, start,
+                   pt_stride, var_stride, ind_reduced, num_reduced, jacobian_array,
+                   loc_grad_array, vel_array, stress_beg, state_vars_beg, batch_state_vars,
+                   stress_svec_p_array_data, d_svec_p_array_data, w_vec_array_data,
+                   vol_ratio_array_data, tempk_array_data);
+      CALI_MARK_END("ecmech_setup");
+      CALI_MARK_BEGIN("ecmech_kernel");
+      if (chunk_size > 0) {
+         kernel_chunked(mat_model_base, npts, nstatev, dt, chunk_size, chunk_dynamic,
+                        thread_times.data(), batch_state_vars, stress_svec_p_array_data,
+                        d_svec_p_array_data, w_vec_array_data, batch_ddsdde,
+                        vol_ratio_array_data, tempk_array_data, sdd_array_data);
+      }
+      else {
+         kernel(mat_model_base, npts, nstatev, dt, batch_state_vars,
+                  stress_svec_p_array_data, d_svec_p_array_data, w_vec_array_data,
+                  batch_ddsdde, vol_ratio_array_data, tempk_array_data, sdd_array_data);
+      }
+      CALI_MARK_END("ecmech_kernel");
+
+      if (substep_max_evals > 0) {
+         CALI_MARK_BEGIN("ecmech_substep");
+         SubstepUpdate(npts, (batch_list_data != nullptr) ? &batch_list_data[start] : nullptr, start,
+                       stress_beg, state_vars_beg, batch_state_vars, stress_svec_p_array_data,
+                       d_svec_p_array_data, w_vec_array_data, vol_ratio_array_data,
+                       sdd_array_data, batch_ddsdde);
+         CALI_MARK_END("ecmech_substep");
+      }
+
+      CALI_MARK_BEGIN("ecmech_postprocessing");
+      kernel_postprocessing(npts, nstatev, dt, tangent, compact, index, start, pt_stride,
+                            var_stride, ind_reduced, num_reduced, d_svec_p_array_data,
+                            stress_svec_p_array_data, vol_ratio_array_data, state_vars_beg,
+                            batch_state_vars, batch_ddsdde, state_vars_array,
+                            stress_array, ddsdde_array);
+      CALI_MARK_END("ecmech_postprocessing");
+   }
+} // End of RegionModelSetup function
+
+void ExaCMechRegionModel::ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
+                                     const int nnodes, const Vector &jacobian,
+                                     const Vector &loc_grad, const Vector &vel)
+{
+   // Every point is owned by one of the regions, so between them they write
+   // out all of the end step values.
+   const double *state_vars_beg = matVars0->Read();
+   const double *stress_beg = stress0->Read();
+   double* state_vars_array = matVars1->Write();
+   double* stress_array = stress1->Write();
+   double* ddsdde_array = nullptr;
+   if (tangent_required) {
+      QuadratureFunction* matGrad_qf = matGrad;
+      *matGrad_qf = 0.0;
+      ddsdde_array = matGrad_qf->ReadWrite();
+   }
+
+   const double *jacobian_array = jacobian.Read();
+   const double *loc_grad_array = loc_grad.Read();
+   const double *vel_array = vel.Read();
+
+   for (auto model : regions) {
+      model->SetModelDt(dt);
+      model->SetModelTime(t);
+      model->SetTangentRequired(tangent_required);
+      model->RegionModelSetup(nqpts, nelems, nnodes, jacobian_array, loc_grad_array, vel_array,
+                              stress_beg, state_vars_beg, state_vars_array, stress_array,
+                              ddsdde_array);
+   }
+} // End of ExaCMechRegionModel::ModelSetup function
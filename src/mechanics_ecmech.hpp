@@ -7,6 +7,9 @@
 #include "ECMech_evptnWrap.h"
 #include "ECMech_const.h"
 #include "mechanics_model.hpp"
+#include "mechanics_kernels.hpp"
+#include <cmath>
+#include <vector>
 
 /// Base class for all of our ExaCMechModels.
 class ExaCMechModel : public ExaModel
@@ -26,16 +29,96 @@ class ExaCMechModel : public ExaModel
       ecmech::ExecutionStrategy accel;
 
       // Temporary variables that we'll be making use of when running our
-      // models.
-      mfem::Vector *vel_grad_array;
-      mfem::Vector *eng_int_array;
+      // models. The velocity gradient is formed per point within the set-up kernel
+      // and the internal energy is updated in place within the state variables,
+      // so neither of those require a scratch array.
       mfem::Vector *w_vec_array;
       mfem::Vector *vol_ratio_array;
       mfem::Vector *stress_svec_p_array;
       mfem::Vector *d_svec_p_array;
       mfem::Vector *tempk_array;
       mfem::Vector *sdd_array;
-      mfem::Vector *eff_def_rate;
+
+      // Variables related to the elastic fast path. Points that are flagged
+      // as elastic are updated in closed form, and only the remaining plastic
+      // points are compacted and handed off to ExaCMech.
+      bool elastic_fast_path = false;
+      // Points are elastic if their max trial resolved shear stress is
+      // below this ratio times their slip resistance
+      double elastic_ratio = 0.5;
+      mfem::Array<int> elastic_flag;
+      mfem::Array<int> plastic_index;
+      mfem::Vector *c_state_vars_array = nullptr;
+      mfem::Vector *c_ddsdde_array = nullptr;
+      // Max number of points the compacted batch arrays hold, 0 is no limit.
+      // Larger batches are run through the material model in pieces.
+      int batch_size = 4096;
+
+      // If set, the model only evaluates these quadrature points. This is how
+      // the different regions of a multi-region material are split up.
+      bool region_only = false;
+      mfem::Array<int> region_pts;
+
+      // Variables related to the chunked scheduling of the material kernel across
+      // OpenMP threads. If chunk_size is 0 ExaCMech gets all of the points at once.
+      int chunk_size = 0;
+      // With dynamic scheduling the points are sorted so that the ones that took
+      // the most evaluations last step go first.
+      bool chunk_dynamic = true;
+      // State variable that holds the number of evaluations from last step
+      int ind_cost = -1;
+      // The candidate points sorted by their cost, as positions within the
+      // candidates and as quadrature point indices. They're only recomputed once
+      // per step after UpdateModelVars marks them as out of date.
+      bool cost_order_valid = false;
+      mfem::Array<int> cost_pos;
+      mfem::Array<int> cost_index;
+      // Time each thread has spent in the material kernel
+      std::vector<double> thread_times;
+
+      // Variables related to the local sub-stepping of the material update. Points
+      // that took more than substep_max_evals evaluations are redone with 2, 4, ...
+      // up to max_substeps sub-steps. 0 turns sub-stepping off.
+      int substep_max_evals = 0;
+      int max_substeps = 8;
+      // Host side scratch space for the sub-stepped points, which only grows
+      std::vector<int> substep_pts;
+      std::vector<int> substep_next_pts;
+      std::vector<double> substep_scratch;
+
+      /** Redoes the points of the batch whose solve took more than substep_max_evals
+       *  evaluations with a number of smaller sub-steps. The velocity gradient is
+       *  constant over the step, so each sub-step uses the same deformation rate and
+       *  spin. The sub-step results replace the batch results before post-processing,
+       *  with the tangent stiffness being the average of the sub-step tangents.
+       *  pts_list is the host side list of the batch points or a nullptr if the
+       *  batch is the npts_batch points starting at pts_offset. This is only run
+       *  on the host.
+       */
+      void SubstepUpdate(const int npts_batch, const int* pts_list, const int pts_offset,
+                         const double* stress_beg,
+                         const double* state_vars_beg, double* batch_state_vars,
+                         double* stress_svec_p_array, const double* d_svec_p_array,
+                         const double* w_vec_array, const double* vol_ratio_array,
+                         double* sdd_array, double* batch_ddsdde);
+
+      /** Runs the closed form elastic trial update for every point. Points whose
+       *  trial resolved shear stresses all stay below elastic_ratio times their
+       *  slip resistance have their end step stress, state variables, and tangent
+       *  (if ddsdde_array isn't a nullptr) computed from the beginning step values
+       *  and their elastic_flag_array entry set to 1. All other points are left
+       *  untouched and set to 0.
+       */
+      virtual void ElasticTrialUpdate(const int nqpts, const int npts_cand, const int nnodes,
+                                      const int* pts_index,
+                                      const double* jacobian_array, const double* loc_grad_array,
+                                      const double* vel_array, const double* stress_beg_array,
+                                      const double* state_vars_beg_array, double* stress_array,
+                                      double* state_vars_array, double* ddsdde_array,
+                                      int* elastic_flag_array) = 0;
+
+      /// Makes sure the compacted batch arrays can hold npts_batch points
+      void SetupBatchArrays(const int npts_batch);
 
    public:
       ExaCMechModel(mfem::QuadratureFunction *_q_stress0, mfem::QuadratureFunction *_q_stress1,
@@ -53,55 +136,111 @@ class ExaCMechModel : public ExaModel
          const int size = _q_stress0->Size();
          const int npts = size / vdim;
          // Now initialize all of the vectors that we'll be using with our class
-         vel_grad_array = new mfem::Vector(npts * ecmech::ndim * ecmech::ndim, mfem::Device::GetMemoryType());
-         eng_int_array = new mfem::Vector(npts * ecmech::ne, mfem::Device::GetMemoryType());
          w_vec_array = new mfem::Vector(npts * ecmech::nwvec, mfem::Device::GetMemoryType());
          vol_ratio_array = new mfem::Vector(npts * ecmech::nvr, mfem::Device::GetMemoryType());
          stress_svec_p_array = new mfem::Vector(npts * ecmech::nsvp, mfem::Device::GetMemoryType());
          d_svec_p_array = new mfem::Vector(npts * ecmech::nsvp, mfem::Device::GetMemoryType());
          tempk_array = new mfem::Vector(npts, mfem::Device::GetMemoryType());
          sdd_array = new mfem::Vector(npts * ecmech::nsdd, mfem::Device::GetMemoryType());
-         eff_def_rate = new mfem::Vector(npts, mfem::Device::GetMemoryType());
          // If we're using a Device we'll want all of these vectors on it and staying there.
          // Also, note that UseDevice() only returns a boolean saying if it's on the device or not
          // rather than telling the vector whether or not it needs to lie on the device.
-         vel_grad_array->UseDevice(true); *vel_grad_array = 0.0;
-         eng_int_array->UseDevice(true); *eng_int_array = 0.0;
          w_vec_array->UseDevice(true); *w_vec_array = 0.0;
          vol_ratio_array->UseDevice(true); *vol_ratio_array = 0.0;
          stress_svec_p_array->UseDevice(true); *stress_svec_p_array = 0.0;
          d_svec_p_array->UseDevice(true); *d_svec_p_array = 0.0;
          tempk_array->UseDevice(true); *tempk_array = 0.0;
          sdd_array->UseDevice(true); *sdd_array = 0.0;
-         eff_def_rate->UseDevice(true); *eff_def_rate = 0.0;
       }
 
       virtual ~ExaCMechModel()
       {
-         delete vel_grad_array;
-         delete eng_int_array;
          delete w_vec_array;
          delete vol_ratio_array;
          delete stress_svec_p_array;
          delete d_svec_p_array;
          delete tempk_array;
          delete sdd_array;
-         delete eff_def_rate;
+         delete c_state_vars_array;
+         delete c_ddsdde_array;
+      }
+
+      /// Turns on the elastic fast path, where _elastic_ratio is the fraction of
+      /// the slip resistance the trial resolved shear stresses must stay below for
+      /// a point to be treated as elastic. This is only valid for the power law
+      /// slip kinetics models where the hardness state variable is the CRSS.
+      void SetElasticFastPath(const double _elastic_ratio)
+      {
+         const int npts = stress0->Size() / stress0->GetVDim();
+         elastic_fast_path = true;
+         elastic_ratio = _elastic_ratio;
+         elastic_flag.SetSize(npts, mfem::Device::GetMemoryType());
+         plastic_index.SetSize(npts, mfem::Device::GetMemoryType());
+      }
+
+      /// Sets the max number of points in a compacted batch, where 0 means
+      /// all of the points are compacted at once.
+      void SetBatchSize(const int _batch_size) { batch_size = _batch_size; }
+
+      /** Has the material kernel be called in chunks of _chunk_size points that are
+       *  spread across the OpenMP threads, rather than ExaCMech splitting all of the
+       *  points up statically. If dynamic is true the chunks are scheduled dynamically
+       *  and the points are ordered by the number of evaluations they took last step.
+       *  This does nothing if ExaConstit wasn't built with OpenMP.
+       */
+      void SetChunkedScheduling(const int _chunk_size, const bool dynamic);
+
+      /// Turns on the local sub-stepping of points that take more than _max_evals
+      /// evaluations, using at most _max_substeps sub-steps.
+      void SetSubstepping(const int _max_evals, const int _max_substeps);
+
+      /// Adds the time each OpenMP thread has spent in the chunked material kernel
+      /// to times, which is resized to the number of threads if needed.
+      void GetThreadTimes(std::vector<double> &times) const;
+
+      /// Restricts the model to only evaluate the quadrature points in pts, which
+      /// may be empty if none of our points are on this process.
+      void SetRegion(const mfem::Array<int> &pts)
+      {
+         region_only = true;
+         region_pts.SetSize(pts.Size(), mfem::Device::GetMemoryType());
+         region_pts.CopyFrom(pts.HostRead());
       }
 
+      /// Initializes the beginning step state variables of the points this model owns.
+      /// The constructor initializes all of the points, so a multi-region material
+      /// needs to call this for each region after all of them have been constructed.
+      virtual void InitStateVars() = 0;
+
+      /** Runs the set-up, material kernel, and post-processing for the points this
+       *  model owns. The beginning step stress and state variables are only read,
+       *  and every one of our points has its end step values written. A multi-region
+       *  model calls this for each of its regions, which all share the same arrays.
+       */
+      void RegionModelSetup(const int nqpts, const int nelems, const int nnodes,
+                            const double* jacobian_array, const double* loc_grad_array,
+                            const double* vel_array, const double* stress_beg,
+                            const double* state_vars_beg,
+                            double* state_vars_array, double* stress_array,
+                            double* ddsdde_array);
+
       /** This model takes in the velocity, det(jacobian), and local_grad/jacobian.
        *  It then computes velocity gradient symm and skw tensors and passes
        *  that to our material model in order to get out our Cauchy stress and
        * the material tangent matrix (d \sigma / d Vgrad_{sym}). It also
        * updates all of the state variables that live at the quadrature pts.
+       * The beginning step stress and state variables are only read, and the end
+       * step values of every point are written out by the kernels rather than
+       * being copied over from the beginning step first.
        */
       virtual void ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
                               const int nnodes, const mfem::Vector &jacobian,
                               const mfem::Vector &loc_grad, const mfem::Vector &vel);
 
       /// If we needed to do anything to our state variables once things are solved
-      /// for we do that here.
-      virtual void UpdateModelVars(){}
+      /// for we do that here. The cost order of the points is out of date once the
+      /// step is done.
+      virtual void UpdateModelVars() { cost_order_valid = false; }
 
       virtual void calcDpMat(mfem::QuadratureFunction &DpMat) const = 0;
 };
@@ -118,6 +257,8 @@ class ECMechXtalModel : public ExaCMechModel
       int ind_dp_eff, ind_eql_pl_strain, ind_pl_work, ind_num_evals, ind_dev_elas_strain;
       int ind_quats, ind_hardness, ind_gdot, ind_vols, ind_int_eng;
       int num_hardness, num_slip, num_vols, num_int_eng;
+      // Initial values of the history variables
+      std::vector<double> hist_init;
 
    // Note to self: we might want to in the future add support for the calculation
    // of D^p_{eff} and \int D^p_{eff} dt for post processing needs
@@ -148,7 +289,9 @@ class ECMechXtalModel : public ExaCMechModel
          // Volume ratio stride
          strides.push_back(ecmech::nvr);
          // Internal energy stride
-         strides.push_back(ecmech::ne);
+         // The internal energy is read and written directly from the state variables,
+         // so it shares their stride.
+         strides.push_back(num_state_vars);
          // Stress vector stride
          strides.push_back(ecmech::nsvp);
          // History variable stride
@@ -193,6 +336,7 @@ class ECMechXtalModel : public ExaCMechModel
             std::string s_ieng = "int_eng";
             std::string s_rvol = "rel_vol";
             std::string s_est  = "elas_strain";
+            std::string s_nevals = "num_evals";
 
             std::pair<int, int>  i_sre = std::make_pair(ind_dp_eff, 1);
             std::pair<int, int>  i_se = std::make_pair(ind_eql_pl_strain, 1);
@@ -203,6 +347,7 @@ class ECMechXtalModel : public ExaCMechModel
             std::pair<int, int>  i_en = std::make_pair(ind_int_eng, ecmech::ne);
             std::pair<int, int>  i_rv = std::make_pair(ind_vols, 1);
             std::pair<int, int>  i_est = std::make_pair(ind_dev_elas_strain, ecmech::ntvec);
+            std::pair<int, int>  i_ne = std::make_pair(ind_num_evals, 1);
 
             qf_mapping[s_shrateEff] = i_sre;
             qf_mapping[s_shrEff] = i_se;
@@ -213,6 +358,7 @@ class ECMechXtalModel : public ExaCMechModel
             qf_mapping[s_ieng] = i_en;
             qf_mapping[s_rvol] = i_rv;
             qf_mapping[s_est] = i_est;
+            qf_mapping[s_nevals] = i_ne;
          }
 
          // Opts and strs are just empty vectors of int and strings
@@ -233,15 +379,19 @@ class ECMechXtalModel : public ExaCMechModel
          mat_model_base->complete();
          mat_model_base->setExecutionStrategy(accel);
 
-         std::vector<double> histInit;
          {
             std::vector<std::string> names;
             std::vector<bool>        plot;
             std::vector<bool>        state;
-            mat_model_base->getHistInfo(names, histInit, plot, state);
+            mat_model_base->getHistInfo(names, hist_init, plot, state);
          }
 
-         init_state_vars(_q_matVars0, histInit);
+         init_state_vars(_q_matVars0, hist_init);
+      }
+
+      virtual void InitStateVars() override
+      {
+         init_state_vars(matVars0, hist_init);
       }
 
       /// This really shouldn't be used. It's only public due to the internal
@@ -259,28 +409,35 @@ class ECMechXtalModel : public ExaCMechModel
 
          int qf_size = (_q_matVars0->Size()) / (_q_matVars0->GetVDim());
 
-         int vdim = _q_matVars0->GetVDim();
+         const int pt_stride = GetStatePtStride();
+         const int vs = GetStateVarStride();
+
+         // Only the points in our region are initialized if we have one
+         const bool has_region = region_only;
+         const int npts_init = has_region ? region_pts.Size() : qf_size;
+         const int* pts_index = has_region ? region_pts.Read() : nullptr;
 
-         mfem::MFEM_FORALL(i, qf_size, {
-            const int ind = i * vdim;
+         mfem::MFEM_FORALL(i_init, npts_init, {
+            const int i = has_region ? pts_index[i_init] : i_init;
+            const int ind = i * pt_stride;
 
-            state_vars[ind + ind_dp_eff] = histInit_vec[ind_dp_eff];
-            state_vars[ind + ind_eql_pl_strain] = histInit_vec[ind_eql_pl_strain];
-            state_vars[ind + ind_pl_work] = histInit_vec[ind_pl_work];
-            state_vars[ind + ind_num_evals] = histInit_vec[ind_num_evals];
-            state_vars[ind + ind_hardness] = histInit_vec[ind_hardness];
-            state_vars[ind + ind_vols] = 1.0;
+            state_vars[ind + ind_dp_eff * vs] = histInit_vec[ind_dp_eff];
+            state_vars[ind + ind_eql_pl_strain * vs] = histInit_vec[ind_eql_pl_strain];
+            state_vars[ind + ind_pl_work * vs] = histInit_vec[ind_pl_work];
+            state_vars[ind + ind_num_evals * vs] = histInit_vec[ind_num_evals];
+            state_vars[ind + ind_hardness * vs] = histInit_vec[ind_hardness];
+            state_vars[ind + ind_vols * vs] = 1.0;
 
             for (int j = 0; j < ecmech::ne; j++) {
-               state_vars[ind + ind_int_eng] = 0.0;
+               state_vars[ind + (ind_int_eng + j) * vs] = 0.0;
             }
 
             for (int j = 0; j < 5; j++) {
-               state_vars[ind + ind_dev_elas_strain + j] = histInit_vec[ind_dev_elas_strain + j];
+               state_vars[ind + (ind_dev_elas_strain + j) * vs] = histInit_vec[ind_dev_elas_strain + j];
             }
 
             for (int j = 0; j < num_slip; j++) {
-               state_vars[ind + ind_gdot + j] = histInit_vec[ind_gdot + j];
+               state_vars[ind + (ind_gdot + j) * vs] = histInit_vec[ind_gdot + j];
             }
          });
       }
@@ -290,30 +447,55 @@ class ECMechXtalModel : public ExaCMechModel
          auto slip_geom = mat_model->getSlipGeom();
          const int ind_slip = ind_gdot;
          const int npts = DpMat.GetSpace()->GetSize();
-         auto gdot = mfem::Reshape(matVars1->Read(), matVars1->GetVDim(), npts);
+         const double* state_vars = matVars1->Read();
+         const int pt_stride = GetStatePtStride();
+         const int vs = GetStateVarStride();
+         const int nslip = slip_geom.nslip;
+         // The shear rates might be stored in single precision
+         const bool gdot_reduced = (num_reduced > 0);
+         const int ind_q = GetStoredStateIndex(ind_quats);
          auto d_dpmat = mfem::Reshape(DpMat.Write(), 3, 3, npts);
 
          MFEM_ASSERT(DpMat.GetVDim() == 9, "DpMat needs to have a vdim of 9");
 
-         mfem::MFEM_FORALL(ipts, npts, {
+         // Only the points in our region are computed if we have one
+         const bool has_region = region_only;
+         const int npts_calc = has_region ? region_pts.Size() : npts;
+         const int* pts_index = has_region ? region_pts.Read() : nullptr;
+
+         mfem::MFEM_FORALL(i_calc, npts_calc, {
+            const int ipts = has_region ? pts_index[i_calc] : i_calc;
             // Initialize dphat to be 0.0 initially
             double dphat[ecmech::ntvec];
             for (int idvec = 0; idvec < ecmech::ntvec; idvec++) {
                dphat[idvec] = 0.0;
             }
+            // Pull out the shear rates and orientation since they're only
+            // contiguous for the array of structures layout
+            const double* state = &(state_vars[ipts * pt_stride]);
+            double gdot[slip_geom.nslip];
+            if (gdot_reduced) {
+               const float* gdot_f = reinterpret_cast<const float*>(&(state[ind_slip]));
+               for (int islip = 0; islip < nslip; islip++) {
+                  gdot[islip] = gdot_f[islip];
+               }
+            }
+            else {
+               for (int islip = 0; islip < nslip; islip++) {
+                  gdot[islip] = state[(ind_slip + islip) * vs];
+               }
+            }
+            double quat[ecmech::qdim];
+            for (int iq = 0; iq < ecmech::qdim; iq++) {
+               quat[iq] = state[(ind_q + iq) * vs];
+            }
             // Compute dphat in the crystal frame
-            ecmech::vecsVMa<ecmech::ntvec, slip_geom.nslip>(dphat, slip_geom.getP(), &gdot(ind_slip, ipts));
+            ecmech::vecsVMa<ecmech::ntvec, slip_geom.nslip>(dphat, slip_geom.getP(), gdot);
 
             // Calculated D^p in the crystal frame so we need to rotate things
             // back to the sample frame now
             double rot_mat[ecmech::ndim * ecmech::ndim];
-
-            // double quat[ecmech::qdim];
-            // quat[0] = gdot(ind_quats, ipts);
-            // quat[1] = gdot(ind_quats + 1, ipts);
-            // quat[2] = gdot(ind_quats + 2, ipts);
-            // quat[3] = gdot(ind_quats + 3, ipts);
-            ecmech::quat_to_tensor(rot_mat, &gdot(ind_quats, ipts));
+            ecmech::quat_to_tensor(rot_mat, quat);
             //
             double qr5x5_ls[ecmech::ntvec * ecmech::ntvec];
             ecmech::get_rot_mat_vecd(qr5x5_ls, rot_mat);
@@ -339,6 +521,279 @@ class ECMechXtalModel : public ExaCMechModel
          });
       }
 
+      /// The elastic update is a hypoelastic cubic update done in the lattice frame.
+      /// The lattice is rotated by the continuum spin, the deviatoric elastic strain
+      /// is incremented by the deviatoric deformation rate, and the pressure is
+      /// updated with the bulk modulus. It's a close approximation of what ExaCMech
+      /// does for a point with no plastic slip, but it's not identical.
+      virtual void ElasticTrialUpdate(const int nqpts, const int npts_cand, const int nnodes,
+                                      const int* pts_index,
+                                      const double* jacobian_array, const double* loc_grad_array,
+                                      const double* vel_array, const double* stress_beg_array,
+                                      const double* state_vars_beg_array, double* stress_array,
+                                      double* state_vars_array, double* ddsdde_array,
+                                      int* elastic_flag_array) override
+      {
+         auto slip_geom = mat_model->getSlipGeom();
+         const int nslip = slip_geom.nslip;
+         const bool compact = (pts_index != nullptr);
+         const int pt_stride = GetStatePtStride();
+         const int vs = GetStateVarStride();
+         const int nstatev_stored = matVars0->GetVDim();
+         const double dt_ = dt;
+         const double ratio = elastic_ratio;
+         const bool tangent = (ddsdde_array != nullptr);
+         // Cubic elastic constants come right after the density, heat capacity,
+         // and tolerance parameters
+         const double* props = matProps->HostRead();
+         const double c11 = props[3];
+         const double c12 = props[4];
+         const double c44 = props[5];
+         const double bulk_mod = (c11 + 2.0 * c12) / 3.0;
+         const double sqr2 = sqrt(2.0);
+         const double sqr3b2 = sqrt(1.5);
+         const int qdim = 4;
+
+         // These are all where things live in the stored state variables
+         const int ind_dp_eff_ = GetStoredStateIndex(ind_dp_eff);
+         const int ind_num_evals_ = GetStoredStateIndex(ind_num_evals);
+         const int ind_elas = GetStoredStateIndex(ind_dev_elas_strain);
+         const int ind_q = GetStoredStateIndex(ind_quats);
+         const int ind_h = GetStoredStateIndex(ind_hardness);
+         const int ind_gdot_ = ind_gdot;
+         const int ind_vols_ = GetStoredStateIndex(ind_vols);
+         const int ind_int_eng_ = GetStoredStateIndex(ind_int_eng);
+         const bool gdot_reduced = (num_reduced > 0);
+
+         mfem::MFEM_FORALL(i_cand, npts_cand, {
+            const int i_pts = compact ? pts_index[i_cand] : i_cand;
+            const int i_elems = i_pts / nqpts;
+            const int j_qpts = i_pts % nqpts;
+            const double* state_vars_beg = &(state_vars_beg_array[i_pts * pt_stride]);
+            const double* stress = &(stress_beg_array[i_pts * ecmech::nsvec]);
+            // Velocity gradient in col. major format
+            double L[ecmech::ndim * ecmech::ndim];
+            exaconstit::kernel::grad_calc_pt(nqpts, nnodes, i_elems, j_qpts, jacobian_array,
+                                             loc_grad_array, vel_array, L);
+            // Symmetric portion of our velocity gradient and its deviatoric part
+            double dmat[ecmech::ndim * ecmech::ndim];
+            for (int i = 0; i < 3; i++) {
+               for (int j = 0; j < 3; j++) {
+                  dmat[i + 3 * j] = 0.5 * (L[i + 3 * j] + L[j + 3 * i]);
+               }
+            }
+            const double tr_d = dmat[0] + dmat[4] + dmat[8];
+            double ddev[ecmech::ndim * ecmech::ndim];
+            for (int i = 0; i < 9; i++) {
+               ddev[i] = dmat[i];
+            }
+            ddev[0] -= tr_d / 3.0;
+            ddev[4] -= tr_d / 3.0;
+            ddev[8] -= tr_d / 3.0;
+
+            // Lattice rotation update using the continuum spin, since there's no plastic spin
+            double w[ecmech::ndim];
+            w[0] = 0.5 * (L[2 + 3 * 1] - L[1 + 3 * 2]);
+            w[1] = 0.5 * (L[0 + 3 * 2] - L[2 + 3 * 0]);
+            w[2] = 0.5 * (L[1 + 3 * 0] - L[0 + 3 * 1]);
+            const double w_norm = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+            double dq[qdim];
+            if (w_norm * dt_ > ecmech::idp_tiny_sqrt) {
+               const double half_angle = 0.5 * w_norm * dt_;
+               const double s = sin(half_angle) / w_norm;
+               dq[0] = cos(half_angle);
+               dq[1] = s * w[0];
+               dq[2] = s * w[1];
+               dq[3] = s * w[2];
+            }
+            else {
+               dq[0] = 1.0;
+               dq[1] = 0.5 * dt_ * w[0];
+               dq[2] = 0.5 * dt_ * w[1];
+               dq[3] = 0.5 * dt_ * w[2];
+            }
+            double q0[qdim];
+            for (int i = 0; i < qdim; i++) {
+               q0[i] = state_vars_beg[(ind_q + i) * vs];
+            }
+            double quat[qdim];
+            quat[0] = dq[0] * q0[0] - dq[1] * q0[1] - dq[2] * q0[2] - dq[3] * q0[3];
+            quat[1] = dq[0] * q0[1] + dq[1] * q0[0] + dq[2] * q0[3] - dq[3] * q0[2];
+            quat[2] = dq[0] * q0[2] - dq[1] * q0[3] + dq[2] * q0[0] + dq[3] * q0[1];
+            quat[3] = dq[0] * q0[3] + dq[1] * q0[2] - dq[2] * q0[1] + dq[3] * q0[0];
+            {
+               const double qnorm_inv = 1.0 / sqrt(quat[0] * quat[0] + quat[1] * quat[1] +
+                                                   quat[2] * quat[2] + quat[3] * quat[3]);
+               for (int i = 0; i < qdim; i++) {
+                  quat[i] *= qnorm_inv;
+               }
+            }
+            // Row major rotation matrix that takes us from the lattice to the sample frame
+            double rmat[ecmech::ndim * ecmech::ndim];
+            ecmech::quat_to_tensor(rmat, quat);
+
+            // Deviatoric elastic strain in the lattice frame as a symmetric tensor
+            double elas[ecmech::ndim * ecmech::ndim];
+            {
+               double ev[ecmech::ntvec];
+               for (int i = 0; i < ecmech::ntvec; i++) {
+                  ev[i] = state_vars_beg[(ind_elas + i) * vs];
+               }
+               const double t1 = ecmech::sqr2i * ev[0];
+               const double t2 = ecmech::sqr6i * ev[1];
+               elas[0] = t1 - t2;
+               elas[4] = -t1 - t2;
+               elas[8] = ecmech::sqr2b3 * ev[1];
+               elas[5] = elas[7] = ecmech::sqr2i * ev[4];
+               elas[2] = elas[6] = ecmech::sqr2i * ev[3];
+               elas[1] = elas[3] = ecmech::sqr2i * ev[2];
+            }
+            // elas += dt * R^T ddev R
+            for (int i = 0; i < 3; i++) {
+               for (int j = 0; j < 3; j++) {
+                  double tmp = 0.0;
+                  for (int k = 0; k < 3; k++) {
+                     for (int l = 0; l < 3; l++) {
+                        tmp += rmat[k * 3 + i] * ddev[k + 3 * l] * rmat[l * 3 + j];
+                     }
+                  }
+                  elas[i * 3 + j] += dt_ * tmp;
+               }
+            }
+
+            // Deviatoric Kirchhoff stress in the lattice frame
+            double tau_lat[ecmech::ndim * ecmech::ndim];
+            for (int i = 0; i < 3; i++) {
+               for (int j = 0; j < 3; j++) {
+                  tau_lat[i * 3 + j] = (i == j) ? (c11 - c12) * elas[i * 3 + j] : 2.0 * c44 * elas[i * 3 + j];
+               }
+            }
+            double tau_vecd[ecmech::ntvec];
+            tau_vecd[0] = ecmech::sqr2i * (tau_lat[0] - tau_lat[4]);
+            tau_vecd[1] = sqr3b2 * tau_lat[8];
+            tau_vecd[2] = sqr2 * tau_lat[1];
+            tau_vecd[3] = sqr2 * tau_lat[2];
+            tau_vecd[4] = sqr2 * tau_lat[5];
+
+            // Trial resolved shear stresses compared against the slip resistance
+            // The Schmid tensors are laid out the same as in calcDpMat
+            const double* P = slip_geom.getP();
+            double tau_max = 0.0;
+            for (int islip = 0; islip < nslip; islip++) {
+               double rss = 0.0;
+               for (int i = 0; i < ecmech::ntvec; i++) {
+                  rss += P[i * nslip + islip] * tau_vecd[i];
+               }
+               tau_max = fmax(tau_max, fabs(rss));
+            }
+
+            if (tau_max > ratio * state_vars_beg[ind_h * vs]) {
+               elastic_flag_array[i_cand] = 0;
+            }
+            else {
+               elastic_flag_array[i_cand] = 1;
+
+               // Start the end step state variables off from the beginning step ones
+               double* state_vars = &(state_vars_array[i_pts * pt_stride]);
+               for (int i = 0; i < nstatev_stored; i++) {
+                  state_vars[i * vs] = state_vars_beg[i * vs];
+               }
+               double* stress_end = &(stress_array[i_pts * ecmech::nsvec]);
+
+               const double vol0 = state_vars[ind_vols_ * vs];
+               const double vol1 = vol0 * exp(tr_d * dt_);
+               const double press0 = -ecmech::onethird * (stress[0] + stress[1] + stress[2]);
+               const double press1 = press0 - bulk_mod * tr_d * dt_;
+
+               // Cauchy stress = R tau_lat R^T / J - p I
+               double sig[ecmech::ndim * ecmech::ndim];
+               for (int i = 0; i < 3; i++) {
+                  for (int j = 0; j < 3; j++) {
+                     double tmp = 0.0;
+                     for (int k = 0; k < 3; k++) {
+                        for (int l = 0; l < 3; l++) {
+                           tmp += rmat[i * 3 + k] * tau_lat[k * 3 + l] * rmat[j * 3 + l];
+                        }
+                     }
+                     sig[i * 3 + j] = tmp / vol1;
+                  }
+                  sig[i * 3 + i] -= press1;
+               }
+
+               // Internal energy update using the mid-point stress power
+               double stress1[ecmech::nsvec];
+               stress1[0] = sig[0];
+               stress1[1] = sig[4];
+               stress1[2] = sig[8];
+               stress1[3] = sig[5];
+               stress1[4] = sig[2];
+               stress1[5] = sig[1];
+               const double d_svec[ecmech::nsvec] = { dmat[0], dmat[4], dmat[8],
+                                                      dmat[1 + 3 * 2], dmat[0 + 3 * 2], dmat[0 + 3 * 1] };
+               double spower = 0.0;
+               for (int i = 0; i < ecmech::nsvec; i++) {
+                  const double fac = (i < 3) ? 1.0 : 2.0;
+                  spower += fac * 0.5 * (stress[i] + stress1[i]) * d_svec[i];
+               }
+               state_vars[ind_int_eng_ * vs] += dt_ * 0.5 * (vol0 + vol1) * spower;
+
+               for (int i = 0; i < ecmech::nsvec; i++) {
+                  stress_end[i] = stress1[i];
+               }
+
+               // Remaining state variable updates. The hardness, accumulated shear,
+               // and plastic work don't change for an elastic update.
+               state_vars[(ind_elas + 0) * vs] = ecmech::sqr2i * (elas[0] - elas[4]);
+               state_vars[(ind_elas + 1) * vs] = sqr3b2 * elas[8];
+               state_vars[(ind_elas + 2) * vs] = sqr2 * elas[1];
+               state_vars[(ind_elas + 3) * vs] = sqr2 * elas[2];
+               state_vars[(ind_elas + 4) * vs] = sqr2 * elas[5];
+               for (int i = 0; i < qdim; i++) {
+                  state_vars[(ind_q + i) * vs] = quat[i];
+               }
+               if (gdot_reduced) {
+                  float* gdot_f = reinterpret_cast<float*>(&(state_vars[ind_gdot_]));
+                  for (int i = 0; i < nslip; i++) {
+                     gdot_f[i] = 0.0f;
+                  }
+               }
+               else {
+                  for (int i = 0; i < nslip; i++) {
+                     state_vars[(ind_gdot_ + i) * vs] = 0.0;
+                  }
+               }
+               state_vars[ind_dp_eff_ * vs] = 0.0;
+               state_vars[ind_num_evals_ * vs] = 0.0;
+               state_vars[ind_vols_ * vs] = vol1;
+
+               // Rotated cubic elastic tangent stiffness in Voigt notation
+               // C_ijkl = c12 d_ij d_kl + c44 (d_ik d_jl + d_il d_jk) + (c11 - c12 - 2 c44) sum_m R_im R_jm R_km R_lm
+               if (tangent) {
+                  double* ddsdde = &(ddsdde_array[i_pts * ecmech::nsvec * ecmech::nsvec]);
+                  const int voigt_i[ecmech::nsvec] = { 0, 1, 2, 1, 0, 0 };
+                  const int voigt_j[ecmech::nsvec] = { 0, 1, 2, 2, 2, 1 };
+                  const double aniso = c11 - c12 - 2.0 * c44;
+                  for (int a = 0; a < ecmech::nsvec; a++) {
+                     const int i = voigt_i[a];
+                     const int j = voigt_j[a];
+                     for (int b = 0; b < ecmech::nsvec; b++) {
+                        const int k = voigt_i[b];
+                        const int l = voigt_j[b];
+                        double cval = aniso * (rmat[i * 3 + 0] * rmat[j * 3 + 0] * rmat[k * 3 + 0] * rmat[l * 3 + 0] +
+                                               rmat[i * 3 + 1] * rmat[j * 3 + 1] * rmat[k * 3 + 1] * rmat[l * 3 + 1] +
+                                               rmat[i * 3 + 2] * rmat[j * 3 + 2] * rmat[k * 3 + 2] * rmat[l * 3 + 2]);
+                        cval += (i == j && k == l) ? c12 : 0.0;
+                        cval += (i == k && j == l) ? c44 : 0.0;
+                        cval += (i == l && j == k) ? c44 : 0.0;
+                        // Column major storage
+                        ddsdde[a + ecmech::nsvec * b] = cval / vol1;
+                     }
+                  }
+               }
+            }
+         });
+      }
+
       virtual ~ECMechXtalModel()
       {
          delete mat_model;
@@ -445,4 +900,157 @@ typedef ECMechXtalModel<ecmech::matModelEvptn_FCC_B> KinKMBalDDFCCModel;
 typedef ECMechXtalModel<ecmech::matModelEvptn_HCP_A> KinKMBalDDHCPModel;
 typedef ECMechXtalModel<ecmech::matModelEvptn_BCC_A> KinKMbalDDBCCModel;
 
+/** @brief A multi-phase material made up of several ExaCMech models, where each
+ *         model owns a region of the quadrature points.
+ *
+ * The regions all share the stress, state variable, and material tangent
+ * quadrature functions of this class, so they must all have the same state
+ * variable layout. Each region's points are gathered into a contiguous batch
+ * before being handed off to ExaCMech, and the results are scattered back into
+ * the shared quadrature functions for the assembly operations.
+ */
+class ExaCMechRegionModel : public ExaModel
+{
+   protected:
+      std::vector<ExaCMechModel*> regions;
+      /// Material properties of the regions that we own
+      std::vector<mfem::Vector*> region_props;
+
+   public:
+      ExaCMechRegionModel(mfem::QuadratureFunction *_q_stress0, mfem::QuadratureFunction *_q_stress1,
+                          mfem::QuadratureFunction *_q_matGrad, mfem::QuadratureFunction *_q_matVars0,
+                          mfem::QuadratureFunction *_q_matVars1,
+                          mfem::ParGridFunction* _beg_coords, mfem::ParGridFunction* _end_coords,
+                          mfem::Vector *_props, int _nProps, int _nStateVars, bool _PA) :
+         ExaModel(_q_stress0, _q_stress1, _q_matGrad, _q_matVars0, _q_matVars1,
+                  _beg_coords, _end_coords, _props, _nProps, _nStateVars, _PA) {}
+
+      virtual ~ExaCMechRegionModel()
+      {
+         for (auto model : regions) {
+            delete model;
+         }
+         for (auto props : region_props) {
+            delete props;
+         }
+      }
+
+      /// Adds a region made up of the quadrature points in pts. We take ownership of
+      /// the model, and of the material properties if they're provided.
+      void AddRegion(ExaCMechModel* model, const mfem::Array<int> &pts,
+                     mfem::Vector* props = nullptr)
+      {
+         MFEM_VERIFY(model->numStateVars == numStateVars,
+                     "ExaCMechRegionModel regions need the same number of state variables");
+         model->SetRegion(pts);
+         // The state variable layout is the same across regions so the
+         // visualization mapping from the first region works for all of them.
+         if (regions.size() == 0) {
+            qf_mapping = *(model->GetQFMapping());
+         }
+         regions.push_back(model);
+         if (props != nullptr) {
+            region_props.push_back(props);
+         }
+      }
+
+      /// Initializes the state variables of every region's points with that region's
+      /// model. This must be called once all of the regions have been added.
+      void InitStateVars()
+      {
+         for (auto model : regions) {
+            model->InitStateVars();
+         }
+      }
+
+      /// Turns on the chunked scheduling of the material kernel for every region
+      void SetChunkedScheduling(const int _chunk_size, const bool dynamic)
+      {
+         for (auto model : regions) {
+            model->SetChunkedScheduling(_chunk_size, dynamic);
+         }
+      }
+
+      /// Turns on the local sub-stepping of the material update for every region
+      void SetSubstepping(const int _max_evals, const int _max_substeps)
+      {
+         for (auto model : regions) {
+            model->SetSubstepping(_max_evals, _max_substeps);
+         }
+      }
+
+      /// Sets the max compacted batch size of every region
+      void SetBatchSize(const int _batch_size)
+      {
+         for (auto model : regions) {
+            model->SetBatchSize(_batch_size);
+         }
+      }
+
+      /// Adds up the time each OpenMP thread has spent in the material kernel
+      /// across all of the regions
+      void GetThreadTimes(std::vector<double> &times) const
+      {
+         for (auto model : regions) {
+            model->GetThreadTimes(times);
+         }
+      }
+
+      /// Switches the shared state variables over to the structure of arrays
+      /// layout. The data is only transposed once, and each region just needs
+      /// to know about the new layout.
+      virtual void UseSoAState(const bool convert = true) override
+      {
+         ExaModel::UseSoAState(convert);
+         for (auto model : regions) {
+            model->UseSoAState(false);
+         }
+      }
+
+      /// Every region has to have the block in the same spot for the shared state
+      /// variables to be packed once. The regions just need to know about the new layout.
+      virtual void UseReducedState(const int ind, const int num, const bool convert = true) override
+      {
+         for (auto model : regions) {
+            MFEM_VERIFY(*(model->GetQFMapping()) == qf_mapping,
+                        "All of the regions need the same state variable layout for single precision state variables");
+         }
+         ExaModel::UseReducedState(ind, num, convert);
+         for (auto model : regions) {
+            model->UseReducedState(ind, num, false);
+         }
+      }
+
+      /// Turns on the elastic fast path for every region
+      /// Every region needs to be a cubic PowerVoce or PowerVoceNL model, which
+      /// the option parsing checks.
+      void SetElasticFastPath(const double _elastic_ratio)
+      {
+         for (auto model : regions) {
+            model->SetElasticFastPath(_elastic_ratio);
+         }
+      }
+
+      /// Runs each of the regions' models on their own points. The regions only
+      /// read the beginning step values, and between them they write all of the
+      /// end step values, so nothing is copied over beforehand.
+      virtual void ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
+                              const int nnodes, const mfem::Vector &jacobian,
+                              const mfem::Vector &loc_grad, const mfem::Vector &vel);
+
+      virtual void UpdateModelVars()
+      {
+         for (auto model : regions) {
+            model->UpdateModelVars();
+         }
+      }
+
+      virtual void calcDpMat(mfem::QuadratureFunction &DpMat) const
+      {
+         for (auto model : regions) {
+            model->calcDpMat(DpMat);
+         }
+      }
+};
+
 #endif
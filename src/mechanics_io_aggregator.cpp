@@ -0,0 +1,165 @@
+#include "mechanics_io_aggregator.hpp"
+#include "mechanics_log.hpp"
+
+#include <algorithm>
+
+using namespace mfem;
+
+namespace {
+   // Used for all of our point to point messages on the group communicator
+   const int agg_tag = 4242;
+}
+
+ElemFieldAggregator::ElemFieldAggregator(ParMesh *_pmesh, const std::string &basename, const int _group_size)
+   : pmesh(_pmesh), group_size(std::max(_group_size, 1)), nvdims(0), nvals(0)
+{
+   int myid;
+   MPI_Comm_rank(pmesh->GetComm(), &myid);
+   const int group = myid / group_size;
+   // Splitting also gives us our own communicator so our messages can't get
+   // mixed up with any others
+   MPI_Comm_split(pmesh->GetComm(), group, myid, &group_comm);
+   MPI_Comm_rank(group_comm, &group_rank);
+   MPI_Comm_size(group_comm, &group_nprocs);
+   fname = basename + ".elem_fields." + std::to_string(group) + ".bin";
+}
+
+void ElemFieldAggregator::RegisterField(const std::string &name, const ParGridFunction *gf)
+{
+   MFEM_VERIFY(!initialized, "ElemFieldAggregator fields need to be registered before the 1st Save");
+   const ParFiniteElementSpace *fes = gf->ParFESpace();
+   const int vdim = fes->GetVDim();
+   MFEM_VERIFY(gf->Size() == vdim * pmesh->GetNE(),
+               "ElemFieldAggregator only supports fields with one value per element");
+   MFEM_VERIFY(vdim == 1 || fes->GetOrdering() == Ordering::byVDIM,
+               "ElemFieldAggregator needs fields with a byVDIM ordering");
+   names.push_back(name);
+   fields.push_back(gf);
+   vdims.push_back(vdim);
+}
+
+void ElemFieldAggregator::Initialize()
+{
+   const int nelems = pmesh->GetNE();
+   nvdims = 0;
+   for (const int vdim : vdims) {
+      nvdims += vdim;
+   }
+   nvals = nelems * nvdims;
+
+   // The element ids and the number of values per process only ever need to be
+   // gathered once.
+   std::vector<int> nelems_group;
+   if (group_rank == 0) {
+      nelems_group.resize(group_nprocs);
+   }
+   MPI_Gather(&nelems, 1, MPI_INT, nelems_group.data(), 1, MPI_INT, 0, group_comm);
+
+   std::vector<int64_t> ids(nelems);
+   for (int i = 0; i < nelems; i++) {
+      ids[i] = static_cast<int64_t>(pmesh->GetGlobalElementNum(i));
+   }
+
+   std::vector<int> displs;
+   std::vector<int64_t> ids_group;
+   int nelems_total = 0;
+   if (group_rank == 0) {
+      displs.resize(group_nprocs);
+      counts.resize(group_nprocs);
+      for (int i = 0; i < group_nprocs; i++) {
+         displs[i] = nelems_total;
+         counts[i] = nelems_group[i] * nvdims;
+         nelems_total += nelems_group[i];
+      }
+      ids_group.resize(nelems_total);
+   }
+   MPI_Gatherv(ids.data(), nelems, MPI_INT64_T, ids_group.data(), nelems_group.data(),
+               displs.data(), MPI_INT64_T, 0, group_comm);
+
+   if (group_rank == 0) {
+      recv_buf.resize(nelems_total * nvdims);
+      file.open(fname, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+      if (!file) {
+         MFEM_ABORT("Cannot open the aggregated element field file: " << fname);
+      }
+      const int32_t header[2] = { nelems_total, static_cast<int32_t>(names.size()) };
+      file.write(reinterpret_cast<const char*>(header), sizeof(header));
+      for (size_t i = 0; i < names.size(); i++) {
+         const int32_t len = names[i].size();
+         const int32_t vdim = vdims[i];
+         file.write(reinterpret_cast<const char*>(&len), sizeof(int32_t));
+         file.write(names[i].data(), len);
+         file.write(reinterpret_cast<const char*>(&vdim), sizeof(int32_t));
+      }
+      file.write(reinterpret_cast<const char*>(ids_group.data()), sizeof(int64_t) * nelems_total);
+   }
+
+   send_buf.resize(nvals);
+   initialized = true;
+}
+
+void ElemFieldAggregator::Save(const int cycle, const double time)
+{
+   CALI_CXX_MARK_SCOPE("elem_field_aggregator_save");
+   if (!initialized) {
+      Initialize();
+   }
+
+   // The last step's send needs to be done before its buffer can be refilled
+   if (send_pending) {
+      MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+      send_pending = false;
+   }
+
+   // The values are packed as [process][field][elem][vdim]
+   const int nelems = pmesh->GetNE();
+   double* buf = send_buf.data();
+   for (size_t i = 0; i < fields.size(); i++) {
+      const double* data = fields[i]->HostRead();
+      std::copy(data, data + nelems * vdims[i], buf);
+      buf += nelems * vdims[i];
+   }
+
+   if (group_rank != 0) {
+      MPI_Isend(send_buf.data(), nvals, MPI_DOUBLE, 0, agg_tag, group_comm, &send_req);
+      send_pending = true;
+      return;
+   }
+
+   std::vector<MPI_Request> reqs(group_nprocs - 1);
+   std::copy(send_buf.begin(), send_buf.end(), recv_buf.begin());
+   int offset = counts[0];
+   for (int i = 1; i < group_nprocs; i++) {
+      MPI_Irecv(&recv_buf[offset], counts[i], MPI_DOUBLE, i, agg_tag, group_comm, &reqs[i - 1]);
+      offset += counts[i];
+   }
+   MPI_Waitall(group_nprocs - 1, reqs.data(), MPI_STATUSES_IGNORE);
+
+   // Each field's values get written out contiguously for the whole group
+   const int32_t icycle = cycle;
+   file.write(reinterpret_cast<const char*>(&icycle), sizeof(int32_t));
+   file.write(reinterpret_cast<const char*>(&time), sizeof(double));
+   int field_offset = 0;
+   for (size_t j = 0; j < fields.size(); j++) {
+      int proc_offset = 0;
+      for (int i = 0; i < group_nprocs; i++) {
+         const int proc_nelems = (nvdims > 0) ? counts[i] / nvdims : 0;
+         const double* data = &recv_buf[proc_offset + field_offset * proc_nelems];
+         file.write(reinterpret_cast<const char*>(data), sizeof(double) * proc_nelems * vdims[j]);
+         proc_offset += counts[i];
+      }
+      field_offset += vdims[j];
+   }
+   file.flush();
+}
+
+ElemFieldAggregator::~ElemFieldAggregator()
+{
+   if (send_pending) {
+      MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+   }
+   if (file.is_open()) {
+      file.close();
+   }
+   MPI_Comm_free(&group_comm);
+}
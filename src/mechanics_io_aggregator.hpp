@@ -0,0 +1,79 @@
+#ifndef MECHANICS_IO_AGGREGATOR
+#define MECHANICS_IO_AGGREGATOR
+
+#include "mfem.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Aggregates the element fields (stress, orientations, dpeff, ...) of groups of
+/// processes onto a single aggregator process per group, which writes them out
+/// to one large binary file. This replaces the many small per process files of
+/// the usual data collections with one file per group of processes.
+///
+/// The processes are split up into consecutive groups of group_size processes,
+/// and the first process of each group is its aggregator. Every process ships its
+/// packed element fields to its aggregator with non-blocking sends, and only waits
+/// on them when it's time to send the next output step's data. The aggregator
+/// receives and writes its group's data in one go.
+///
+/// Only fields that live on order 0 L2 spaces with a byVDIM ordering (one set of
+/// values per element) can be registered. Each group's file,
+/// basename.elem_fields.<group>.bin, is laid out as follows in native byte order:
+///    int32 nelems, int32 nfields
+///    for each field: int32 name length, char name[length], int32 vdim
+///    int64 global_elem_ids[nelems]
+///    for each output step: int32 cycle, double time,
+///                          and for each field double data[nelems][vdim]
+/// The global element ids are the ParMesh's global element numbers.
+class ElemFieldAggregator
+{
+   private:
+      mfem::ParMesh *pmesh;
+      std::string fname;
+      int group_size;
+
+      MPI_Comm group_comm;
+      int group_rank;
+      int group_nprocs;
+
+      std::vector<std::string> names;
+      std::vector<const mfem::ParGridFunction*> fields;
+      std::vector<int> vdims;
+
+      /// Number of values each process of our group sends per output step,
+      /// which is only set on the aggregator
+      std::vector<int> counts;
+      /// Number of values per element summed over all of the fields
+      int nvdims;
+      int nvals;
+
+      /// The packed values of our fields that are being sent to the aggregator
+      std::vector<double> send_buf;
+      MPI_Request send_req;
+      bool send_pending = false;
+
+      std::vector<double> recv_buf;
+      std::ofstream file;
+      bool initialized = false;
+
+      /// Sets up the group's file and writes out its header. This is done the 1st
+      /// time Save is called, so every field is registered by then.
+      void Initialize();
+
+   public:
+      ElemFieldAggregator(mfem::ParMesh *_pmesh, const std::string &basename, const int _group_size);
+
+      /// Adds a field to the output, which must be an order 0 L2 field
+      void RegisterField(const std::string &name, const mfem::ParGridFunction *gf);
+
+      /// Ships our fields off to the aggregator, which writes out the whole
+      /// group's values for this step.
+      void Save(const int cycle, const double time);
+
+      ~ElemFieldAggregator();
+};
+
+#endif
@@ -77,5 +77,241 @@ void grad_calc(const int nqpts, const int nelems, const int nnodes,
     }); // end of forall loop for number of elements
 } // end of kernel_grad_calc
 
+void incr_def_grad_calc(const int npts, const double *def_grad_beg_data,
+                        const double *def_grad_end_data, double *incr_def_grad_data)
+{
+    const int dim = 3;
+    const int space_dim2 = dim * dim;
+
+    mfem::MFEM_FORALL(i_pts, npts, {
+        const double* F0 = &def_grad_beg_data[i_pts * space_dim2];
+        const double* F1 = &def_grad_end_data[i_pts * space_dim2];
+        double* Fincr = &incr_def_grad_data[i_pts * space_dim2];
+
+        const double detF0 = F0[0] * (F0[4] * F0[8] - F0[5] * F0[7]) -
+                             /* */ F0[1] * (F0[3] * F0[8] - F0[5] * F0[6]) +
+                             /* */ F0[2] * (F0[3] * F0[7] - F0[4] * F0[6]);
+        const double c_detF0 = 1.0 / detF0;
+        // inv(F0) stored in column major order
+        const double F0inv[space_dim2] = { c_detF0 * (F0[4] * F0[8] - F0[5] * F0[7]),
+                                           c_detF0 * (F0[2] * F0[7] - F0[1] * F0[8]),
+                                           c_detF0 * (F0[1] * F0[5] - F0[2] * F0[4]),
+                                           c_detF0 * (F0[5] * F0[6] - F0[3] * F0[8]),
+                                           c_detF0 * (F0[0] * F0[8] - F0[2] * F0[6]),
+                                           c_detF0 * (F0[2] * F0[3] - F0[0] * F0[5]),
+                                           c_detF0 * (F0[3] * F0[7] - F0[4] * F0[6]),
+                                           c_detF0 * (F0[1] * F0[6] - F0[0] * F0[7]),
+                                           c_detF0 * (F0[0] * F0[4] - F0[1] * F0[3]) };
+
+        for (int j = 0; j < dim; j++) {
+            for (int i = 0; i < dim; i++) {
+                double sum = 0.0;
+                for (int k = 0; k < dim; k++) {
+                    sum += F1[i + dim * k] * F0inv[k + dim * j];
+                }
+                Fincr[i + dim * j] = sum;
+            }
+        }
+    });
+} // end of incr_def_grad_calc
+
+void eulerian_strain_calc(const int npts, const double *def_grad_data, double *strain_data)
+{
+    const int dim = 3;
+    const int space_dim2 = dim * dim;
+
+    mfem::MFEM_FORALL(i_pts, npts, {
+        const double* F = &def_grad_data[i_pts * space_dim2];
+        double* E = &strain_data[i_pts * space_dim2];
+
+        const double detF = F[0] * (F[4] * F[8] - F[5] * F[7]) -
+                            /* */ F[1] * (F[3] * F[8] - F[5] * F[6]) +
+                            /* */ F[2] * (F[3] * F[7] - F[4] * F[6]);
+        const double c_detF = 1.0 / detF;
+        // inv(F) stored in column major order
+        const double Finv[space_dim2] = { c_detF * (F[4] * F[8] - F[5] * F[7]),
+                                          c_detF * (F[2] * F[7] - F[1] * F[8]),
+                                          c_detF * (F[1] * F[5] - F[2] * F[4]),
+                                          c_detF * (F[5] * F[6] - F[3] * F[8]),
+                                          c_detF * (F[0] * F[8] - F[2] * F[6]),
+                                          c_detF * (F[2] * F[3] - F[0] * F[5]),
+                                          c_detF * (F[3] * F[7] - F[4] * F[6]),
+                                          c_detF * (F[1] * F[6] - F[0] * F[7]),
+                                          c_detF * (F[0] * F[4] - F[1] * F[3]) };
+
+        // B^-1 = F^-T F^-1
+        for (int j = 0; j < dim; j++) {
+            for (int i = 0; i < dim; i++) {
+                double binv = 0.0;
+                for (int k = 0; k < dim; k++) {
+                    binv += Finv[k + dim * i] * Finv[k + dim * j];
+                }
+                E[i + dim * j] = -0.5 * binv;
+            }
+            E[j + dim * j] += 0.5;
+        }
+    });
+} // end of eulerian_strain_calc
+
+void elem_length_calc(const int npts, const double *jacobian_data, double *elem_length_data)
+{
+    const int dim = 3;
+    const int space_dim2 = dim * dim;
+
+    mfem::MFEM_FORALL(i_pts, npts, {
+        const double* J = &jacobian_data[i_pts * space_dim2];
+        const double detJ = J[0] * (J[4] * J[8] - J[5] * J[7]) -
+                            /* */ J[1] * (J[3] * J[8] - J[5] * J[6]) +
+                            /* */ J[2] * (J[3] * J[7] - J[4] * J[6]);
+        // It can also be approximated as the cube root of the element's volume,
+        // but the determinant is good enough for our needs
+        elem_length_data[i_pts] = cbrt(detJ);
+    });
+} // end of elem_length_calc
+
+void ComputeQptWeights(const mfem::ParFiniteElementSpace* fes, mfem::Vector &qpt_wts)
+{
+    mfem::Mesh *mesh = fes->GetMesh();
+    const mfem::FiniteElement &el = *fes->GetFE(0);
+    const mfem::IntegrationRule *ir = &(mfem::IntRules.Get(el.GetGeomType(), 2 * el.GetOrder() + 1));
+
+    const int nqpts = ir->GetNPoints();
+    const int nelems = fes->GetNE();
+    const int npts = nqpts * nelems;
+
+    // The mesh holds onto its geometric factors even after its nodes have moved,
+    // so we make sure we aren't handed ones from an old configuration.
+    mesh->DeleteGeometricFactors();
+    const mfem::GeometricFactors *geom = mesh->GetGeometricFactors(*ir, mfem::GeometricFactors::DETERMINANTS);
+
+    qpt_wts.SetSize(npts, mfem::Device::GetMemoryType());
+    qpt_wts.UseDevice(true);
+
+    const double* W = ir->GetWeights().Read();
+    const double* detJ = geom->detJ.Read();
+    double* wts = qpt_wts.Write();
+
+    mfem::MFEM_FORALL(i_pts, npts, {
+        wts[i_pts] = detJ[i_pts] * W[i_pts % nqpts];
+    });
+} // end of ComputeQptWeights
+
+void ComputeVolAvgTensors(const mfem::ParFiniteElementSpace* fes,
+                          const std::vector<const mfem::QuadratureFunction*> &qfs,
+                          const std::vector<bool> &vol_avg,
+                          mfem::Vector& tensors,
+                          const RTModel &class_device)
+{
+    mfem::Vector qpt_wts;
+    ComputeQptWeights(fes, qpt_wts);
+    ComputeVolAvgTensors(fes->GetComm(), qpt_wts, qfs, vol_avg, tensors, class_device);
+}
+
+void ComputeVolAvgTensors(MPI_Comm comm,
+                          const mfem::Vector &qpt_wts,
+                          const std::vector<const mfem::QuadratureFunction*> &qfs,
+                          const std::vector<bool> &vol_avg,
+                          mfem::Vector& tensors,
+                          const RTModel &class_device)
+{
+    // The quadrature function data is captured by value in our kernel so there's
+    // a limit on how many of them can be reduced in one pass.
+    const int max_qfs = 8;
+    const int nqfs = qfs.size();
+    MFEM_VERIFY(nqfs <= max_qfs, "ComputeVolAvgTensors can only reduce up to 8 QuadratureFunctions at a time");
+    MFEM_VERIFY(vol_avg.size() == qfs.size(), "ComputeVolAvgTensors needs a vol_avg value for every QuadratureFunction");
+
+    const int npts = qpt_wts.Size();
+
+    const bool on_device = (class_device == RTModel::CUDA);
+
+    // Slot 0 of the partial sums holds the volume and the components of each
+    // quadrature function follow it.
+    const double* qf_data[max_qfs];
+    int qf_vdim[max_qfs];
+    int qf_offset[max_qfs];
+    int ncomps = 1;
+    for (int i = 0; i < nqfs; i++) {
+        qf_data[i] = on_device ? qfs[i]->Read() : qfs[i]->HostRead();
+        qf_vdim[i] = qfs[i]->GetVDim();
+        qf_offset[i] = ncomps;
+        ncomps += qf_vdim[i];
+    }
+    for (int i = nqfs; i < max_qfs; i++) {
+        qf_data[i] = nullptr;
+        qf_vdim[i] = 0;
+        qf_offset[i] = 0;
+    }
+
+    // Every block of points gets its own set of partial sums, so no atomics or
+    // reducers are needed and the sums come out the same from run to run.
+    const int blk_size = on_device ? 256 : 1024;
+    const int nblocks = (npts + blk_size - 1) / blk_size;
+
+    mfem::Vector partials(nblocks * ncomps, mfem::Device::GetMemoryType());
+    partials.UseDevice(true);
+
+    const double* W = on_device ? qpt_wts.Read() : qpt_wts.HostRead();
+    double* partial_data = on_device ? partials.Write() : partials.HostWrite();
+
+    auto block_sum = [ = ] RAJA_HOST_DEVICE (int iblk) {
+        double* psum = &partial_data[iblk * ncomps];
+        for (int j = 0; j < ncomps; j++) {
+            psum[j] = 0.0;
+        }
+        const int ibeg = iblk * blk_size;
+        const int iend = (ibeg + blk_size < npts) ? ibeg + blk_size : npts;
+        for (int i_npts = ibeg; i_npts < iend; i_npts++) {
+            const double wts = W[i_npts];
+            psum[0] += wts;
+            for (int k = 0; k < nqfs; k++) {
+                const double* val = &(qf_data[k][i_npts * qf_vdim[k]]);
+                double* sum = &psum[qf_offset[k]];
+                for (int j = 0; j < qf_vdim[k]; j++) {
+                    sum[j] += wts * val[j];
+                }
+            }
+        }
+    };
+
+    RAJA::RangeSegment block_range(0, nblocks);
+    if (class_device == RTModel::CPU) {
+        RAJA::forall<RAJA::loop_exec>(block_range, block_sum);
+    }
+    #if defined(RAJA_ENABLE_OPENMP)
+    if (class_device == RTModel::OPENMP) {
+        RAJA::forall<RAJA::omp_parallel_for_exec>(block_range, block_sum);
+    }
+    #endif
+    #if defined(RAJA_ENABLE_CUDA)
+    if (class_device == RTModel::CUDA) {
+        RAJA::forall<RAJA::cuda_exec<128> >(block_range, block_sum);
+    }
+    #endif
+
+    std::vector<double> data(ncomps, 0.0);
+    const double* partial_host = partials.HostRead();
+    for (int iblk = 0; iblk < nblocks; iblk++) {
+        for (int j = 0; j < ncomps; j++) {
+            data[j] += partial_host[iblk * ncomps + j];
+        }
+    }
+
+    std::vector<double> global_data(ncomps);
+    MPI_Allreduce(data.data(), global_data.data(), ncomps, MPI_DOUBLE, MPI_SUM, comm);
+
+    // We need to multiply our tensor values by 1/V to get the appropriate
+    // average value for the tensor in the end.
+    const double inv_vol = 1.0 / global_data[0];
+    tensors.SetSize(ncomps - 1);
+    double* tensor_data = tensors.HostWrite();
+    for (int k = 0; k < nqfs; k++) {
+        const double scale = vol_avg[k] ? inv_vol : 1.0;
+        for (int j = 0; j < qf_vdim[k]; j++) {
+            tensor_data[qf_offset[k] - 1 + j] = scale * global_data[qf_offset[k] + j];
+        }
+    }
+} // end of ComputeVolAvgTensors
+
 }
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "option_types.hpp"
 #include "mfem/general/forall.hpp"
 
+#include <vector>
+
 namespace exaconstit {
 namespace kernel {
 /// Performs all the calculations related to calculating the gradient of a 3D vector field
@@ -15,115 +17,131 @@ namespace kernel {
 void grad_calc(const int nqpts, const int nelems, const int nnodes,
                 const double *jacobian_data, const double *loc_grad_data,
                 const double *field_data, double* field_grad_array);
-//Computes the volume average values of values that lie at the quadrature points
-template<bool vol_avg>
-void ComputeVolAvgTensor(const mfem::ParFiniteElementSpace* fes,
-                        const mfem::QuadratureFunction* qf,
-                        mfem::Vector& tensor, int size,
-                        RTModel &class_device)
-{
-    mfem::Mesh *mesh = fes->GetMesh();
-    const mfem::FiniteElement &el = *fes->GetFE(0);
-    const mfem::IntegrationRule *ir = &(mfem::IntRules.Get(el.GetGeomType(), 2 * el.GetOrder() + 1));;
 
-    const int nqpts = ir->GetNPoints();
-    const int nelems = fes->GetNE();
-    const int npts = nqpts * nelems;
+/// Calculates the incremental deformation gradient, F_incr = F_end F_beg^-1, at
+/// each of the npts quadrature points. All of the deformation gradients are
+/// 3x3 column major arrays.
+void incr_def_grad_calc(const int npts, const double *def_grad_beg_data,
+                        const double *def_grad_end_data, double *incr_def_grad_data);
 
-    const double* W = ir->GetWeights().Read();
-    const mfem::GeometricFactors *geom = mesh->GetGeometricFactors(*ir, mfem::GeometricFactors::DETERMINANTS);
+/// Calculates the Eulerian strain, e = 1/2 (I - F^-T F^-1), at each of the npts
+/// quadrature points. The deformation gradient and strain are 3x3 column major arrays.
+void eulerian_strain_calc(const int npts, const double *def_grad_data, double *strain_data);
 
-    double el_vol = 0.0;
-    int my_id;
-    MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
-    double data[size];
+/// Calculates the characteristic element length at each of the npts quadrature
+/// points, which is taken to be the cube root of det(J).
+void elem_length_calc(const int npts, const double *jacobian_data, double *elem_length_data);
 
-    const int DIM2 = 2;
-    std::array<RAJA::idx_t, DIM2> perm2 {{ 1, 0 } };
-    RAJA::Layout<DIM2> layout_geom = RAJA::make_permuted_layout({{ nqpts, nelems } }, perm2);
-
-    mfem::Vector wts(geom->detJ);
-    RAJA::View<double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > wts_view(wts.ReadWrite(), layout_geom);
-    RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > j_view(geom->detJ.Read(), layout_geom);
-
-    RAJA::RangeSegment default_range(0, npts);
+/// Calculates the gradient of a 3D vector field at a single quadrature point.
+/// The jacobian, local gradient, and field data have the same layouts as in
+/// grad_calc, and field_grad is a 3x3 column major array that is overwritten.
+/// The operations are done in the same order as grad_calc, so the two give
+/// identical results.
+MFEM_HOST_DEVICE inline
+void grad_calc_pt(const int nqpts, const int nnodes,
+                  const int i_elems, const int j_qpts,
+                  const double *jacobian_data, const double *loc_grad_data,
+                  const double *field_data, double* field_grad)
+{
+    const int dim = 3;
+    const double* J = &jacobian_data[dim * dim * (j_qpts + nqpts * i_elems)];
+    const double* field = &field_data[nnodes * dim * i_elems];
+    const double* loc_grad = &loc_grad_data[nnodes * dim * j_qpts];
 
-    mfem::MFEM_FORALL(i, nelems, {
-        const int nqpts_ = nqpts;
-        for (int j = 0; j < nqpts_; j++) {
-            wts_view(j, i) = j_view(j, i) * W[j];
-        }
-    });
+    const double J11 = J[0]; // 0,0
+    const double J21 = J[1]; // 1,0
+    const double J31 = J[2]; // 2,0
+    const double J12 = J[3]; // 0,1
+    const double J22 = J[4]; // 1,1
+    const double J32 = J[5]; // 2,1
+    const double J13 = J[6]; // 0,2
+    const double J23 = J[7]; // 1,2
+    const double J33 = J[8]; // 2,2
+    const double detJ = J11 * (J22 * J33 - J32 * J23) -
+                        /* */ J21 * (J12 * J33 - J32 * J13) +
+                        /* */ J31 * (J12 * J23 - J22 * J13);
+    const double c_detJ = 1.0 / detJ;
+    // adj(J) stored in column major order
+    const double A[dim * dim] = { c_detJ * ((J22 * J33) - (J23 * J32)),
+                                  c_detJ * ((J31 * J23) - (J21 * J33)),
+                                  c_detJ * ((J21 * J32) - (J31 * J22)),
+                                  c_detJ * ((J32 * J13) - (J12 * J33)),
+                                  c_detJ * ((J11 * J33) - (J13 * J31)),
+                                  c_detJ * ((J31 * J12) - (J11 * J32)),
+                                  c_detJ * ((J12 * J23) - (J22 * J13)),
+                                  c_detJ * ((J21 * J13) - (J11 * J23)),
+                                  c_detJ * ((J11 * J22) - (J12 * J21)) };
 
-    if (class_device == RTModel::CPU) {
-        const double* qf_data = qf->HostRead();
-        const double* wts_data = wts.HostRead();
-        for (int j = 0; j < size; j++) {
-            RAJA::ReduceSum<RAJA::seq_reduce, double> seq_sum(0.0);
-            RAJA::ReduceSum<RAJA::seq_reduce, double> vol_sum(0.0);
-            RAJA::forall<RAJA::loop_exec>(default_range, [ = ] (int i_npts){
-                const double* val = &(qf_data[i_npts * size]);
-                seq_sum += wts_data[i_npts] * val[j];
-                vol_sum += wts_data[i_npts];
-            });
-            data[j] = seq_sum.get();
-            el_vol = vol_sum.get();
-        }
-    }
-    #if defined(RAJA_ENABLE_OPENMP)
-    if (class_device == RTModel::OPENMP) {
-        const double* qf_data = qf->HostRead();
-        const double* wts_data = wts.HostRead();
-        for (int j = 0; j < size; j++) {
-            RAJA::ReduceSum<RAJA::omp_reduce_ordered, double> omp_sum(0.0);
-            RAJA::ReduceSum<RAJA::omp_reduce_ordered, double> vol_sum(0.0);
-            RAJA::forall<RAJA::omp_parallel_for_exec>(default_range, [ = ] (int i_npts){
-                const double* val = &(qf_data[i_npts * size]);
-                omp_sum += wts_data[i_npts] * val[j];
-                vol_sum += wts_data[i_npts];
-            });
-            data[j] = omp_sum.get();
-            el_vol = vol_sum.get();
-        }
+    for (int i = 0; i < dim * dim; i++) {
+        field_grad[i] = 0.0;
     }
-    #endif
-    #if defined(RAJA_ENABLE_CUDA)
-    if (class_device == RTModel::CUDA) {
-        const double* qf_data = qf->Read();
-        const double* wts_data = wts.Read();
-        for (int j = 0; j < size; j++) {
-            RAJA::ReduceSum<RAJA::cuda_reduce, double> cuda_sum(0.0);
-            RAJA::ReduceSum<RAJA::cuda_reduce, double> vol_sum(0.0);
-            RAJA::forall<RAJA::cuda_exec<1024> >(default_range, [ = ] RAJA_DEVICE(int i_npts){
-                const double* val = &(qf_data[i_npts * size]);
-                cuda_sum += wts_data[i_npts] * val[j];
-                vol_sum += wts_data[i_npts];
-            });
-            data[j] = cuda_sum.get();
-            el_vol = vol_sum.get();
+
+    for (int t = 0; t < dim; t++) {
+        for (int s = 0; s < dim; s++) {
+            for (int r = 0; r < nnodes; r++) {
+                for (int q = 0; q < dim; q++) {
+                    field_grad[q + dim * t] += field[r + nnodes * q] *
+                                               loc_grad[r + nnodes * s] * A[s + dim * t];
+                }
+            }
         }
     }
-    #endif
+}
 
-    for (int i = 0; i < size; i++) {
-        tensor[i] = data[i];
-    }
+/// Calculates the strain increment, D dt, in Voigt notation (11, 22, 33, 23, 13, 12)
+/// with engineering shear strains from the 3x3 column major velocity gradient.
+/// This is the form the surrogate model takes its strain increments in, so it's
+/// used both by the model and when saving off its training data.
+MFEM_HOST_DEVICE inline
+void strain_incr_voigt(const double* vgrad, const double dt, double* dstrain)
+{
+    dstrain[0] = vgrad[0] * dt;
+    dstrain[1] = vgrad[4] * dt;
+    dstrain[2] = vgrad[8] * dt;
+    dstrain[3] = (vgrad[5] + vgrad[7]) * dt;
+    dstrain[4] = (vgrad[2] + vgrad[6]) * dt;
+    dstrain[5] = (vgrad[1] + vgrad[3]) * dt;
+}
 
-    MPI_Allreduce(&data, tensor.HostReadWrite(), size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    if (vol_avg) {
-        double temp = el_vol;
+/// Computes the volume integrals of every component of several quadrature functions
+/// in a single pass over the quadrature points. Each block of points gets its own
+/// partial sums, which are then summed up in order on the host, and all of the
+/// results are summed across the processes with a single MPI_Allreduce.
+/// The results of each quadrature function are packed one after another in tensors
+/// in the order they appear in qfs. If vol_avg[i] is true the results of qfs[i] are
+/// divided by the total volume to give volume averages.
+/// All of the quadrature functions are assumed to be laid out as [npts][vdim] and
+/// to live on the quadrature space of the fes.
+void ComputeVolAvgTensors(const mfem::ParFiniteElementSpace* fes,
+                          const std::vector<const mfem::QuadratureFunction*> &qfs,
+                          const std::vector<bool> &vol_avg,
+                          mfem::Vector& tensors,
+                          const RTModel &class_device);
 
-        // Here we find what el_vol should be equal to
-        MPI_Allreduce(&temp, &el_vol, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+/// Same as above but with the quadrature point weights, detJ * W, already provided,
+/// so callers that hold onto the weights for the whole time step can reuse them.
+void ComputeVolAvgTensors(MPI_Comm comm,
+                          const mfem::Vector &qpt_wts,
+                          const std::vector<const mfem::QuadratureFunction*> &qfs,
+                          const std::vector<bool> &vol_avg,
+                          mfem::Vector& tensors,
+                          const RTModel &class_device);
 
-        // We meed to multiple by 1/V by our tensor values to get the appropriate
-        // average value for the tensor in the end.
-        double inv_vol = 1.0 / el_vol;
+/// Computes the integration weights, detJ * W, of every quadrature point of the
+/// fes's mesh in its current configuration. The weights are laid out as [nelems][nqpts].
+void ComputeQptWeights(const mfem::ParFiniteElementSpace* fes, mfem::Vector &qpt_wts);
 
-        for (int m = 0; m < size; m++) {
-            tensor[m] *= inv_vol;
-        }
-    }
+//Computes the volume average values of values that lie at the quadrature points
+template<bool vol_avg>
+void ComputeVolAvgTensor(const mfem::ParFiniteElementSpace* fes,
+                        const mfem::QuadratureFunction* qf,
+                        mfem::Vector& tensor, int size,
+                        RTModel &class_device)
+{
+    MFEM_VERIFY(size == qf->GetVDim(), "ComputeVolAvgTensor size needs to match the vdim of the QuadratureFunction");
+    std::vector<const mfem::QuadratureFunction*> qfs = { qf };
+    std::vector<bool> avgs = { vol_avg };
+    ComputeVolAvgTensors(fes, qfs, avgs, tensor, class_device);
 }
 }
 }
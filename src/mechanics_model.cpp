@@ -129,31 +129,108 @@ void computeDefGrad(QuadratureFunction *qf, ParFiniteElementSpace *fes,
    return;
 }
 
-// This method sets the end time step stress to the beginning step
-// and then returns the internal data pointer of the end time step
-// array.
-double* ExaModel::StressSetup()
+void ExaModel::UseSoAState(const bool convert)
 {
-   const double *stress_beg = stress0->Read();
-   double *stress_end = stress1->ReadWrite();
-   const int N = stress0->Size();
-   MFEM_FORALL(i, N, stress_end[i] = stress_beg[i]; );
+   if (soa_state) {
+      return;
+   }
 
-   return stress_end;
+   if (convert) {
+      const int nstatev = matVars0->GetVDim();
+      const int npts = matVars0->Size() / nstatev;
+      Vector tmp(matVars0->Size(), Device::GetMemoryType());
+      tmp.UseDevice(true);
+      double* tmp_data = tmp.Write();
+      for (auto qf : { matVars0, matVars1 }) {
+         const double* aos_data = qf->Read();
+         MFEM_FORALL(i, npts, {
+            for (int k = 0; k < nstatev; k++) {
+               tmp_data[i + k * npts] = aos_data[i * nstatev + k];
+            }
+         });
+         *qf = tmp;
+      }
+   }
+   soa_state = true;
 }
 
-// This methods set the end time step state variable array to the
-// beginning time step values and then returns the internal data pointer
-// of the end time step array.
-double* ExaModel::StateVarsSetup()
+void ExaModel::UseReducedState(const int ind, const int num, const bool convert)
 {
-   const double *state_vars_beg = matVars0->Read();
-   double *state_vars_end = matVars1->ReadWrite();
+   MFEM_VERIFY(!soa_state, "Single precision state variables require the array of structures layout");
+   MFEM_VERIFY(num_reduced == 0, "Only one block of state variables can be in single precision");
+   if (num <= 0) {
+      return;
+   }
+
+   const int vdim = matVars0->GetVDim();
+   const int num_packed = (num + 1) / 2;
+   const int vdim_red = vdim - num + num_packed;
+
+   if (convert) {
+      const int npts = matVars0->Size() / vdim;
+      for (auto qf : { matVars0, matVars1 }) {
+         Vector tmp(npts * vdim_red, Device::GetMemoryType());
+         tmp.UseDevice(true);
+         const double* full_data = qf->Read();
+         double* red_data = tmp.Write();
+         MFEM_FORALL(i, npts, {
+            const double* full = &(full_data[i * vdim]);
+            double* red = &(red_data[i * vdim_red]);
+            for (int k = 0; k < ind; k++) {
+               red[k] = full[k];
+            }
+            // Zero things out first so the padding float is always defined
+            for (int k = 0; k < num_packed; k++) {
+               red[ind + k] = 0.0;
+            }
+            float* red_f = reinterpret_cast<float*>(&(red[ind]));
+            for (int k = 0; k < num; k++) {
+               red_f[k] = static_cast<float>(full[ind + k]);
+            }
+            for (int k = ind + num; k < vdim; k++) {
+               red[k - num + num_packed] = full[k];
+            }
+         });
+         // The swap lets the old full precision data be freed
+         qf->Swap(tmp);
+         qf->SetVDim(vdim_red);
+      }
+   }
 
-   const int N = matVars0->Size();
-   MFEM_FORALL(i, N, state_vars_end[i] = state_vars_beg[i]; );
+   // The fields in the block no longer live in the stored state variables
+   // and anything after them has been shifted down.
+   for (auto it = qf_mapping.begin(); it != qf_mapping.end(); ) {
+      const int index = it->second.first;
+      if (index >= ind && index < ind + num) {
+         it = qf_mapping.erase(it);
+      }
+      else {
+         if (index >= ind + num) {
+            it->second.first = index - num + num_packed;
+         }
+         ++it;
+      }
+   }
+
+   ind_reduced = ind;
+   num_reduced = num;
+}
 
-   return state_vars_end;
+void ExaModel::GetReducedState(QuadratureFunction &qf) const
+{
+   MFEM_VERIFY(qf.GetVDim() == num_reduced, "GetReducedState needs a QuadratureFunction with a vdim of the number of reduced state variables");
+   const int vdim = matVars0->GetVDim();
+   const int npts = matVars0->Size() / vdim;
+   const int ind = ind_reduced;
+   const int num = num_reduced;
+   const double* state_vars = matVars0->Read();
+   double* red_data = qf.Write();
+   MFEM_FORALL(i, npts, {
+      const float* red_f = reinterpret_cast<const float*>(&(state_vars[i * vdim + ind]));
+      for (int k = 0; k < num; k++) {
+         red_data[i * num + k] = red_f[k];
+      }
+   });
 }
 
 // the getter simply returns the beginning step stress
@@ -264,10 +341,12 @@ void ExaModel::GetElementStateVars(const int elID, const int ipNum,
    }
 
    ir = &(qspace->GetElementIntRule(elID));
-   int elem_offset = qf_offset * ir->GetNPoints();
+   const int pt = elID * ir->GetNPoints() + ipNum;
+   const int pt_stride = GetStatePtStride();
+   const int var_stride = GetStateVarStride();
 
    for (int i = 0; i<numComps; ++i) {
-      stateVars[i] = qf_data[elID * elem_offset + ipNum * qf_offset + i];
+      stateVars[i] = qf_data[pt * pt_stride + i * var_stride];
    }
 
    ir = NULL;
@@ -306,10 +385,12 @@ void ExaModel::SetElementStateVars(const int elID, const int ipNum,
    }
 
    ir = &(qspace->GetElementIntRule(elID));
-   int elem_offset = qf_offset * ir->GetNPoints();
+   const int pt = elID * ir->GetNPoints() + ipNum;
+   const int pt_stride = GetStatePtStride();
+   const int var_stride = GetStateVarStride();
 
    for (int i = 0; i<qf_offset; ++i) {
-      qf_data[elID * elem_offset + ipNum * qf_offset + i] = stateVars[i];
+      qf_data[pt * pt_stride + i * var_stride] = stateVars[i];
    }
 
    ir = NULL;
@@ -6,6 +6,7 @@
 #include <utility>
 #include <unordered_map>
 #include <string>
+#include <limits>
 
 /// free function to compute the beginning step deformation gradient to store
 /// on a quadrature function
@@ -23,6 +24,23 @@ class ExaModel
 
       double dt, t;
 
+      /// If false the next ModelSetup call only needs to update the stress and
+      /// state variables, and the material tangent stiffness matrix may be skipped.
+      bool tangent_required = true;
+
+      /// If true the state variables are stored as a structure of arrays, so that
+      /// each state variable is contiguous across all of the quadrature points.
+      /// Otherwise, all of the state variables of a point are contiguous.
+      bool soa_state = false;
+
+      /// If num_reduced is greater than 0 then the block of state variables that
+      /// starts at ind_reduced is stored in single precision. The floats are packed
+      /// two to a double in place of the block, and the state variables after the
+      /// block are shifted down to follow them. The indices used everywhere else
+      /// are still the full double precision ones.
+      int ind_reduced = 0;
+      int num_reduced = 0;
+
       // --------------------------------------------------------------------------
       // The velocity method requires us to retain both the beggining and end time step
       // coordinates of the mesh. We need these to be able to compute the correct
@@ -139,6 +157,21 @@ class ExaModel
       /// Get delta timestep on the base model class
       double GetModelDt() { return dt; }
 
+      /// Set whether the material tangent stiffness matrix needs to be computed
+      /// by the next ModelSetup call. Callers that only need the stress, such as
+      /// line search trial residuals, can turn this off.
+      void SetTangentRequired(const bool tangent) { tangent_required = tangent; }
+
+      /// Whether the material tangent stiffness matrix is computed by ModelSetup
+      bool GetTangentRequired() const { return tangent_required; }
+
+      /// The ratio of the new time step to the current one suggested by the
+      /// material model during its last update, which is the min over this
+      /// process's points. Values below 1 mean the model had trouble integrating
+      /// over the current time step. Models that don't suggest a time step
+      /// return the max double value.
+      virtual double GetSuggestedDtRatio() const { return std::numeric_limits<double>::max(); }
+
       /// return a pointer to beginning step stress. This is used for output visualization
       mfem::QuadratureFunction *GetStress0() { return stress0; }
 
@@ -232,16 +265,6 @@ class ExaModel
       /// tensor
       void TransformMatGradTo4D();
 
-      /// This method sets the end time step stress to the beginning step
-      /// and then returns the internal data pointer of the end time step
-      /// array.
-      double* StressSetup();
-
-      /// This methods set the end time step state variable array to the
-      /// beginning time step values and then returns the internal data pointer
-      /// of the end time step array.
-      double* StateVarsSetup();
-
       /// This function calculates the plastic strain rate tensor (D^p) with
       /// a DpMat that's a full 3x3 matrix rather than a 6-dim vector just so
       /// we can re-use storage from the deformation gradient tensor.
@@ -253,6 +276,39 @@ class ExaModel
       {
          return &qf_mapping;
       }
+
+      /// Switches the state variables over to a structure of arrays layout. If
+      /// convert is true the current values in matVars0 and matVars1 are transposed
+      /// over to the new layout.
+      virtual void UseSoAState(const bool convert = true);
+
+      /// Whether the state variables are stored as a structure of arrays
+      bool GetStateSoA() const { return soa_state; }
+
+      /// The state variable k of point i is located at
+      /// i * GetStatePtStride() + k * GetStateVarStride() for either layout.
+      int GetStatePtStride() const { return soa_state ? 1 : matVars0->GetVDim(); }
+      int GetStateVarStride() const { return soa_state ? matVars0->Size() / matVars0->GetVDim() : 1; }
+
+      /// Switches the num state variables starting at ind over to single precision
+      /// storage, which shrinks the vdim of matVars0 and matVars1. If convert is
+      /// true the current values are packed into the new layout. The qf_mapping
+      /// entries within the block are removed and the ones after it are shifted.
+      virtual void UseReducedState(const int ind, const int num, const bool convert = true);
+
+      /// The number of state variables stored in single precision
+      int GetNumReducedState() const { return num_reduced; }
+
+      /// Unpacks the single precision state variables of matVars0 into qf, which
+      /// needs a vdim of GetNumReducedState()
+      void GetReducedState(mfem::QuadratureFunction &qf) const;
+
+      /// Where the full index k of a state variable lives in the stored state variables
+      /// for any k outside of the single precision block
+      int GetStoredStateIndex(const int k) const
+      {
+         return (k >= ind_reduced + num_reduced) ? k - num_reduced + (num_reduced + 1) / 2 : k;
+      }
 };
 
 #endif
\ No newline at end of file
@@ -6,9 +6,74 @@
 #include "mechanics_kernels.hpp"
 #include "RAJA/RAJA.hpp"
 #include "ECMech_const.h"
+#include <fstream>
+#include <vector>
 
 using namespace mfem;
 
+namespace {
+   // Picks out the ExaCMech model that goes with the crystal symmetry, slip kinetics,
+   // and hardening law that were chosen.
+   ExaCMechModel* CreateECMechModel(const XtalType xtal_type, const SlipType slip_type,
+                                    QuadratureFunction *q_sigma0, QuadratureFunction *q_sigma1,
+                                    QuadratureFunction *q_matGrad, QuadratureFunction *q_matVars0,
+                                    QuadratureFunction *q_matVars1,
+                                    ParGridFunction *beg_crds, ParGridFunction *end_crds,
+                                    Vector *matProps, const int nProps, const int nStateVars,
+                                    const double temp_k, const ecmech::ExecutionStrategy accel,
+                                    const bool partial_assembly)
+   {
+      // Our classes will initialize our deformation gradients and
+      // our local shape function gradients which are taken with respect
+      // to our initial mesh when 1st created.
+      if (xtal_type == XtalType::FCC) {
+         // Now we find out what slip kinetics and hardening law were chosen.
+         if (slip_type == SlipType::POWERVOCE) {
+            return new VoceFCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                    beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                    partial_assembly);
+         }
+         else if (slip_type == SlipType::POWERVOCENL) {
+            return new VoceNLFCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                      beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                      partial_assembly);
+         }
+         else if (slip_type == SlipType::MTSDD) {
+            return new KinKMBalDDFCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                          beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                          partial_assembly);
+         }
+      }
+      else if (xtal_type == XtalType::HCP) {
+         if (slip_type == SlipType::MTSDD) {
+            return new KinKMBalDDHCPModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                          beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                          partial_assembly);
+         }
+      }
+      else if (xtal_type == XtalType::BCC) {
+         // Now we find out what slip kinetics and hardening law were chosen.
+         if (slip_type == SlipType::POWERVOCE) {
+            return new VoceBCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                    beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                    partial_assembly);
+         }
+         else if (slip_type == SlipType::POWERVOCENL) {
+            return new VoceNLBCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                      beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                      partial_assembly);
+         }
+         else if (slip_type == SlipType::MTSDD) {
+            return new KinKMbalDDBCCModel(q_sigma0, q_sigma1, q_matGrad, q_matVars0, q_matVars1,
+                                          beg_crds, end_crds, matProps, nProps, nStateVars, temp_k, accel,
+                                          partial_assembly);
+         }
+      }
+      MFEM_ABORT("The ExaCMech xtal_type and slip_type combination is not supported.");
+      return nullptr;
+   }
+}
+
 
 NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
                                              Array<int> &ess_bdr,
@@ -26,7 +91,8 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
                                              ParGridFunction &end_crds,
                                              Vector &matProps,
                                              int nStateVars)
-   : NonlinearForm(&fes), fe_space(fes), x_ref(ref_crds), x_cur(end_crds), ess_bdr_comps(ess_bdr_comp)
+   : NonlinearForm(&fes), fe_space(fes), x_ref(ref_crds), x_cur(end_crds), pa_oper(nullptr),
+   prec_oper(nullptr), ess_bdr_comps(ess_bdr_comp)
 {
    CALI_CXX_MARK_SCOPE("mechop_class_setup");
    Vector * rhs;
@@ -44,6 +110,7 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
    SetEssentialBC(ess_bdr, ess_bdr_comps, rhs);
 
    assembly = options.assembly;
+   static_cond = options.static_cond;
 
    bool partial_assembly = false;
    if (assembly == Assembly::PA) {
@@ -58,6 +125,11 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
                                   &q_kinVars0, &beg_crds, &end_crds,
                                   &matProps, options.nProps, nStateVars, &fes, partial_assembly);
 
+      if (options.umat_threaded && options.rtmodel == RTModel::OPENMP) {
+         dynamic_cast<AbaqusUmatModel*>(model)->SetThreaded(true);
+      }
+      dynamic_cast<AbaqusUmatModel*>(model)->SetBatchSize(options.umat_batch_size);
+
       // Add the user defined integrator
       if (options.integ_type == IntegrationType::FULL) {
          Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<AbaqusUmatModel*>(model)));
@@ -67,11 +139,23 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
       }
 
    }
+   else if (options.mech_type == MechType::SURROGATE) {
+      model = new SurrogateModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
+                                 &beg_crds, &end_crds, &matProps, options.nProps, nStateVars,
+                                 options.surrogate_weights_file, partial_assembly);
+
+      // Add the user defined integrator
+      if (options.integ_type == IntegrationType::FULL) {
+         Hform->AddDomainIntegrator(new ExaNLFIntegrator(model));
+      }
+      else if (options.integ_type == IntegrationType::BBAR) {
+         Hform->AddDomainIntegrator(new ICExaNLFIntegrator(model));
+      }
+   }
    else if (options.mech_type == MechType::EXACMECH) {
-      // Time to go through a nice switch field to pick out the correct model to be run...
-      // Should probably figure a better way to do this in the future so this doesn't become
-      // one giant switch yard. Multiphase materials will probably require a complete revamp of things...
-      // First we check the xtal symmetry type
+      // CreateECMechModel picks out the correct model to be run based on the xtal
+      // symmetry type and slip kinetics, and multiphase materials get one of those
+      // for each region.
       ecmech::ExecutionStrategy accel = ecmech::ExecutionStrategy::CPU;
 
       if (options.rtmodel == RTModel::CPU) {
@@ -84,132 +168,105 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
          accel = ecmech::ExecutionStrategy::CUDA;
       }
 
-      if (options.xtal_type == XtalType::FCC) {
-         // Now we find out what slip kinetics and hardening law were chosen.
-         if (options.slip_type == SlipType::POWERVOCE) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new VoceFCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                     &beg_crds, &end_crds,
-                                     &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                     partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<VoceFCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<VoceFCCModel*>(model)));
-            }
+      if (options.regions.size() == 0) {
+         model = CreateECMechModel(options.xtal_type, options.slip_type, &q_sigma0, &q_sigma1,
+                                   &q_matGrad, &q_matVars0, &q_matVars1, &beg_crds, &end_crds,
+                                   &matProps, options.nProps, nStateVars, options.temp_k, accel,
+                                   partial_assembly);
+
+         if (options.ecmech_elastic_fast) {
+            dynamic_cast<ExaCMechModel*>(model)->SetElasticFastPath(options.ecmech_elastic_ratio);
          }
-         else if (options.slip_type == SlipType::POWERVOCENL) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new VoceNLFCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                       &beg_crds, &end_crds,
-                                       &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                       partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<VoceNLFCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<VoceNLFCCModel*>(model)));
-            }
+         dynamic_cast<ExaCMechModel*>(model)->SetBatchSize(options.ecmech_batch_size);
+         if (options.ecmech_chunk_size > 0 && options.rtmodel == RTModel::OPENMP) {
+            dynamic_cast<ExaCMechModel*>(model)->SetChunkedScheduling(options.ecmech_chunk_size,
+                                                                      options.ecmech_chunk_dynamic);
          }
-         else if (options.slip_type == SlipType::MTSDD) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new KinKMBalDDFCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                           &beg_crds, &end_crds,
-                                           &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                           partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<KinKMBalDDFCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<KinKMBalDDFCCModel*>(model)));
-            }
+         if (options.ecmech_substep_max_evals > 0 && options.rtmodel != RTModel::CUDA) {
+            dynamic_cast<ExaCMechModel*>(model)->SetSubstepping(options.ecmech_substep_max_evals,
+                                                                options.ecmech_max_substeps);
          }
       }
-      else if (options.xtal_type == XtalType::HCP) {
-         if (options.slip_type == SlipType::MTSDD) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new KinKMBalDDHCPModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                           &beg_crds, &end_crds,
-                                           &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                           partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<KinKMBalDDHCPModel*>(model)));
+      else {
+         // Multi-phase materials get a model for each region of element attributes,
+         // where region 0 is made up of all the elements that aren't in any of the
+         // user provided regions.
+         const int nregions = options.regions.size() + 1;
+         const int nelems = fes.GetNE();
+         const int nqpts = (nelems > 0) ? q_sigma0.Size() / (q_sigma0.GetVDim() * nelems) : 0;
+         std::vector<Array<int> > region_pts(nregions);
+         for (int ie = 0; ie < nelems; ie++) {
+            const int attr = fes.GetAttribute(ie);
+            int ireg = 0;
+            for (int ir = 1; ir < nregions; ir++) {
+               const auto &region = options.regions[ir - 1];
+               if ((attr >= region.attr_min) && (attr <= region.attr_max)) {
+                  ireg = ir;
+                  break;
+               }
             }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<KinKMBalDDHCPModel*>(model)));
+            for (int iq = 0; iq < nqpts; iq++) {
+               region_pts[ireg].Append(ie * nqpts + iq);
             }
          }
-      }
-      else if (options.xtal_type == XtalType::BCC) {
-         // Now we find out what slip kinetics and hardening law were chosen.
-         if (options.slip_type == SlipType::POWERVOCE) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new VoceBCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                     &beg_crds, &end_crds,
-                                     &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                     partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<VoceBCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<VoceBCCModel*>(model)));
+
+         auto region_model = new ExaCMechRegionModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0,
+                                                     &q_matVars1, &beg_crds, &end_crds, &matProps,
+                                                     options.nProps, nStateVars, partial_assembly);
+         // The region models only ever see the 2D material tangent, so only the
+         // region model needs to know about partial assembly.
+         region_model->AddRegion(CreateECMechModel(options.xtal_type, options.slip_type, &q_sigma0,
+                                                   &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
+                                                   &beg_crds, &end_crds, &matProps, options.nProps,
+                                                   nStateVars, options.temp_k, accel, false),
+                                 region_pts[0]);
+         for (int ir = 1; ir < nregions; ir++) {
+            const auto &region = options.regions[ir - 1];
+            Vector* props = new Vector();
+            std::ifstream iprops(region.props_file.c_str());
+            if (!iprops) {
+               MFEM_ABORT("Cannot open material properties file: " << region.props_file);
             }
+            props->Load(iprops, region.nProps);
+            props->UseDevice(true);
+            region_model->AddRegion(CreateECMechModel(region.xtal_type, region.slip_type, &q_sigma0,
+                                                      &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
+                                                      &beg_crds, &end_crds, props, region.nProps,
+                                                      nStateVars, options.temp_k, accel, false),
+                                    region_pts[ir], props);
          }
-         else if (options.slip_type == SlipType::POWERVOCENL) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new VoceNLBCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                       &beg_crds, &end_crds,
-                                       &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                       partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<VoceNLBCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<VoceNLBCCModel*>(model)));
-            }
+         region_model->InitStateVars();
+
+         if (options.ecmech_elastic_fast) {
+            region_model->SetElasticFastPath(options.ecmech_elastic_ratio);
          }
-         else if (options.slip_type == SlipType::MTSDD) {
-            // Our class will initialize our deformation gradients and
-            // our local shape function gradients which are taken with respect
-            // to our initial mesh when 1st created.
-            model = new KinKMbalDDBCCModel(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
-                                           &beg_crds, &end_crds,
-                                           &matProps, options.nProps, nStateVars, options.temp_k, accel,
-                                           partial_assembly);
-
-            // Add the user defined integrator
-            if (options.integ_type == IntegrationType::FULL) {
-               Hform->AddDomainIntegrator(new ExaNLFIntegrator(dynamic_cast<KinKMbalDDBCCModel*>(model)));
-            }
-            else if (options.integ_type == IntegrationType::BBAR) {
-               Hform->AddDomainIntegrator(new ICExaNLFIntegrator(dynamic_cast<KinKMbalDDBCCModel*>(model)));
-            }
+         region_model->SetBatchSize(options.ecmech_batch_size);
+         if (options.ecmech_chunk_size > 0 && options.rtmodel == RTModel::OPENMP) {
+            region_model->SetChunkedScheduling(options.ecmech_chunk_size, options.ecmech_chunk_dynamic);
          }
+         if (options.ecmech_substep_max_evals > 0 && options.rtmodel != RTModel::CUDA) {
+            region_model->SetSubstepping(options.ecmech_substep_max_evals, options.ecmech_max_substeps);
+         }
+         model = region_model;
+      }
+
+      // The state variables were all initialized in the usual layout, so they
+      // get transposed once here if the structure of arrays layout was asked for.
+      if (options.ecmech_soa_state) {
+         model->UseSoAState();
+      }
+      // Same thing for the shear rates if they're stored in single precision
+      if (options.ecmech_float_gdot) {
+         auto gdot_pair = model->GetQFMapping()->at("gdot");
+         model->UseReducedState(gdot_pair.first, gdot_pair.second);
+      }
+
+      // Add the user defined integrator
+      if (options.integ_type == IntegrationType::FULL) {
+         Hform->AddDomainIntegrator(new ExaNLFIntegrator(model));
+      }
+      else if (options.integ_type == IntegrationType::BBAR) {
+         Hform->AddDomainIntegrator(new ICExaNLFIntegrator(model));
       }
    }
 
@@ -218,14 +275,22 @@ NonlinearMechOperator::NonlinearMechOperator(ParFiniteElementSpace &fes,
       diag.SetSize(fe_space.GetTrueVSize(), Device::GetMemoryType());
       diag.UseDevice(true);
       diag = 1.0;
-      prec_oper = new MechOperatorJacobiSmoother(diag, Hform->GetEssentialTrueDofs());
+      prec_oper = new MechOperatorJacobiSmoother(diag, Hform->GetEssentialTrueDofs(), 1.0,
+                                                 options.krylov_mixed_prec);
    }
-   else if (assembly == Assembly::EA) {
+   else if (assembly == Assembly::EA && !static_cond) {
       pa_oper = new EANonlinearMechOperatorGradExt(Hform, Hform->GetEssentialTrueDofs());
       diag.SetSize(fe_space.GetTrueVSize(), Device::GetMemoryType());
       diag.UseDevice(true);
       diag = 1.0;
-      prec_oper = new MechOperatorJacobiSmoother(diag, Hform->GetEssentialTrueDofs());
+      prec_oper = new MechOperatorJacobiSmoother(diag, Hform->GetEssentialTrueDofs(), 1.0,
+                                                 options.krylov_mixed_prec);
+   }
+   else if (static_cond) {
+      // Static condensation works off of the element matrices for both the FULL
+      // and EA assembly options. The condensed system is preconditioned with AMG
+      // so we don't need our jacobi smoother here.
+      pa_oper = new EANonlinearMechOperatorGradExt(Hform, Hform->GetEssentialTrueDofs());
    }
 
    // So, we're going to originally support non tensor-product type elements originally.
@@ -280,6 +345,14 @@ ExaModel *NonlinearMechOperator::GetModel() const
    return model;
 }
 
+double NonlinearMechOperator::GetSuggestedDtRatio() const
+{
+   double ratio = model->GetSuggestedDtRatio();
+   double ratio_min;
+   MPI_Allreduce(&ratio, &ratio_min, 1, MPI_DOUBLE, MPI_MIN, fe_space.GetComm());
+   return ratio_min;
+}
+
 void NonlinearMechOperator::UpdateEssTDofs(const Array<int> &ess_bdr)
 {
    // Set the essential boundary conditions
@@ -304,22 +377,47 @@ void NonlinearMechOperator::Mult(const Vector &k, Vector &y) const
    }
    else if (assembly == Assembly::PA) {
       CALI_MARK_BEGIN("mechop_PAsetup");
-      model->TransformMatGradTo4D();
       // Assemble our operator
-      pa_oper->Assemble();
+      if (tangent_current) {
+         model->TransformMatGradTo4D();
+         pa_oper->Assemble();
+      }
+      else {
+         pa_oper->AssembleResidual();
+      }
       CALI_MARK_END("mechop_PAsetup");
       CALI_CXX_MARK_SCOPE("mechop_PAMult");
       pa_oper->MultVec(k, y);
    }
    else {
       CALI_MARK_BEGIN("mechop_EAsetup");
-      pa_oper->Assemble();
+      if (tangent_current) {
+         pa_oper->Assemble();
+      }
+      else {
+         pa_oper->AssembleResidual();
+      }
       CALI_MARK_END("mechop_EAsetup");
       CALI_CXX_MARK_SCOPE("mechop_EAMult");
       pa_oper->MultVec(k, y);
    }
 }
 
+void NonlinearMechOperator::UpdateTangent(const Vector &k) const
+{
+   CALI_CXX_MARK_SCOPE("mechop_UpdateTangent");
+   // Our coordinates are already up to date with k from the last Mult call.
+   tangent_eval = true;
+   Setup<false>(k);
+   if (assembly == Assembly::PA) {
+      model->TransformMatGradTo4D();
+      pa_oper->Assemble();
+   }
+   else if (assembly == Assembly::EA) {
+      pa_oper->Assemble();
+   }
+}
+
 template<bool upd_crds>
 void NonlinearMechOperator::Setup(const Vector &k) const
 {
@@ -345,6 +443,9 @@ void NonlinearMechOperator::Setup(const Vector &k) const
 
    SetupJacobianTerms();
 
+   model->SetTangentRequired(tangent_eval);
+   tangent_current = tangent_eval;
+
    // We can now make the call to our material model set-up stage...
    // Everything else that we need should live on the class.
    // Within this function the model just needs to produce the Cauchy stress
@@ -437,6 +538,21 @@ void NonlinearMechOperator::CalculateDeformationGradient(mfem::QuadratureFunctio
 
 }
 
+void NonlinearMechOperator::CalculateVelocityGradient(mfem::QuadratureFunction &vel_grad) const
+{
+   MFEM_VERIFY(mech_type != MechType::UMAT, "The velocity gradient isn't available for UMAT models");
+
+   const IntegrationRule *ir = &(IntRules.Get(fe_space.GetFE(0)->GetGeomType(), 2 * fe_space.GetFE(0)->GetOrder() + 1));
+
+   const int nqpts = ir->GetNPoints();
+   const int ndofs = fe_space.GetFE(0)->GetDof();
+   const int nelems = fe_space.GetNE();
+
+   // el_jac and el_x still hold the values used in the last call to Setup
+   vel_grad = 0.0;
+   exaconstit::kernel::grad_calc(nqpts, nelems, ndofs, el_jac.Read(), qpts_dshape.Read(), el_x.Read(), vel_grad.ReadWrite());
+}
+
 // Update the end coords used in our model
 void NonlinearMechOperator::UpdateEndCoords(const Vector& vel) const
 {
@@ -447,7 +563,21 @@ void NonlinearMechOperator::UpdateEndCoords(const Vector& vel) const
 Operator &NonlinearMechOperator::GetGradient(const Vector &x) const
 {
    CALI_CXX_MARK_SCOPE("mechop_getgrad");
-   if (assembly == Assembly::FULL) {
+   if (!tangent_current) {
+      UpdateTangent(x);
+   }
+
+   if (static_cond) {
+      // The EA path already assembled our element matrices during the residual
+      // evaluation
+      if (assembly == Assembly::FULL) {
+         CALI_CXX_MARK_SCOPE("mechop_EAsetup");
+         pa_oper->Assemble();
+      }
+      Jacobian = pa_oper;
+      return *Jacobian;
+   }
+   else if (assembly == Assembly::FULL) {
       Jacobian = &Hform->GetGradient(x);
       return *Jacobian;
    }
@@ -468,16 +598,24 @@ Operator& NonlinearMechOperator::GetUpdateBCsAction(const Vector &k, const Vecto
    // We'll want to move this outside of Mult() at some given point in time
    // and have it live in the NR solver itself or whatever solver
    // we're going to be using.
+   // The BC update action makes use of the Jacobian so we always need the tangent here
+   tangent_eval = true;
    Setup<false>(k);
    // We now perform our element vector operation.
-   // We now perform our element vector operation.
    Vector resid(y); resid.UseDevice(true);
    if (assembly == Assembly::FULL) {
       CALI_CXX_MARK_SCOPE("mechop_Hform_LocalGrad");
       auto &loc_jacobian = Hform->GetLocalGradient2(x);
       loc_jacobian.Mult(x, y);
       Hform->Mult(k, resid);;
-      Jacobian = &Hform->GetGradient(x);
+      if (static_cond) {
+         CALI_CXX_MARK_SCOPE("mechop_EAsetup");
+         pa_oper->Assemble();
+         Jacobian = pa_oper;
+      }
+      else {
+         Jacobian = &Hform->GetGradient(x);
+      }
    }
    else if (assembly == Assembly::PA) {
       CALI_MARK_BEGIN("mechop_PAsetup");
@@ -515,7 +653,7 @@ NonlinearMechOperator::~NonlinearMechOperator()
 {
    delete model;
    delete Hform;
-   if (assembly != Assembly::FULL) {
+   if (pa_oper != nullptr) {
       delete pa_oper;
       // This will be deleted in the system driver class
       // before the preconditioner is deleted.
@@ -6,6 +6,7 @@
 #include "mechanics_integrators.hpp"
 #include "mechanics_model.hpp"
 #include "mechanics_umat.hpp"
+#include "mechanics_surrogate.hpp"
 #include "option_parser.hpp"
 #include "mechanics_operator_ext.hpp"
 
@@ -28,6 +29,13 @@ class NonlinearMechOperator : public mfem::NonlinearForm
       mutable MechOperatorJacobiSmoother *prec_oper;
       const mfem::Operator *elem_restrict_lex;
       Assembly assembly;
+      /// The Jacobian is handed off as element matrices to be statically condensed
+      bool static_cond;
+      /// Whether the next residual evaluation also needs to compute the material
+      /// tangent stiffness matrix
+      mutable bool tangent_eval = true;
+      /// Whether the material tangent from the last model evaluation is available
+      mutable bool tangent_current = false;
       /// nonlinear model
       ExaModel *model;
       /// Variable telling us if we should use the UMAT specific
@@ -69,6 +77,14 @@ class NonlinearMechOperator : public mfem::NonlinearForm
       /// Performs the action of our function / force vector
       virtual void Mult(const mfem::Vector &k, mfem::Vector &y) const override;
 
+      /// Sets whether the following calls to Mult() need the material tangent
+      /// stiffness matrix. Residual evaluations that are never followed by a
+      /// GetGradient() call, such as line search trials, should turn this off
+      /// so the material models only compute the stress. If GetGradient() is
+      /// called after a stress-only Mult() the model is re-evaluated with the
+      /// tangent turned on.
+      void SetTangentEval(const bool tangent) const { tangent_eval = tangent; }
+
       /// Sets all of the data up for the Mult and GetGradient method
       /// This is of significant interest to be able to do partial assembly operations.
       using mfem::NonlinearForm::Setup;
@@ -77,8 +93,17 @@ class NonlinearMechOperator : public mfem::NonlinearForm
       void Setup(const mfem::Vector &k) const;
 
       void SetupJacobianTerms() const;
+
+      /// Re-evaluates the model at k with the material tangent turned on and
+      /// reassembles any PA / EA operator data that depends on it.
+      void UpdateTangent(const mfem::Vector &k) const;
       void CalculateDeformationGradient(mfem::QuadratureFunction &def_grad) const;
 
+      // Computes the velocity gradient at the quadrature points using the velocity
+      // field and end step configuration from the last residual evaluation. This
+      // is only valid for the models that are given the velocity E-vector.
+      void CalculateVelocityGradient(mfem::QuadratureFunction &vel_grad) const;
+
       // We need the solver to update the end coords after each iteration has been complete
       // We'll also want to have a way to update the coords before we start running the simulations.
       // It might also allow us to set a velocity at every point, so we could test the models almost
@@ -93,6 +118,10 @@ class NonlinearMechOperator : public mfem::NonlinearForm
 
       ExaModel *GetModel() const;
 
+      /// The min over all of the processes of the time step ratio suggested by
+      /// the material model during the last residual evaluation.
+      double GetSuggestedDtRatio() const;
+
       MechOperatorJacobiSmoother *GetPAPreconditioner(){ return prec_oper; }
 
       virtual ~NonlinearMechOperator();
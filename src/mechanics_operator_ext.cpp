@@ -10,12 +10,15 @@ using namespace mfem;
 
 MechOperatorJacobiSmoother::MechOperatorJacobiSmoother(const Vector &d,
                                                        const Array<int> &ess_tdofs,
-                                                       const double dmpng)
+                                                       const double dmpng,
+                                                       const bool single_prec)
    :
    Solver(d.Size()),
    N(d.Size()),
-   dinv(N),
+   dinv(single_prec ? 0 : N),
+   dinv_sp(single_prec ? N : 0),
    damping(dmpng),
+   single_precision(single_prec),
    ess_tdof_list(ess_tdofs),
    residual(N)
 {
@@ -25,13 +28,20 @@ MechOperatorJacobiSmoother::MechOperatorJacobiSmoother(const Vector &d,
 void MechOperatorJacobiSmoother::Setup(const Vector &diag)
 {
    residual.UseDevice(true);
-   dinv.UseDevice(true);
    const double delta = damping;
    auto D = diag.Read();
-   auto DI = dinv.Write();
-   MFEM_FORALL(i, N, DI[i] = delta / D[i]; );
    auto I = ess_tdof_list.Read();
-   MFEM_FORALL(i, ess_tdof_list.Size(), DI[I[i]] = delta; );
+   if (single_precision) {
+      auto DI = dinv_sp.Write();
+      MFEM_FORALL(i, N, DI[i] = static_cast<float>(delta / D[i]); );
+      MFEM_FORALL(i, ess_tdof_list.Size(), DI[I[i]] = static_cast<float>(delta); );
+   }
+   else {
+      dinv.UseDevice(true);
+      auto DI = dinv.Write();
+      MFEM_FORALL(i, N, DI[i] = delta / D[i]; );
+      MFEM_FORALL(i, ess_tdof_list.Size(), DI[I[i]] = delta; );
+   }
 }
 
 void MechOperatorJacobiSmoother::Mult(const Vector &x, Vector &y) const
@@ -39,19 +49,45 @@ void MechOperatorJacobiSmoother::Mult(const Vector &x, Vector &y) const
    MFEM_ASSERT(x.Size() == N, "invalid input vector");
    MFEM_ASSERT(y.Size() == N, "invalid output vector");
 
-   if (iterative_mode && oper) {
+   // Without an initial guess the correction is just the scaled input, so it's
+   // written straight into y rather than first copying x and zeroing y.
+   const bool update = iterative_mode && oper;
+   if (update) {
       oper->Mult(y, residual); // r = A x
       subtract(x, residual, residual); // r = b - A x
    }
+   auto R = update ? residual.Read() : x.Read();
+   y.UseDevice(true);
+   auto Y = update ? y.ReadWrite() : y.Write();
+   if (single_precision) {
+      // The residual is rounded to single precision as it's read in, the
+      // correction is computed in single precision, and it's only converted
+      // back to double precision as it's written out. The single precision
+      // values never leave registers, so the only double precision traffic
+      // is the residual in and the correction out.
+      auto DI = dinv_sp.Read();
+      if (update) {
+         MFEM_FORALL(i, N, {
+            const float r_sp = static_cast<float>(R[i]);
+            Y[i] += static_cast<double>(DI[i] * r_sp);
+         });
+      }
+      else {
+         MFEM_FORALL(i, N, {
+            const float r_sp = static_cast<float>(R[i]);
+            Y[i] = static_cast<double>(DI[i] * r_sp);
+         });
+      }
+   }
    else {
-      residual = x;
-      y.UseDevice(true);
-      y = 0.0;
+      auto DI = dinv.Read();
+      if (update) {
+         MFEM_FORALL(i, N, Y[i] += DI[i] * R[i]; );
+      }
+      else {
+         MFEM_FORALL(i, N, Y[i] = DI[i] * R[i]; );
+      }
    }
-   auto DI = dinv.Read();
-   auto R = residual.Read();
-   auto Y = y.ReadWrite();
-   MFEM_FORALL(i, N, Y[i] += DI[i] * R[i]; );
 }
 
 NonlinearMechOperatorExt::NonlinearMechOperatorExt(NonlinearForm *_oper_mech)
@@ -92,6 +128,16 @@ void PANonlinearMechOperatorGradExt::Assemble()
    }
 }
 
+void PANonlinearMechOperatorGradExt::AssembleResidual()
+{
+   CALI_CXX_MARK_SCOPE("PA_AssembleResidual");
+   Array<NonlinearFormIntegrator*> &integrators = *oper_mech->GetDNFI();
+   const int num_int = integrators.Size();
+   for (int i = 0; i < num_int; ++i) {
+      integrators[i]->AssemblePA(*oper_mech->FESpace());
+   }
+}
+
 void PANonlinearMechOperatorGradExt::AssembleDiagonal(Vector &diag)
 {
    CALI_CXX_MARK_SCOPE("AssembleDiagonal");
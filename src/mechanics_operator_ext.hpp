@@ -41,6 +41,9 @@ class PANonlinearMechOperatorGradExt : public NonlinearMechOperatorExt
                                      const mfem::Array<int> &ess_tdofs);
 
       virtual void Assemble();
+      /// Only assembles the terms needed by MultVec, so the material tangent
+      /// stiffness matrix isn't needed.
+      virtual void AssembleResidual();
       virtual void AssembleDiagonal(mfem::Vector &diag);
       template<bool local_action>
       void TMult(const mfem::Vector &x, mfem::Vector &y) const;
@@ -74,6 +77,13 @@ class EANonlinearMechOperatorGradExt : public PANonlinearMechOperatorGradExt
 
       using PANonlinearMechOperatorGradExt::MultVec;
       // void MultVec(const mfem::Vector &x, mfem::Vector &y) const;
+
+      /// Returns the assembled element matrices. The data is laid out as
+      /// (elemDofs, elemDofs, NE) where A(i, j, e) is the transpose of the
+      /// element stiffness matrix, and the element dofs follow the
+      /// FiniteElementSpace::GetElementVDofs ordering.
+      const mfem::Vector &GetElementMatrices() const { return ea_data; }
+      int GetElementDofs() const { return elemDofs; }
 };
 
 /// Jacobi smoothing for a given bilinear form (no matrix necessary).
@@ -89,9 +99,14 @@ class MechOperatorJacobiSmoother  : public mfem::Solver
           the underlying operator acts as the identity on entries in ess_tdof_list,
           corresponding to (assembled) DIAG_ONE policy or ConstratinedOperator in
           the matrix-free setting. */
+      /** If @a single_prec is true the inverse diagonal is stored in single
+          precision, and the residual is rounded to single precision before
+          the correction is computed in single precision. Only the residual
+          and the correction are read and written in double precision. */
       MechOperatorJacobiSmoother(const mfem::Vector &d,
                                  const mfem::Array<int> &ess_tdofs,
-                                 const double damping = 1.0);
+                                 const double damping = 1.0,
+                                 const bool single_prec = false);
       ~MechOperatorJacobiSmoother() {}
 
       void Mult(const mfem::Vector &x, mfem::Vector &y) const;
@@ -103,7 +118,9 @@ class MechOperatorJacobiSmoother  : public mfem::Solver
    private:
       const int N;
       mfem::Vector dinv;
+      mfem::Array<float> dinv_sp;
       const double damping;
+      const bool single_precision;
       const mfem::Array<int> &ess_tdof_list;
       mutable mfem::Vector residual;
 
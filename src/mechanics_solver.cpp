@@ -1,6 +1,8 @@
 
 #include "mfem.hpp"
 #include "mechanics_solver.hpp"
+#include "mechanics_operator.hpp"
+#include "mechanics_static_cond.hpp"
 #include "mfem/linalg/linalg.hpp"
 #include "mfem/general/globals.hpp"
 #include "mechanics_log.hpp"
@@ -27,6 +29,7 @@ void ExaNewtonSolver::SetOperator(const Operator &op)
 void ExaNewtonSolver::SetOperator(const NonlinearForm &op)
 {
    oper_mech = &op;
+   oper_mech_ext = dynamic_cast<const NonlinearMechOperator*>(&op);
    oper = &op;
    height = op.Height();
    width = op.Width();
@@ -36,6 +39,32 @@ void ExaNewtonSolver::SetOperator(const NonlinearForm &op)
    c.SetSize(width, Device::GetMemoryType()); c.UseDevice(true);
 }
 
+void ExaNewtonSolver::SetTangentEval(const bool tangent) const
+{
+   if (oper_mech_ext != nullptr) {
+      oper_mech_ext->SetTangentEval(tangent);
+   }
+}
+
+bool ExaNewtonSolver::MaterialCutBack() const
+{
+   if (dt_ratio_check && oper_mech_ext != nullptr) {
+      return oper_mech_ext->GetSuggestedDtRatio() < 1.0;
+   }
+   return false;
+}
+
+void ExaNewtonSolver::CountKrylovIterations() const
+{
+   const Solver *lin_solver = prec;
+   if (auto sc_solver = dynamic_cast<const MechStaticCondSolver*>(lin_solver)) {
+      lin_solver = &sc_solver->GetCondensedSolver();
+   }
+   if (auto iter_solver = dynamic_cast<const IterativeSolver*>(lin_solver)) {
+      krylov_iters += iter_solver->GetNumIterations();
+   }
+}
+
 void ExaNewtonSolver::Mult(const Vector &b, Vector &x) const
 {
    CALI_CXX_MARK_SCOPE("NR_solver");
@@ -65,6 +94,8 @@ void ExaNewtonSolver::Mult(const Vector &b, Vector &x) const
    }
 
    norm0 = norm = norm_prev = Norm(r);
+   initial_norm = norm0;
+   krylov_iters = 0;
    norm_ratio = 1.0;
    // Set the value for the norm that we'll exit on
    norm_max = std::max(rel_tol * norm, abs_tol);
@@ -89,6 +120,15 @@ void ExaNewtonSolver::Mult(const Vector &b, Vector &x) const
          converged = 1;
          break;
       }
+      // The material model had trouble integrating over this time step, so
+      // there's no point in iterating any further on it
+      if (MaterialCutBack()) {
+         if (print_level >= 0) {
+            mfem::out << "The material model requested a smaller time step\n";
+         }
+         converged = 0;
+         break;
+      }
       // See if we've gone over the max number of desired iterations
       if (it >= max_iter) {
          converged = 0;
@@ -98,6 +138,7 @@ void ExaNewtonSolver::Mult(const Vector &b, Vector &x) const
       prec->SetOperator(oper_mech->GetGradient(x));
       CALI_MARK_BEGIN("krylov_solver");
       prec->Mult(r, c); // c = [DF(x_i)]^{-1} [F(x_i)-b]
+      CountKrylovIterations();
                         // ExaConstit may use GMRES here
 
       CALI_MARK_END("krylov_solver");
@@ -182,6 +223,8 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
    }
 
    norm0 = norm = Norm(r);
+   initial_norm = norm0;
+   krylov_iters = 0;
    // Set the value for the norm that we'll exit on
    norm_max = std::max(rel_tol * norm, abs_tol);
 
@@ -205,6 +248,15 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
          converged = 1;
          break;
       }
+      // The material model had trouble integrating over this time step, so
+      // there's no point in iterating any further on it
+      if (MaterialCutBack()) {
+         if (print_level >= 0) {
+            mfem::out << "The material model requested a smaller time step\n";
+         }
+         converged = 0;
+         break;
+      }
       // See if we've gone over the max number of desired iterations
       if (it >= max_iter) {
          converged = 0;
@@ -214,6 +266,7 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
       prec->SetOperator(oper_mech->GetGradient(x));
       CALI_MARK_BEGIN("krylov_solver");
       prec->Mult(r, c); // c = [DF(x_i)]^{-1} [F(x_i)-b]
+      CountKrylovIterations();
                         // ExaConstit may use GMRES here
       CALI_MARK_END("krylov_solver");
       // This line search method is based on the quadratic variation of the norm
@@ -222,6 +275,9 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
       // than this one.
       {
          CALI_CXX_MARK_SCOPE("Line Search");
+         // None of the trial residuals are followed by a Jacobian solve, so
+         // the material models only need to return the stress.
+         SetTangentEval(false);
          x_prev = x;
          add(x, -1.0, c, x);
          oper_mech->Mult(x, r);
@@ -254,6 +310,7 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
          }
 
          x = x_prev;
+         SetTangentEval(true);
       }
 
       const double c_scale = scale;
@@ -278,4 +335,110 @@ void ExaNewtonLSSolver::Mult(const Vector &b, Vector &x) const
 
    final_iter = it;
    final_norm = norm;
-}
\ No newline at end of file
+}
+
+ExaDirectSolver::ExaDirectSolver(MPI_Comm _comm, KrylovSolver _type)
+   : Solver(), comm(_comm), type(_type), solver(nullptr), row_loc_mat(nullptr)
+{
+   MFEM_VERIFY((type == KrylovSolver::SUPERLU) || (type == KrylovSolver::MUMPS) ||
+               (type == KrylovSolver::STRUMPACK), "ExaDirectSolver requires a direct solver type");
+}
+
+void ExaDirectSolver::SetOperator(const Operator &op)
+{
+   CALI_CXX_MARK_SCOPE("direct_solver_factor");
+   const HypreParMatrix *A = dynamic_cast<const HypreParMatrix*>(&op);
+   MFEM_VERIFY(A != nullptr, "ExaDirectSolver requires an assembled HypreParMatrix");
+
+   height = op.Height();
+   width = op.Width();
+
+   // The old distributed matrix is only deleted after the solver has been
+   // handed the new one, since the solver might still reference it until then.
+   Operator *old_mat = row_loc_mat;
+   const bool first_factorization = (solver == nullptr);
+
+   if (type == KrylovSolver::SUPERLU) {
+#if defined(MFEM_USE_SUPERLU)
+      SuperLUSolver *slu;
+      if (first_factorization) {
+         slu = new SuperLUSolver(comm);
+         slu->SetPrintStatistics(false);
+         slu->SetSymmetricPattern(false);
+         slu->SetColumnPermutation(superlu::PARMETIS);
+         slu->SetFact(superlu::DOFACT);
+         solver = slu;
+      }
+      else {
+         slu = static_cast<SuperLUSolver*>(solver);
+         // Reuse the column permutation and elimination tree from the
+         // first factorization
+         slu->SetFact(superlu::SamePattern);
+      }
+      row_loc_mat = new SuperLURowLocMatrix(*A);
+      slu->SetOperator(*row_loc_mat);
+#endif
+   }
+   else if (type == KrylovSolver::MUMPS) {
+#if defined(MFEM_USE_MUMPS)
+      MUMPSSolver *mumps;
+      if (first_factorization) {
+#if MFEM_VERSION >= 40600
+         mumps = new MUMPSSolver(comm);
+         // Only analyze the matrix the first time through
+         mumps->SetReorderingReuse(true);
+#else
+         // Older versions of MFEM redo the analysis phase on every SetOperator call
+         mumps = new MUMPSSolver();
+#endif
+         mumps->SetPrintLevel(0);
+         mumps->SetMatrixSymType(MUMPSSolver::MatType::UNSYMMETRIC);
+         solver = mumps;
+      }
+      else {
+         mumps = static_cast<MUMPSSolver*>(solver);
+      }
+      mumps->SetOperator(*A);
+#endif
+   }
+   else {
+#if defined(MFEM_USE_STRUMPACK)
+      STRUMPACKSolver *strumpack;
+      if (first_factorization) {
+         strumpack = new STRUMPACKSolver(0, nullptr, comm);
+         strumpack->SetPrintFactorStatistics(false);
+         strumpack->SetPrintSolveStatistics(false);
+         strumpack->SetKrylovSolver(strumpack::KrylovSolver::DIRECT);
+         strumpack->SetReorderingStrategy(strumpack::ReorderingStrategy::METIS);
+#if MFEM_VERSION >= 40600
+         // Only compute the fill-reducing ordering the first time through
+         strumpack->SetReorderingReuse(true);
+#endif
+         solver = strumpack;
+      }
+      else {
+         strumpack = static_cast<STRUMPACKSolver*>(solver);
+      }
+      row_loc_mat = new STRUMPACKRowLocMatrix(*A);
+      strumpack->SetOperator(*row_loc_mat);
+#endif
+   }
+
+   MFEM_VERIFY(solver != nullptr, "MFEM was not built with the requested direct solver");
+
+   if (old_mat != row_loc_mat) {
+      delete old_mat;
+   }
+}
+
+void ExaDirectSolver::Mult(const Vector &b, Vector &x) const
+{
+   CALI_CXX_MARK_SCOPE("direct_solver_solve");
+   solver->Mult(b, x);
+}
+
+ExaDirectSolver::~ExaDirectSolver()
+{
+   delete solver;
+   delete row_loc_mat;
+}
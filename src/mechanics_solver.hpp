@@ -3,7 +3,9 @@
 #define MECHANICS_SOLVER
 
 #include "mfem/linalg/solvers.hpp"
+#include "option_types.hpp"
 
+class NonlinearMechOperator;
 
 /// Newton's method for solving F(x)=b for a given operator F.
 /** The method GetGradient() must be implemented for the operator F.
@@ -14,6 +16,28 @@ class ExaNewtonSolver : public mfem::IterativeSolver
    protected:
       mutable mfem::Vector r, c;
       const mfem::NonlinearForm* oper_mech;
+      /// Set if oper_mech is a NonlinearMechOperator, which lets us request
+      /// stress-only residual evaluations
+      const NonlinearMechOperator* oper_mech_ext = nullptr;
+      /// Norm of the residual at the start of the last solve
+      mutable double initial_norm = 0.0;
+      /// Total number of linear solver iterations taken during the last solve
+      mutable int krylov_iters = 0;
+      /// If set the solve is stopped early as unconverged whenever the material
+      /// model suggests a smaller time step than the current one
+      bool dt_ratio_check = false;
+
+      /// Tells the operator whether the following residual evaluations need
+      /// the material tangent stiffness matrix
+      void SetTangentEval(const bool tangent) const;
+
+      /// Whether the material model asked for the time step to be cut back
+      /// during the last residual evaluation
+      bool MaterialCutBack() const;
+
+      /// Adds the number of iterations the linear solver took during its last
+      /// solve to krylov_iters. Direct solvers don't add anything.
+      void CountKrylovIterations() const;
 
    public:
       ExaNewtonSolver() { }
@@ -35,6 +59,18 @@ class ExaNewtonSolver : public mfem::IterativeSolver
       /** If `b.Size() != Height()`, then @a b is assumed to be zero. */
       virtual void Mult(const mfem::Vector &b, mfem::Vector &x) const;
 
+      /// Returns the residual norm at the start of the last solve. Along with
+      /// GetFinalNorm() and GetNumIterations() this gives the contraction rate
+      /// of the last solve.
+      double GetInitialNorm() const { return initial_norm; }
+
+      /// Returns the total number of linear solver iterations from the last solve
+      int GetKrylovIterations() const { return krylov_iters; }
+
+      /// Stops the solve early if the material model suggests a smaller time step.
+      /// This should only be turned on when the time step can be cut back.
+      void SetDtRatioCheck(const bool check) { dt_ratio_check = check; }
+
       // We're going to comment this out for now.
       /** @brief This method can be overloaded in derived classes to implement line
           search algorithms. */
@@ -70,4 +106,30 @@ class ExaNewtonLSSolver : public ExaNewtonSolver
 
 };
 
+/// Wrapper around MFEM's sparse direct solver interfaces for use as the
+/// Jacobian solver in the Newton method.
+/** The operator passed to SetOperator() must be an assembled HypreParMatrix.
+    Our Jacobian keeps the same sparsity pattern across Newton iterations and
+    time steps, so the fill-reducing ordering / symbolic factorization is only
+    computed for the first operator and reused afterwards. Only the numeric
+    factorization is redone each time SetOperator() is called. */
+class ExaDirectSolver : public mfem::Solver
+{
+   protected:
+      MPI_Comm comm;
+      KrylovSolver type;
+      mfem::Solver *solver;
+      /// Distributed matrix format needed by SuperLU_DIST and STRUMPACK
+      mfem::Operator *row_loc_mat;
+
+   public:
+      ExaDirectSolver(MPI_Comm _comm, KrylovSolver _type);
+
+      virtual void SetOperator(const mfem::Operator &op) override;
+
+      virtual void Mult(const mfem::Vector &b, mfem::Vector &x) const override;
+
+      virtual ~ExaDirectSolver();
+};
+
 #endif
@@ -0,0 +1,79 @@
+#include "mfem.hpp"
+#include "mechanics_static_cond.hpp"
+#include "mechanics_operator_ext.hpp"
+#include "mechanics_log.hpp"
+
+using namespace mfem;
+
+MechStaticCondSolver::MechStaticCondSolver(ParFiniteElementSpace &fes_,
+                                           const Array<int> &ess_tdofs,
+                                           Solver &solver)
+   : Solver(fes_.GetTrueVSize()), fes(fes_), ess_tdof_list(ess_tdofs),
+   sc_solver(solver), static_cond(nullptr)
+{
+   static_cond = new StaticCondensation(&fes);
+   R = fes.GetRestrictionMatrix();
+   b_vdof.SetSize(fes.GetVSize());
+   x_vdof.SetSize(fes.GetVSize());
+}
+
+void MechStaticCondSolver::SetOperator(const Operator &op)
+{
+   CALI_CXX_MARK_SCOPE("static_cond_setup");
+   const EANonlinearMechOperatorGradExt *ea_oper = dynamic_cast<const EANonlinearMechOperatorGradExt*>(&op);
+   MFEM_VERIFY(ea_oper != nullptr, "MechStaticCondSolver requires an element assembled operator");
+
+   height = op.Height();
+   width = op.Width();
+
+   // The Schur complement sparsity is built in Init and there isn't a way to
+   // zero out the old values in place, so we rebuild it every time our Jacobian
+   // changes. This is still cheap compared to the element assembly itself.
+   delete static_cond;
+   static_cond = new StaticCondensation(&fes);
+   static_cond->Init(false, false);
+
+   const int nelems = fes.GetNE();
+   const int ndofs = ea_oper->GetElementDofs();
+   const double *ea_data = ea_oper->GetElementMatrices().HostRead();
+
+   DenseMatrix elmat(ndofs);
+   for (int i = 0; i < nelems; i++) {
+      // The element assembly data is stored as the transpose of the element
+      // stiffness matrix so we need to swap it back here.
+      const DenseMatrix ea_mat(const_cast<double*>(&ea_data[i * ndofs * ndofs]), ndofs, ndofs);
+      elmat.Transpose(ea_mat);
+      static_cond->AssembleMatrix(i, elmat);
+   }
+
+   static_cond->SetEssentialTrueDofs(ess_tdof_list);
+   static_cond->Finalize();
+   // Our Newton updates are 0 on the essential dofs so we just need to
+   // eliminate them from the condensed system
+   static_cond->EliminateReducedTrueDofs(Matrix::DIAG_ONE);
+   static_cond->Finalize();
+   static_cond->ConvertListToReducedTrueDofs(ess_tdof_list, ess_rtdof_list);
+
+   HypreParMatrix &sc_mat = static_cond->GetParallelMatrix();
+   sc_b.SetSize(sc_mat.Height());
+   sc_x.SetSize(sc_mat.Height());
+   sc_solver.SetOperator(sc_mat);
+}
+
+void MechStaticCondSolver::Mult(const Vector &b, Vector &x) const
+{
+   CALI_CXX_MARK_SCOPE("static_cond_mult");
+   // Interior dofs are never shared between processors, so taking our
+   // true dof rhs and only placing it on the owned local dofs gives us
+   // back our true dof rhs after the parallel assembly in ReduceRHS.
+   R->MultTranspose(b, b_vdof);
+   static_cond->ReduceRHS(b_vdof, sc_b);
+   sc_b.SetSubVector(ess_rtdof_list, 0.0);
+
+   sc_x = 0.0;
+   sc_solver.Mult(sc_b, sc_x);
+
+   static_cond->ComputeSolution(b_vdof, sc_x, x_vdof);
+   R->Mult(x_vdof, x);
+   x.SetSubVector(ess_tdof_list, 0.0);
+}
@@ -0,0 +1,47 @@
+#ifndef MECHANICS_STATIC_COND
+#define MECHANICS_STATIC_COND
+
+#include "mfem.hpp"
+
+/// Linear solver for the Newton Jacobian that statically condenses out the
+/// element interior dofs before calling the provided solver.
+/** The operator passed to SetOperator() must be an
+    EANonlinearMechOperatorGradExt as the element matrices are used to form the
+    Schur complement on the exposed (vertex, edge, and face) dofs. The reduced
+    system is solved with the provided solver, which should be set up with a
+    preconditioner that can make use of an assembled HypreParMatrix such as
+    BoomerAMG. The interior dofs are then recovered element by element. */
+class MechStaticCondSolver : public mfem::Solver
+{
+   protected:
+      mfem::ParFiniteElementSpace &fes;
+      const mfem::Array<int> &ess_tdof_list;
+      /// Solver used on the condensed system - not owned
+      mfem::Solver &sc_solver;
+      mfem::StaticCondensation *static_cond;
+      const mfem::SparseMatrix *R;
+      mfem::Array<int> ess_rtdof_list;
+      mutable mfem::Vector b_vdof, x_vdof, sc_b, sc_x;
+
+   public:
+      MechStaticCondSolver(mfem::ParFiniteElementSpace &fes_,
+                           const mfem::Array<int> &ess_tdofs,
+                           mfem::Solver &solver);
+
+      /// Forms the condensed system from the element matrices of the operator
+      virtual void SetOperator(const mfem::Operator &op) override;
+
+      /// Solves the full system by condensing the rhs, solving the condensed
+      /// system, and then recovering the element interior dofs.
+      virtual void Mult(const mfem::Vector &b, mfem::Vector &x) const override;
+
+      /// Returns the solver used on the condensed system
+      const mfem::Solver &GetCondensedSolver() const { return sc_solver; }
+
+      /// Returns true if the finite element space has interior dofs to condense out
+      bool ReducesTrueVSize() const { return static_cond->ReducesTrueVSize(); }
+
+      virtual ~MechStaticCondSolver() { delete static_cond; }
+};
+
+#endif
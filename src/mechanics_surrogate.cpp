@@ -0,0 +1,172 @@
+#include "mfem.hpp"
+#include "mfem/general/forall.hpp"
+#include "mechanics_surrogate.hpp"
+#include "mechanics_kernels.hpp"
+#include "mechanics_log.hpp"
+#include <fstream>
+#include <cstdint>
+
+using namespace mfem;
+using namespace std;
+
+void SurrogateModel::LoadNetwork(const std::string &weights_file)
+{
+   std::ifstream ifile(weights_file, std::ios::binary);
+   if (!ifile) {
+      MFEM_ABORT("Cannot open surrogate model weights file: " << weights_file);
+   }
+
+   int32_t nlayers_file = 0;
+   ifile.read(reinterpret_cast<char*>(&nlayers_file), sizeof(int32_t));
+   MFEM_VERIFY(ifile && nlayers_file > 0, "Surrogate model weights file needs at least 1 layer");
+   nlayers = nlayers_file;
+
+   std::vector<int32_t> widths_file(nlayers + 1);
+   ifile.read(reinterpret_cast<char*>(widths_file.data()), sizeof(int32_t) * (nlayers + 1));
+   MFEM_VERIFY(ifile, "Surrogate model weights file ended early");
+   MFEM_VERIFY(widths_file[0] == nin, "Surrogate model needs " << nin << " inputs");
+   MFEM_VERIFY(widths_file[nlayers] == nout, "Surrogate model needs " << nout << " outputs");
+
+   widths.SetSize(nlayers + 1);
+   int nparams = 2 * nin + 2 * nout;
+   for (int i = 0; i <= nlayers; i++) {
+      MFEM_VERIFY(widths_file[i] > 0 && widths_file[i] <= max_width,
+                  "Surrogate model layer widths need to be between 1 and " << max_width);
+      widths[i] = widths_file[i];
+      if (i > 0) {
+         nparams += widths[i] * widths[i - 1] + widths[i];
+      }
+   }
+
+   params.SetSize(nparams, Device::GetMemoryType());
+   params.UseDevice(true);
+   ifile.read(reinterpret_cast<char*>(params.HostWrite()), sizeof(double) * nparams);
+   MFEM_VERIFY(ifile, "Surrogate model weights file ended early");
+}
+
+void SurrogateModel::ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
+                                const int nnodes, const Vector &jacobian,
+                                const Vector &loc_grad, const Vector &vel)
+{
+   CALI_CXX_MARK_SCOPE("surrogate_model_setup");
+   constexpr int nin_ = nin;
+   constexpr int nout_ = nout;
+   constexpr int max_width_ = max_width;
+   // The only network inputs we need derivatives with respect to are the strain increments
+   constexpr int nder = 6;
+
+   const int npts = nqpts * nelems;
+   const int nlayers_ = nlayers;
+   const int nstatev = numStateVars;
+   const double dt_ = dt;
+   const bool tangent = tangent_required;
+
+   const double* jacobian_array = jacobian.Read();
+   const double* loc_grad_array = loc_grad.Read();
+   const double* vel_array = vel.Read();
+   const int* widths_array = widths.Read();
+   const double* params_array = params.Read();
+   const double* stress_beg = stress0->Read();
+   double* stress_end = stress1->Write();
+   double* ddsdde_array = tangent ? matGrad->Write() : nullptr;
+
+   MFEM_FORALL(i_pts, npts, {
+      const int i_elems = i_pts / nqpts;
+      const int j_qpts = i_pts % nqpts;
+
+      double vgrad[9];
+      exaconstit::kernel::grad_calc_pt(nqpts, nnodes, i_elems, j_qpts, jacobian_array,
+                                       loc_grad_array, vel_array, vgrad);
+
+      // Our inputs are the strain increment and the beginning step stress
+      double x[nin_];
+      exaconstit::kernel::strain_incr_voigt(vgrad, dt_, x);
+      for (int i = 0; i < nout_; i++) {
+         x[nder + i] = stress_beg[i_pts * nout_ + i];
+      }
+
+      const double* in_mean = params_array;
+      const double* in_scale = &params_array[nin_];
+      const double* out_mean = &params_array[2 * nin_];
+      const double* out_scale = &params_array[2 * nin_ + nout_];
+      const double* layer = &params_array[2 * nin_ + 2 * nout_];
+
+      // The activations of the current layer and their derivatives with respect
+      // to the strain increments, which are stored as da[i * nder + k]
+      double a0[max_width_], da0[max_width_ * nder];
+      double a1[max_width_], da1[max_width_ * nder];
+      double* a = a0;
+      double* da = da0;
+      double* a_next = a1;
+      double* da_next = da1;
+
+      for (int i = 0; i < nin_; i++) {
+         const double inv_scale = 1.0 / in_scale[i];
+         a[i] = (x[i] - in_mean[i]) * inv_scale;
+         for (int k = 0; k < nder; k++) {
+            da[i * nder + k] = (i == k) ? inv_scale : 0.0;
+         }
+      }
+
+      for (int l = 0; l < nlayers_; l++) {
+         const int width_in = widths_array[l];
+         const int width_out = widths_array[l + 1];
+         const double* W = layer;
+         const double* b = &layer[width_out * width_in];
+         const bool hidden = (l < nlayers_ - 1);
+         for (int o = 0; o < width_out; o++) {
+            double z = b[o];
+            double dz[nder] = { 0.0 };
+            for (int i = 0; i < width_in; i++) {
+               const double w = W[o * width_in + i];
+               z += w * a[i];
+               for (int k = 0; k < nder; k++) {
+                  dz[k] += w * da[i * nder + k];
+               }
+            }
+            if (hidden) {
+               const double th = tanh(z);
+               const double dth = 1.0 - th * th;
+               a_next[o] = th;
+               for (int k = 0; k < nder; k++) {
+                  da_next[o * nder + k] = dth * dz[k];
+               }
+            }
+            else {
+               a_next[o] = z;
+               for (int k = 0; k < nder; k++) {
+                  da_next[o * nder + k] = dz[k];
+               }
+            }
+         }
+         layer = &b[width_out];
+         double* tmp = a; a = a_next; a_next = tmp;
+         tmp = da; da = da_next; da_next = tmp;
+      }
+
+      double* stress = &stress_end[i_pts * nout_];
+      for (int i = 0; i < nout_; i++) {
+         stress[i] = a[i] * out_scale[i] + out_mean[i];
+      }
+
+      // The tangent stiffness is saved in column major order
+      if (tangent) {
+         double* ddsdde = &ddsdde_array[i_pts * nout_ * nder];
+         for (int j = 0; j < nder; j++) {
+            for (int i = 0; i < nout_; i++) {
+               ddsdde[i + nout_ * j] = out_scale[i] * da[i * nder + j];
+            }
+         }
+      }
+   });
+
+   // We don't have any state variables of our own so they're just carried along
+   if (nstatev > 0) {
+      const double* state_vars_beg = matVars0->Read();
+      double* state_vars_end = matVars1->Write();
+      const int nsize = matVars0->Size();
+      MFEM_FORALL(i, nsize, {
+         state_vars_end[i] = state_vars_beg[i];
+      });
+   }
+}
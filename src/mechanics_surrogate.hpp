@@ -0,0 +1,81 @@
+#ifndef MECHANICS_SURROGATE
+#define MECHANICS_SURROGATE
+
+#include "mfem.hpp"
+#include "mechanics_model.hpp"
+
+#include <string>
+
+/// A surrogate material model that approximates the stress response with a
+/// small multilayer perceptron (MLP) rather than integrating a constitutive model.
+/// It's meant for screening type runs, such as calibration sweeps, where an
+/// approximate response is good enough.
+///
+/// The network's inputs are the strain increment, D dt, and the beginning step
+/// Cauchy stress, and its outputs are the end step Cauchy stress. All of these are
+/// in Voigt notation (11, 22, 33, 23, 13, 12) with engineering shear strains.
+/// The hidden layers use a tanh activation and the output layer is linear. The
+/// material tangent stiffness matrix is the derivative of the network's outputs
+/// with respect to the strain increment, which is computed alongside the forward pass.
+///
+/// The network is read from a binary file with the following layout in native
+/// byte order:
+///    int32 nlayers - the number of weight layers
+///    int32 widths[nlayers + 1] - the layer widths, where widths[0] = 12 and widths[nlayers] = 6
+///    double in_mean[12], in_scale[12] - inputs are normalized as (x - in_mean) / in_scale
+///    double out_mean[6], out_scale[6] - outputs are unnormalized as y * out_scale + out_mean
+///    for each layer: double W[widths[l + 1] * widths[l]] in row major order followed by
+///                    double b[widths[l + 1]]
+/// Training data for the network can be generated from ExaCMech runs through
+/// the Model.ExaCMech.surrogate_samples_floc option.
+///
+/// The model has no state variables of its own, so whatever state variables it's
+/// given are just carried along from one step to the next.
+class SurrogateModel : public ExaModel
+{
+   public:
+      /// Number of network inputs and outputs
+      static constexpr int nin = 12;
+      static constexpr int nout = 6;
+      /// The max width of any layer, which sets the size of the scratch space
+      /// used in our kernel
+      static constexpr int max_width = 64;
+
+   protected:
+      int nlayers;
+      /// The layer widths
+      mfem::Array<int> widths;
+      /// The normalization values followed by each layer's weights and biases
+      mfem::Vector params;
+
+      /// Reads the network in from the binary file
+      void LoadNetwork(const std::string &weights_file);
+
+   public:
+      SurrogateModel(mfem::QuadratureFunction *_q_stress0, mfem::QuadratureFunction *_q_stress1,
+                     mfem::QuadratureFunction *_q_matGrad, mfem::QuadratureFunction *_q_matVars0,
+                     mfem::QuadratureFunction *_q_matVars1,
+                     mfem::ParGridFunction* _beg_coords, mfem::ParGridFunction* _end_coords,
+                     mfem::Vector *_props, int _nProps, int _nStateVars,
+                     const std::string &weights_file, bool _PA) :
+         ExaModel(_q_stress0, _q_stress1, _q_matGrad, _q_matVars0, _q_matVars1,
+                  _beg_coords, _end_coords, _props, _nProps, _nStateVars, _PA)
+      {
+         LoadNetwork(weights_file);
+      }
+
+      virtual ~SurrogateModel() { }
+
+      /// This model takes in the velocity, det(jacobian), and local_grad/dmat
+      /// and evaluates the network at every quadrature point in a single kernel.
+      virtual void ModelSetup(const int nqpts, const int nelems, const int space_dim,
+                              const int nnodes, const mfem::Vector &jacobian,
+                              const mfem::Vector &loc_grad, const mfem::Vector &vel);
+
+      /// There's nothing that needs updating at the end of the step
+      virtual void UpdateModelVars() {}
+
+      virtual void calcDpMat(mfem::QuadratureFunction &/* DpMat */) const {};
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "mfem.hpp"
+#include "mechanics_timeseries.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+const char timeseries_magic[8] = { 'E', 'X', 'A', 'T', 'S', '0', '2', '\n' };
+}
+
+TimeSeriesWriter::TimeSeriesWriter(const std::string &_fname, const std::vector<std::string> &_columns,
+                                   const int _flush_records, const bool _dt_auto, const bool restart)
+   : fname(_fname), columns(_columns), dt_auto(_dt_auto), ncols(_columns.size()),
+     flush_records(std::max(_flush_records, 1))
+{
+   buffer.reserve(ncols * flush_records);
+   if (!restart) {
+      WriteHeader();
+   }
+}
+
+void TimeSeriesWriter::WriteHeader()
+{
+   file.open(fname, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+   if (!file) {
+      MFEM_ABORT("Cannot open the time series file: " << fname);
+   }
+
+   file.write(timeseries_magic, sizeof(timeseries_magic));
+   const int32_t icols = ncols;
+   file.write(reinterpret_cast<const char*>(&icols), sizeof(int32_t));
+   const int32_t idt_auto = dt_auto ? 1 : 0;
+   file.write(reinterpret_cast<const char*>(&idt_auto), sizeof(int32_t));
+   for (const auto &name : columns) {
+      const int32_t len = name.size();
+      file.write(reinterpret_cast<const char*>(&len), sizeof(int32_t));
+      file.write(name.data(), len);
+   }
+   file.flush();
+}
+
+void TimeSeriesWriter::Restart(const int step)
+{
+   MFEM_VERIFY(!file.is_open(), "TimeSeriesWriter::Restart needs to be called before anything is written");
+   const auto step_col = std::find(columns.begin(), columns.end(), "step");
+   MFEM_VERIFY(step_col != columns.end(), "TimeSeriesWriter::Restart needs a step column");
+   const size_t istep = step_col - columns.begin();
+
+   // The records we keep are read in and written back out after a new header,
+   // which leaves the file just as if the run had never been stopped.
+   std::vector<double> records;
+   {
+      std::ifstream ifile(fname, std::ios_base::binary);
+      if (ifile) {
+         char magic[8];
+         int32_t icols = 0;
+         int32_t idt_auto = 0;
+         ifile.read(magic, sizeof(magic));
+         ifile.read(reinterpret_cast<char*>(&icols), sizeof(int32_t));
+         ifile.read(reinterpret_cast<char*>(&idt_auto), sizeof(int32_t));
+         bool same = ifile && std::memcmp(magic, timeseries_magic, sizeof(magic)) == 0 &&
+                     static_cast<size_t>(icols) == ncols && (idt_auto != 0) == dt_auto;
+         for (size_t i = 0; same && i < ncols; i++) {
+            int32_t len = 0;
+            ifile.read(reinterpret_cast<char*>(&len), sizeof(int32_t));
+            std::string name(std::max(len, 0), ' ');
+            ifile.read(&name[0], name.size());
+            same = ifile && name == columns[i];
+         }
+         if (!same) {
+            MFEM_ABORT("The time series file " << fname << " doesn't match the current options, "
+                       "so it can't be continued from the checkpoint");
+         }
+
+         std::vector<double> record(ncols);
+         while (ifile.read(reinterpret_cast<char*>(record.data()), sizeof(double) * ncols)) {
+            if (record[istep] > step) {
+               break;
+            }
+            records.insert(records.end(), record.begin(), record.end());
+         }
+      }
+   }
+
+   WriteHeader();
+   file.write(reinterpret_cast<const char*>(records.data()), sizeof(double) * records.size());
+   file.flush();
+}
+
+void TimeSeriesWriter::Append(const std::vector<double> &record)
+{
+   MFEM_VERIFY(file.is_open(), "TimeSeriesWriter::Restart needs to be called before records are added");
+   MFEM_VERIFY(record.size() == ncols, "TimeSeriesWriter records need a value for every column");
+   buffer.insert(buffer.end(), record.begin(), record.end());
+   if (buffer.size() >= ncols * flush_records) {
+      Flush();
+   }
+}
+
+void TimeSeriesWriter::Flush()
+{
+   if (!file.is_open()) {
+      return;
+   }
+   if (buffer.size() > 0) {
+      file.write(reinterpret_cast<const char*>(buffer.data()), sizeof(double) * buffer.size());
+      buffer.clear();
+   }
+   file.flush();
+}
+
+TimeSeriesWriter::~TimeSeriesWriter()
+{
+   Flush();
+}
@@ -0,0 +1,57 @@
+#ifndef MECHANICS_TIMESERIES
+#define MECHANICS_TIMESERIES
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Buffered binary writer for time series of scalar values, such as the volume
+/// averages computed at the end of every time step. Records are held in memory
+/// and only written out every flush_records records, which avoids reopening and
+/// formatting text files every time step.
+///
+/// The file is laid out as follows in native byte order:
+///    char magic[8] = "EXATS02\n"
+///    int32 ncols
+///    int32 dt_auto - 1 if the time steps were picked automatically and 0 otherwise
+///    for each column: int32 name length, char name[length]
+///    followed by any number of records of double values[ncols]
+/// So after the header the data can be read in directly as a 2D array of doubles.
+/// scripts/postprocessing/avg_timeseries_to_text.py converts these files over to
+/// the usual average text files.
+class TimeSeriesWriter
+{
+   private:
+      std::string fname;
+      std::vector<std::string> columns;
+      bool dt_auto;
+      std::ofstream file;
+      size_t ncols;
+      size_t flush_records;
+      std::vector<double> buffer;
+
+      /// Opens the file and writes out the header
+      void WriteHeader();
+
+   public:
+      /// If restart is true the file isn't touched until Restart is called, so
+      /// the records from before the checkpoint can be kept.
+      TimeSeriesWriter(const std::string &_fname, const std::vector<std::string> &_columns,
+                       const int _flush_records, const bool _dt_auto, const bool restart = false);
+
+      /// Picks the file back up after a restart from a checkpoint at step. The records
+      /// up to and including step, given by the "step" column, are kept and everything
+      /// after them is dropped. The file needs to have the same header we would write,
+      /// and if it doesn't exist a new one is started.
+      void Restart(const int step);
+
+      /// Adds a record, which needs a value for every column
+      void Append(const std::vector<double> &record);
+
+      /// Writes out all of the buffered records
+      void Flush();
+
+      ~TimeSeriesWriter();
+};
+
+#endif
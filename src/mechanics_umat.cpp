@@ -2,12 +2,59 @@
 #include "BCManager.hpp"
 #include <math.h> // log
 #include <algorithm>
+#include <vector>
 #include <iostream> // cerr
 #include "RAJA/RAJA.hpp"
+#include "mechanics_kernels.hpp"
 
 using namespace mfem;
 using namespace std;
 
+namespace {
+// Calls the per point UMAT on a single point with all of the arguments that
+// ExaConstit doesn't make use of filled in.
+void umat_pt(int *nstatv, int *nprops, real8 *props, real8 *time, real8 *deltaTime,
+             real8 *celent, real8 *stran, real8 *dstran, real8 *drot, real8 *dfgrd0,
+             real8 *dfgrd1, real8 *stress, real8 *statev, real8 *ddsdde, real8 *pnewdt,
+             int *noel, int *npt)
+{
+   int ndi = 3; // number of direct stress components
+   int nshr = 3; // number of shear stress components
+   int ntens = ndi + nshr;
+   int layer = 0;
+   int kspt = 0;
+   int kstep = 0;
+   int kinc = 0;
+
+   double rpl = 0.0; // volumetric heat generation per unit time, not considered
+   double drpldt = 0.0; // variation of rpl wrt temperature set to 0.0
+   double tempk = 300.0; // no thermal considered at this point
+   double dtemp = 0.0; // no increment in thermal considered at this point
+   double predef = 0.0; // no interpolated values of predefined field variables at ip point
+   double dpred = 0.0; // no array of increments of predefined field variables
+   double sse = 0.0; // specific elastic strain energy, mainly for output
+   double spd = 0.0; // specific plastic dissipation, mainly for output
+   double scd = 0.0; // specific creep dissipation, mainly for output
+   double cmname = 0.0; // user defined UMAT name
+   // variation of the stress increments wrt to temperature, set to 0.0
+   double ddsdt[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+   // variation of rpl wrt strain increments, set to 0.0
+   double drplde[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+   // integration point coordinates
+   // a material model shouldn't need this ever
+   double coords[3] = { 0, 0, 0 };
+
+   // call c++ wrapper of umat routine
+   umat(stress, statev, ddsdde, &sse, &spd, &scd, &rpl,
+        ddsdt, drplde, &drpldt, stran, dstran, time,
+        deltaTime, &tempk, &dtemp, &predef, &dpred, &cmname,
+        &ndi, &nshr, &ntens, nstatv, props, nprops, &coords[0],
+        drot, pnewdt, celent, dfgrd0, dfgrd1,
+        noel, npt, &layer, &kspt, &kstep, &kinc);
+}
+} // End private namespace
+
 void AbaqusUmatModel::UpdateModelVars()
 {
    // update the beginning step deformation gradient
@@ -21,66 +68,64 @@ void AbaqusUmatModel::UpdateModelVars()
    }
 }
 
-// Work through the initialization of all of this...
-void AbaqusUmatModel::init_loc_sf_grads(ParFiniteElementSpace *fes)
+// The reference configuration Jacobians are saved off so the end step deformation
+// gradient can be computed with our grad_calc kernel. The model is created
+// before the mesh has moved, so the current nodes are the reference coordinates.
+void AbaqusUmatModel::init_ref_jacobian(ParFiniteElementSpace *fes)
 {
-   const FiniteElement *fe;
-   const IntegrationRule *ir;
+   Mesh *mesh = fes->GetMesh();
    QuadratureFunction* _defgrad0 = defGrad0;
    QuadratureSpace* qspace = _defgrad0->GetSpace();
 
-   ir = &(qspace->GetElementIntRule(0));
-
-   const int NE = fes->GetNE();
-   const int NQPTS = ir->GetNPoints();
-
-   // get element transformation for the 0th element
-   // We just want to get some basic stuff for now
-   fe = fes->GetFE(0);
-
-   // declare data to store shape function gradients
-   // and element Jacobians
-   DenseMatrix Jrt, DSh, DS;
-   int dof = fe->GetDof(), dim = fe->GetDim();
-   const int VDIM = dof * dim;
-
-   DSh.SetSize(dof, dim);
-   // This should probably be linked to the underlying quadrature function
-   DS.SetSize(dof, dim);
-   Jrt.SetSize(dim);
-
-   // We now have enough information to create our loc0_sf_grad
+   const IntegrationRule *ir = &(qspace->GetElementIntRule(0));
 
-   loc0_sf_grad.SetSpace(qspace, VDIM);
-   double* data = loc0_sf_grad.HostReadWrite();
-
-   // loop over elements
-   for (int i = 0; i < NE; ++i) {
-      // get element transformation for the ith element
-      ElementTransformation* Ttr = fes->GetElementTransformation(i);
-      fe = fes->GetFE(i);
+   const int space_dims = fes->GetFE(0)->GetDim();
+   const int nqpts = ir->GetNPoints();
+   const int nelems = fes->GetNE();
 
-      // PMatI.UseExternalData(el_x.ReadWrite(), dof, dim);
+   const GeometricFactors *geom = mesh->GetGeometricFactors(*ir, GeometricFactors::JACOBIANS);
 
-      ir = &(qspace->GetElementIntRule(i));
+   ref_jacobian.SetSize(space_dims * space_dims * nqpts * nelems, Device::GetMemoryType());
+   ref_jacobian.UseDevice(true);
 
-      // loop over integration points where the quadrature function is
-      // stored
-      for (int j = 0; j < NQPTS; ++j) {
-         // The offset is the current location of the data
-         int offset = (i * NQPTS * VDIM) + (j * VDIM);
-         double* data_offset = data + offset;
-
-         DS.UseExternalData(data_offset, dof, dim);
+   const int DIM4 = 4;
+   std::array<RAJA::idx_t, DIM4> perm4 {{ 3, 2, 1, 0 } };
+   // bunch of helper RAJA views to make dealing with data easier down below in our kernel.
+   RAJA::Layout<DIM4> layout_jacob = RAJA::make_permuted_layout({{ space_dims, space_dims, nqpts, nelems } }, perm4);
+   RAJA::View<double, RAJA::Layout<DIM4, RAJA::Index_type, 0> > jac_view(ref_jacobian.Write(), layout_jacob);
 
-         const IntegrationPoint &ip = ir->IntPoint(j);
-         Ttr->SetIntPoint(&ip);
-         CalcInverse(Ttr->Jacobian(), Jrt);
+   RAJA::Layout<DIM4> layout_geom = RAJA::make_permuted_layout({{ nqpts, space_dims, space_dims, nelems } }, perm4);
+   RAJA::View<const double, RAJA::Layout<DIM4, RAJA::Index_type, 0> > geom_j_view(geom->J.Read(), layout_geom);
 
-         fe->CalcDShape(ip, DSh);
-         Mult(DSh, Jrt, DS);
+   MFEM_FORALL(i, nelems,
+   {
+      const int nqpts_ = nqpts;
+      const int space_dims_ = space_dims;
+      for (int j = 0; j < nqpts_; j++) {
+         for (int k = 0; k < space_dims_; k++) {
+            for (int l = 0; l < space_dims_; l++) {
+               jac_view(l, k, j, i) = geom_j_view(j, l, k, i);
+            }
+         }
       }
-   }
+   });
+
+   mesh->DeleteGeometricFactors();
+
+   // The end step coordinates get restricted to the element dofs in the same
+   // ordering as our operator class uses.
+   elem_restrict = fes->GetElementRestriction(ElementDofOrdering::NATIVE);
+   el_end_coords.SetSize(elem_restrict->Height(), Device::GetMemoryType());
+   el_end_coords.UseDevice(true);
+
+   const int npts = nqpts * nelems;
+   const int space_dims2 = space_dims * space_dims;
+   strain.SetSize(npts * space_dims2, Device::GetMemoryType());
+   strain.UseDevice(true);
+   strain_incr.SetSize(npts * space_dims2, Device::GetMemoryType());
+   strain_incr.UseDevice(true);
+   elem_length.SetSize(npts, Device::GetMemoryType());
+   elem_length.UseDevice(true);
 }
 
 void AbaqusUmatModel::init_incr_end_def_grad()
@@ -99,10 +144,12 @@ void AbaqusUmatModel::init_incr_end_def_grad()
    const int VDIM = _defgrad0->GetVDim();
 
    incr_def_grad.SetSpace(qspace, VDIM);
+   incr_def_grad.UseDevice(true);
    incr_def_grad = 0.0;
    double* incr_data = incr_def_grad.HostReadWrite();
 
    end_def_grad.SetSpace(qspace, VDIM);
+   end_def_grad.UseDevice(true);
    end_def_grad = 0.0;
    double* end_data = end_def_grad.HostReadWrite();
 
@@ -129,82 +176,25 @@ void AbaqusUmatModel::init_incr_end_def_grad()
    }
 }
 
-void AbaqusUmatModel::calc_incr_end_def_grad(const Vector &x0)
+void AbaqusUmatModel::calc_incr_end_def_grad(const int nqpts, const int nelems, const int nnodes,
+                                             const Vector &jacobian, const Vector &loc_grad)
 {
-   const IntegrationRule *ir;
-   QuadratureFunction* _defgrad0 = defGrad0;
-   QuadratureSpace* qspace = _defgrad0->GetSpace();
-
-   ir = &(qspace->GetElementIntRule(0));
-
-   const int tot_qpts = qspace->GetSize();
-   const int nqpts = ir->GetNPoints();
-   // We've got the same type of elements everywhere so we can do this.
-   // If this assumption is no longer true we need to update the code
-   const int ne = tot_qpts / nqpts;
-   const int vdim = _defgrad0->GetVDim();
-   // We also assume we're only dealing with 3D type elements.
-   // If we aren't then this needs to change...
-   const int dim = 3;
-   const int vdim2 = loc0_sf_grad.GetVDim();
-   const int dof = vdim2 / dim;
-
-   double* incr_data = incr_def_grad.HostReadWrite();
-   double* end_data = end_def_grad.HostReadWrite();
-   double* int_data = _defgrad0->HostReadWrite();
-   double* ds_data = loc0_sf_grad.HostReadWrite();
-
-   ParGridFunction x_gf;
-   // This is quite dangerous potentially and we should try and fix this
-   // maybe with pargrid function or somewhere else
-   double* vals = const_cast<double*>(x0.HostRead());
-
-   x_gf.MakeTRef(loc_fes, vals);
-   x_gf.SetFromTrueVector();
-   x_gf.HostReadWrite();
-
-   DenseMatrix f_incr(dim, dim);
-   DenseMatrix f_end(dim, dim);
-   DenseMatrix f_beg(dim, dim);
-   DenseMatrix f_beg_invr(dim, dim);
-   DenseMatrix DS(dof, dim);
-   DenseMatrix PMatI(dof, dim);
-   // The below are constant but will change between steps
-   Array<int> vdofs(vdim2);
-   Vector el_x(PMatI.Data(), vdim2);
-
-   // loop over elements
-   for (int i = 0; i < ne; ++i) {
-      loc_fes->GetElementVDofs(i, vdofs);
-      // Our PMatI is now updated to the correct elemental values
-      x_gf.GetSubVector(vdofs, el_x);
-      // loop over integration points where the quadrature function is
-      // stored
-      for (int j = 0; j < nqpts; ++j) {
-         // The offset is the current location of the data
-         int offset = (i * nqpts * vdim) + (j * vdim);
-         int offset2 = (i * nqpts * vdim2) + (j * vdim2);
-         double* incr_data_offset = incr_data + offset;
-         double* end_data_offset = end_data + offset;
-         double* int_data_offset = int_data + offset;
-         double* ds_data_offset = ds_data + offset2;
-
-         f_end.UseExternalData(end_data_offset, dim, dim);
-         f_beg.UseExternalData(int_data_offset, dim, dim);
-         f_incr.UseExternalData(incr_data_offset, dim, dim);
-         DS.UseExternalData(ds_data_offset, dof, dim);
+   const int npts = nqpts * nelems;
 
-         // Get the inverse of the beginning time step def. grad
-         f_beg_invr = f_beg;
-         f_beg_invr.Invert();
+   elem_restrict->Mult(*end_coords, el_end_coords);
 
-         // Find the end time step def. grad
-         MultAtB(PMatI, DS, f_end);
-
-         // Our incremental def. grad is now
-         Mult(f_end, f_beg_invr, f_incr);
-      }
-   }
+   // Our end step deformation gradient is just the gradient of the end step
+   // coordinates with respect to the reference configuration.
+   end_def_grad = 0.0;
+   exaconstit::kernel::grad_calc(nqpts, nelems, nnodes, ref_jacobian.Read(), loc_grad.Read(),
+                                 el_end_coords.Read(), end_def_grad.ReadWrite());
+   exaconstit::kernel::incr_def_grad_calc(npts, defGrad0->Read(), end_def_grad.Read(),
+                                          incr_def_grad.Write());
+
+   // The strain measures and element length that get passed to the UMAT
+   exaconstit::kernel::eulerian_strain_calc(npts, end_def_grad.Read(), strain.Write());
+   exaconstit::kernel::eulerian_strain_calc(npts, incr_def_grad.Read(), strain_incr.Write());
+   exaconstit::kernel::elem_length_calc(npts, jacobian.Read(), elem_length.Write());
 }
 
 void AbaqusUmatModel::CalcLogStrainIncrement(DenseMatrix& dE, const DenseMatrix &Jpt)
@@ -304,288 +294,307 @@ void AbaqusUmatModel::CalcLagrangianStrainIncr(DenseMatrix& dE, const DenseMatri
 // Further testing needs to be conducted to make sure this still does everything it used to
 // but it should. Since, it is just copy and pasted from the old EvalModel function and now
 // has loops added to it.
-void AbaqusUmatModel::ModelSetup(const int nqpts, const int nelems, const int space_dim,
-                                 const int /*nnodes*/, const Vector &jacobian,
-                                 const Vector & /*loc_grad*/, const Vector &vel)
+void AbaqusUmatModel::ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
+                                 const int nnodes, const Vector &jacobian,
+                                 const Vector &loc_grad, const Vector & /*vel*/)
 {
-   // All of this should be scoped to limit at least some of our memory usage
-   {
-      ParGridFunction* end_crds = end_coords;
-      Vector temp;
-      temp.SetSize(vel.Size());
-      end_crds->GetTrueDofs(temp);
-      // Creating a new vector that's going to be used for our
-      // UMAT custom Hform->Mult
-      const Vector crd(temp.HostReadWrite(), temp.Size());
-      calc_incr_end_def_grad(crd);
-   }
+   // The kinematics are all computed in our kernels ahead of time, so all
+   // that's left for the points below is the rotation and calling the UMAT.
+   calc_incr_end_def_grad(nqpts, nelems, nnodes, jacobian, loc_grad);
 
    // ======================================================
    // Set UMAT input arguments
    // ======================================================
 
-   // initialize Umat variables
-   int ndi = 3; // number of direct stress components
-   int nshr = 3; // number of shear stress components
-   int ntens = ndi + nshr;
-   int noel = 0;
-   int npt = 0;
-   int layer = 0;
-   int kspt = 0;
-   int kstep = 0;
-   int kinc = 0;
-
    // set properties and state variables length (hard code for now);
-   int nprops = numProps;
-   int nstatv = numStateVars;
-
-   double pnewdt = 10.0; // revisit this
-   double props[nprops]; // populate from the mat props vector wrapped by matProps on the base class
-   double statev[nstatv]; // populate from the state variables associated with this element/ip
-
-   double rpl = 0.0; // volumetric heat generation per unit time, not considered
-   double drpldt = 0.0; // variation of rpl wrt temperature set to 0.0
-   double tempk = 300.0; // no thermal considered at this point
-   double dtemp = 0.0; // no increment in thermal considered at this point
-   double predef = 0.0; // no interpolated values of predefined field variables at ip point
-   double dpred = 0.0; // no array of increments of predefined field variables
-   double sse = 0.0; // specific elastic strain energy, mainly for output
-   double spd = 0.0; // specific plastic dissipation, mainly for output
-   double scd = 0.0; // specific creep dissipation, mainly for output
-   double cmname = 0.0; // user defined UMAT name
-   double celent = 0.0; // set element length
-
-   // integration point coordinates
-   // a material model shouldn't need this ever
-   double coords[3] = { 0, 0, 0 };
+   const int nprops = numProps;
+   const int nstatv = numStateVars;
+   const int npts = nqpts * nelems;
+   const int ntens = 6;
 
    // set the time step
-   double deltaTime = dt; // set on the ExaModel base class
-
-   // set time. Abaqus has odd increment definition. time[1] is the value of total
-   // time at the beginning of the current increment. Since we are iterating from
-   // tn to tn+1, this is just tn. time[0] is value of step time at the beginning
-   // of the current increment. What is step time if not tn? It seems as though
-   // they sub-increment between tn->tn+1, where there is a Newton Raphson loop
-   // advancing the sub-increment. For now, set time[0] is set to t - dt/
-   double time[2];
-   time[0] = t - dt;
-   time[1] = t;
-
-   double stress[6]; // Cauchy stress at ip
-   double ddsdt[6]; // variation of the stress increments wrt to temperature, set to 0.0
-   double drplde[6]; // variation of rpl wrt strain increments, set to 0.0
-   double stran[6]; // array containing total strains at beginning of the increment
-   double dstran[6]; // array of strain increments
-
-   double *drot; // rotation matrix for finite deformations
-   double dfgrd0[9]; // deformation gradient at beginning of increment
-   double dfgrd1[9]; // defomration gradient at the end of the increment.
-                     // set to zero if nonlinear geometric effects are not
-                     // included in the step as is the case for ExaConstit
-
-   QuadratureFunction* _defgrad0 = defGrad0;
-
-   double* defgrad0 = _defgrad0->HostReadWrite();
-   double* defgrad1 = end_def_grad.HostReadWrite();
-   double* incr_defgrad = incr_def_grad.HostReadWrite();
-   DenseMatrix incr_dgrad, dgrad0, dgrad1;
+   const double dtime = dt; // set on the ExaModel base class
+   const double tn = t - dt;
+   const double tnp1 = t;
 
+   // The points are all independent of one another, so we grab the raw
+   // quadrature function data once up here and every point reads and writes
+   // its own slice of it.
    const int vdim = end_def_grad.GetVDim();
-   double ddsdde[36]; // output Jacobian matrix of the constitutive model.
-                      // ddsdde(i,j) defines the change in the ith stress component
-                      // due to an incremental perturbation in the jth strain increment
-
-   const int DIM4 = 4;
+   const double* defgrad0 = defGrad0->HostRead();
+   const double* defgrad1 = end_def_grad.HostRead();
+   const double* incr_defgrad = incr_def_grad.HostRead();
+   const double* strain_data = strain.HostRead();
+   const double* strain_incr_data = strain_incr.HostRead();
+   const double* elem_length_data = elem_length.HostRead();
+   const double* mat_props = matProps->HostRead();
+
+   const double* stress_beg = stress0->HostRead();
+   double* stress_end = stress1->HostWrite();
+   const double* state_vars_beg = matVars0->HostRead();
+   double* state_vars_end = matVars1->HostWrite();
+   const int pt_stride = GetStatePtStride();
+   const int var_stride = GetStateVarStride();
+   double* mat_grad = tangent_required ? matGrad->HostWrite() : nullptr;
+
+   // With a batched user material the points are sent to it in blocks laid
+   // out for the batched interface. Otherwise, each block is a single point,
+   // where that layout is just the per point one, and the per point UMAT is
+   // called on it directly without any transposing.
+   const int nbatch_max = std::max(1, std::min((batch_size > 0) ? batch_size : 1, npts));
+   const int nbatches = (npts + nbatch_max - 1) / nbatch_max;
+
+   double pnewdt_red = std::numeric_limits<double>::max();
+
+   // Our UMATs are thread safe, so when requested the blocks are split up
+   // across the OpenMP threads. Everything the UMAT might write to lives
+   // within the parallel region so each thread has its own scratch space.
+#if defined(RAJA_ENABLE_OPENMP)
+   #pragma omp parallel if (threaded) reduction(min: pnewdt_red)
+#endif
+   {
+      int nstatv_umat = nstatv;
+      int nprops_umat = nprops;
+      std::vector<double> props(nprops); // populate from the mat props vector wrapped by matProps on the base class
+
+      // set time. Abaqus has odd increment definition. time[1] is the value of total
+      // time at the beginning of the current increment. Since we are iterating from
+      // tn to tn+1, this is just tn. time[0] is value of step time at the beginning
+      // of the current increment. What is step time if not tn? It seems as though
+      // they sub-increment between tn->tn+1, where there is a Newton Raphson loop
+      // advancing the sub-increment. For now, set time[0] is set to t - dt/
+      double time[2];
+      double deltaTime;
+
+      // The batched versions of the UMAT arguments
+      std::vector<double> celent(nbatch_max); // element length
+      std::vector<double> stran(nbatch_max * ntens); // total strains at beginning of the increment
+      std::vector<double> dstran(nbatch_max * ntens); // strain increments
+      std::vector<double> drot(nbatch_max * 9); // rotation matrix for finite deformations
+      std::vector<double> dfgrd0(nbatch_max * 9); // deformation gradient at beginning of increment
+      std::vector<double> dfgrd1(nbatch_max * 9); // deformation gradient at the end of the increment
+      std::vector<double> stress(nbatch_max * ntens); // Cauchy stress at ip
+      std::vector<double> statev(nbatch_max * nstatv); // state variables associated with this element/ip
+      std::vector<double> ddsdde(nbatch_max * ntens * ntens); // Jacobian matrix of the constitutive model
+      std::vector<double> pnewdt(nbatch_max); // suggested ratio of the new time step to the current one
+      std::vector<int> noel(nbatch_max); // element id
+      std::vector<int> npt(nbatch_max); // integration point number
+
+      DenseMatrix Rincr(3), Uincr(3), Vincr(3);
+      double ddsdde_pt[36];
+
+#if defined(RAJA_ENABLE_OPENMP)
+      #pragma omp for schedule(static)
+#endif
+      for (int ibatch = 0; ibatch < nbatches; ibatch++) {
+         const int pt_start = ibatch * nbatch_max;
+         int nbatch = std::min(nbatch_max, npts - pt_start);
+
+         for (int ib = 0; ib < nbatch; ib++) {
+            const int i_pt = pt_start + ib;
+            const int elemID = i_pt / nqpts;
+            const int ipID = i_pt % nqpts;
+            celent[ib] = elem_length_data[i_pt];
+
+            const int offset = i_pt * vdim;
+
+            noel[ib] = elemID;
+            npt[ib] = ipID;
+            pnewdt[ib] = 10.0; // revisit this
+
+            // The DenseMatrix copy keeps the quadrature function data read only
+            Rincr = (incr_defgrad + offset);
+            CalcPolarDecompDefGrad(Rincr, Uincr, Vincr);
+
+            // populate the rotation and the beginning step and end step (or best
+            // guess to end step within the Newton iterations) of the deformation
+            // gradients. These are all column major just like the quadrature
+            // function data.
+            for (int i = 0; i < 9; ++i) {
+               drot[i * nbatch + ib] = Rincr.GetData()[i];
+               dfgrd0[i * nbatch + ib] = defgrad0[offset + i];
+               dfgrd1[i * nbatch + ib] = defgrad1[offset + i];
+            }
 
-   std::array<RAJA::idx_t, DIM4> perm4 {{ 3, 2, 1, 0 } };
-   // bunch of helper RAJA views to make dealing with data easier down below in our kernel.
-   RAJA::Layout<DIM4> layout_jacob = RAJA::make_permuted_layout({{ space_dim, space_dim, nqpts, nelems } }, perm4);
-   RAJA::View<const double, RAJA::Layout<DIM4, RAJA::Index_type, 0> > J(jacobian.HostRead(), layout_jacob);
-
-   for (int elemID = 0; elemID < nelems; elemID++) {
-      for (int ipID = 0; ipID < nqpts; ipID++) {
-         // compute characteristic element length
-         const double J11 = J(0, 0, ipID, elemID); // 0,0
-         const double J21 = J(1, 0, ipID, elemID); // 1,0
-         const double J31 = J(2, 0, ipID, elemID); // 2,0
-         const double J12 = J(0, 1, ipID, elemID); // 0,1
-         const double J22 = J(1, 1, ipID, elemID); // 1,1
-         const double J32 = J(2, 1, ipID, elemID); // 2,1
-         const double J13 = J(0, 2, ipID, elemID); // 0,2
-         const double J23 = J(1, 2, ipID, elemID); // 1,2
-         const double J33 = J(2, 2, ipID, elemID); // 2,2
-         const double detJ = J11 * (J22 * J33 - J32 * J23) -
-                             /* */ J21 * (J12 * J33 - J32 * J13) +
-                             /* */ J31 * (J12 * J23 - J22 * J13);
-         CalcElemLength(detJ);
-         celent = elemLength;
-
-         const int offset = elemID * nqpts * vdim + ipID * vdim;
-
-         noel = elemID; // element id
-         npt = ipID; // integration point number
-
-         // initialize 1d arrays
-         for (int i = 0; i<6; ++i) {
-            stress[i] = 0.0;
-            ddsdt[i] = 0.0;
-            drplde[i] = 0.0;
-            stran[i] = 0.0;
-            dstran[i] = 0.0;
-         }
+            // get state variables
+            for (int i = 0; i < nstatv; i++) {
+               statev[i * nbatch + ib] = state_vars_beg[i_pt * pt_stride + i * var_stride];
+            }
 
-         // initialize 6x6 2d arrays
-         for (int i = 0; i<6; ++i) {
-            for (int j = 0; j<6; ++j) {
-               ddsdde[(i * 6) + j] = 0.0;
+            // ensure proper ordering of the stress array. ExaConstit uses
+            // Voigt notation (11, 22, 33, 23, 13, 12), while
+            // ------------------------------------------------------------------
+            // We use Voigt notation: (11, 22, 33, 23, 13, 12)
+            //
+            // ABAQUS USES:
+            // (11, 22, 33, 12, 13, 23)
+            // ------------------------------------------------------------------
+            const double* stress_beg_pt = &stress_beg[i_pt * ntens];
+            stress[0 * nbatch + ib] = stress_beg_pt[0];
+            stress[1 * nbatch + ib] = stress_beg_pt[1];
+            stress[2 * nbatch + ib] = stress_beg_pt[2];
+            stress[3 * nbatch + ib] = stress_beg_pt[5];
+            stress[4 * nbatch + ib] = stress_beg_pt[4];
+            stress[5 * nbatch + ib] = stress_beg_pt[3];
+
+            // Abaqus does mention wanting to use a log strain for large strains
+            // It's also based on an updated lagrangian formulation so as long as
+            // we aren't generating any crazy strains do we really need to use the
+            // log strain?
+            // populate STRAN and DSTRAN (symmetric) from the Eulerian strains
+            // ------------------------------------------------------------------
+            // We use Voigt notation: (11, 22, 33, 23, 13, 12)
+            //
+            // ABAQUS USES:
+            // (11, 22, 33, 12, 13, 23)
+            // ------------------------------------------------------------------
+            const double* E = &strain_data[i_pt * 9];
+            stran[0 * nbatch + ib] = E[0];
+            stran[1 * nbatch + ib] = E[4];
+            stran[2 * nbatch + ib] = E[8];
+            stran[3 * nbatch + ib] = 2 * E[3];
+            stran[4 * nbatch + ib] = 2 * E[6];
+            stran[5 * nbatch + ib] = 2 * E[7];
+
+            const double* dE = &strain_incr_data[i_pt * 9];
+            dstran[0 * nbatch + ib] = dE[0];
+            dstran[1 * nbatch + ib] = dE[4];
+            dstran[2 * nbatch + ib] = dE[8];
+            dstran[3 * nbatch + ib] = 2 * dE[3];
+            dstran[4 * nbatch + ib] = 2 * dE[6];
+            dstran[5 * nbatch + ib] = 2 * dE[7];
+
+            // initialize the 6x6 tangent
+            for (int i = 0; i < ntens * ntens; i++) {
+               ddsdde[i * nbatch + ib] = 0.0;
             }
          }
 
+         // The user material is free to write to any of these, so they get
+         // reset for every block.
+         for (int i = 0; i < nprops; i++) {
+            props[i] = mat_props[i];
+         }
+         time[0] = tn;
+         time[1] = tnp1;
+         deltaTime = dtime;
+
+         if (batch_size > 0) {
+            batch_umat(&nbatch, &nstatv_umat, &nprops_umat, props.data(), time, &deltaTime,
+                       celent.data(), stran.data(), dstran.data(), drot.data(), dfgrd0.data(),
+                       dfgrd1.data(), stress.data(), statev.data(), ddsdde.data(), pnewdt.data(),
+                       noel.data(), npt.data());
+         }
+         else {
+            umat_pt(&nstatv_umat, &nprops_umat, props.data(), time, &deltaTime,
+                    celent.data(), stran.data(), dstran.data(), drot.data(), dfgrd0.data(),
+                    dfgrd1.data(), stress.data(), statev.data(), ddsdde.data(), pnewdt.data(),
+                    noel.data(), npt.data());
+         }
 
-         incr_dgrad.UseExternalData((incr_defgrad + offset), 3, 3);
-         dgrad0.UseExternalData((defgrad0 + offset), 3, 3);
-         dgrad1.UseExternalData((defgrad1 + offset), 3, 3);
-
-         DenseMatrix Uincr(3), Vincr(3);
-         DenseMatrix Rincr(incr_dgrad, 3);
-         CalcPolarDecompDefGrad(Rincr, Uincr, Vincr);
-
-         drot = Rincr.GetData();
+         for (int ib = 0; ib < nbatch; ib++) {
+            const int i_pt = pt_start + ib;
+            pnewdt_red = std::min(pnewdt_red, pnewdt[ib]);
+            // The UMAT interface always returns ddsdde, but we only need to store it
+            // off when a tangent is going to be assembled.
+            if (tangent_required) {
+               for (int i = 0; i < ntens * ntens; i++) {
+                  ddsdde_pt[i] = ddsdde[i * nbatch + ib];
+               }
+               // Due to how Abaqus has things ordered we need to swap the 4th and 6th columns
+               // and rows with one another for our C_stiffness matrix.
+               int j = 3;
+               // We could probably just replace this with a std::swap operation...
+               for (int i = 0; i < 6; i++) {
+                  std::swap(ddsdde_pt[(6 * i) + j], ddsdde_pt[(6 * i) + 5]);
+               }
+
+               for (int i = 0; i < 6; i++) {
+                  std::swap(ddsdde_pt[(6 * j) + i], ddsdde_pt[(6 * 5) + i]);
+               }
+
+               // set the material stiffness on the model
+               double* mat_grad_pt = &mat_grad[i_pt * ntens * ntens];
+               for (int i = 0; i < ntens * ntens; i++) {
+                  mat_grad_pt[i] = ddsdde_pt[i];
+               }
+            }
 
-         // populate the beginning step and end step (or best guess to end step
-         // within the Newton iterations) of the deformation gradients
-         for (int i = 0; i<ndi; ++i) {
-            for (int j = 0; j<ndi; ++j) {
-               // Dense matrices have column major layout so the below is fine.
-               dfgrd0[(i * 3) + j] = dgrad0(j, i);
-               dfgrd1[(i * 3) + j] = dgrad1(j, i);
+            // set the updated stress on the model. Have to convert from Abaqus
+            // ordering to Voigt notation ordering
+            // ------------------------------------------------------------------
+            // We use Voigt notation: (11, 22, 33, 23, 13, 12)
+            //
+            // ABAQUS USES:
+            // (11, 22, 33, 12, 13, 23)
+            // ------------------------------------------------------------------
+            double* stress_end_pt = &stress_end[i_pt * ntens];
+            stress_end_pt[0] = stress[0 * nbatch + ib];
+            stress_end_pt[1] = stress[1 * nbatch + ib];
+            stress_end_pt[2] = stress[2 * nbatch + ib];
+            stress_end_pt[3] = stress[5 * nbatch + ib];
+            stress_end_pt[4] = stress[4 * nbatch + ib];
+            stress_end_pt[5] = stress[3 * nbatch + ib];
+
+            // set the updated statevars
+            for (int i = 0; i < nstatv; i++) {
+               state_vars_end[i_pt * pt_stride + i * var_stride] = statev[i * nbatch + ib];
             }
          }
+      }
+   }
 
-         // get state variables and material properties
-         GetElementStateVars(elemID, ipID, true, statev, nstatv);
-         GetMatProps(props);
-
-         // get element stress and make sure ordering is ok
-         double stressTemp[6];
-         double stressTemp2[6];
-         GetElementStress(elemID, ipID, true, stressTemp, 6);
-
-         // ensure proper ordering of the stress array. ExaConstit uses
-         // Voigt notation (11, 22, 33, 23, 13, 12), while
-         // ------------------------------------------------------------------
-         // We use Voigt notation: (11, 22, 33, 23, 13, 12)
-         //
-         // ABAQUS USES:
-         // (11, 22, 33, 12, 13, 23)
-         // ------------------------------------------------------------------
-         stress[0] = stressTemp[0];
-         stress[1] = stressTemp[1];
-         stress[2] = stressTemp[2];
-         stress[3] = stressTemp[5];
-         stress[4] = stressTemp[4];
-         stress[5] = stressTemp[3];
-
-         // Abaqus does mention wanting to use a log strain for large strains
-         // It's also based on an updated lagrangian formulation so as long as
-         // we aren't generating any crazy strains do we really need to use the
-         // log strain?
-         DenseMatrix LogStrain;
-         LogStrain.SetSize(ndi); // ndi x ndi
-         CalcEulerianStrain(LogStrain, dgrad1);
-
-         // populate STRAN (symmetric)
-         // ------------------------------------------------------------------
-         // We use Voigt notation: (11, 22, 33, 23, 13, 12)
-         //
-         // ABAQUS USES:
-         // (11, 22, 33, 12, 13, 23)
-         // ------------------------------------------------------------------
-         stran[0] = LogStrain(0, 0);
-         stran[1] = LogStrain(1, 1);
-         stran[2] = LogStrain(2, 2);
-         stran[3] = 2 * LogStrain(0, 1);
-         stran[4] = 2 * LogStrain(0, 2);
-         stran[5] = 2 * LogStrain(1, 2);
-
-         // compute incremental strain, DSTRAN
-         DenseMatrix dLogStrain;
-         dLogStrain.SetSize(ndi);
-         CalcEulerianStrainIncr(dLogStrain, incr_dgrad);
-
-         // populate DSTRAN (symmetric)
-         // ------------------------------------------------------------------
-         // We use Voigt notation: (11, 22, 33, 23, 13, 12)
-         //
-         // ABAQUS USES:
-         // (11, 22, 33, 12, 13, 23)
-         // ------------------------------------------------------------------
-         dstran[0] = dLogStrain(0, 0);
-         dstran[1] = dLogStrain(1, 1);
-         dstran[2] = dLogStrain(2, 2);
-         dstran[3] = 2 * dLogStrain(0, 1);
-         dstran[4] = 2 * dLogStrain(0, 2);
-         dstran[5] = 2 * dLogStrain(1, 2);
-
-
-         // call c++ wrapper of umat routine
-         umat(&stress[0], &statev[0], &ddsdde[0], &sse, &spd, &scd, &rpl,
-              ddsdt, drplde, &drpldt, &stran[0], &dstran[0], time,
-              &deltaTime, &tempk, &dtemp, &predef, &dpred, &cmname,
-              &ndi, &nshr, &ntens, &nstatv, &props[0], &nprops, &coords[0],
-              drot, &pnewdt, &celent, &dfgrd0[0], &dfgrd1[0], &noel, &npt,
-              &layer, &kspt, &kstep, &kinc);
-
-         // Due to how Abaqus has things ordered we need to swap the 4th and 6th columns
-         // and rows with one another for our C_stiffness matrix.
-         int j = 3;
-         // We could probably just replace this with a std::swap operation...
-         for (int i = 0; i < 6; i++) {
-            std::swap(ddsdde[(6 * i) + j], ddsdde[(6 * i) + 5]);
-         }
+   pnewdt_min = pnewdt_red;
+}
 
-         for (int i = 0; i < 6; i++) {
-            std::swap(ddsdde[(6 * j) + i], ddsdde[(6 * 5) + i]);
+extern "C" {
+   UMAT_API void
+   umat_batch_adapter(int *npts, int *nstatv, int *nprops, real8 *props,
+                      real8 *time, real8 *deltaTime, real8 *celent,
+                      real8 *stran, real8 *dstran, real8 *drot,
+                      real8 *dfgrd0, real8 *dfgrd1, real8 *stress,
+                      real8 *statev, real8 *ddsdde, real8 *pnewdt,
+                      int *noel, int *npt)
+   {
+      const int nbatch = *npts;
+      const int ntens = 6;
+
+      double stress_pt[6], stran_pt[6], dstran_pt[6];
+      double drot_pt[9], dfgrd0_pt[9], dfgrd1_pt[9];
+      double ddsdde_pt[36];
+      std::vector<double> statev_pt(*nstatv);
+
+      for (int ib = 0; ib < nbatch; ib++) {
+         for (int i = 0; i < ntens; i++) {
+            stress_pt[i] = stress[i * nbatch + ib];
+            stran_pt[i] = stran[i * nbatch + ib];
+            dstran_pt[i] = dstran[i * nbatch + ib];
          }
+         for (int i = 0; i < 9; i++) {
+            drot_pt[i] = drot[i * nbatch + ib];
+            dfgrd0_pt[i] = dfgrd0[i * nbatch + ib];
+            dfgrd1_pt[i] = dfgrd1[i * nbatch + ib];
+         }
+         for (int i = 0; i < ntens * ntens; i++) {
+            ddsdde_pt[i] = ddsdde[i * nbatch + ib];
+         }
+         for (int i = 0; i < *nstatv; i++) {
+            statev_pt[i] = statev[i * nbatch + ib];
+         }
+
+         umat_pt(nstatv, nprops, props, time, deltaTime, &celent[ib], &stran_pt[0],
+                 &dstran_pt[0], &drot_pt[0], &dfgrd0_pt[0], &dfgrd1_pt[0], &stress_pt[0],
+                 statev_pt.data(), &ddsdde_pt[0], &pnewdt[ib], &noel[ib], &npt[ib]);
 
-         // set the material stiffness on the model
-         SetElementMatGrad(elemID, ipID, ddsdde, ntens * ntens);
-
-         // set the updated stress on the model. Have to convert from Abaqus
-         // ordering to Voigt notation ordering
-         // ------------------------------------------------------------------
-         // We use Voigt notation: (11, 22, 33, 23, 13, 12)
-         //
-         // ABAQUS USES:
-         // (11, 22, 33, 12, 13, 23)
-         // ------------------------------------------------------------------
-         stressTemp2[0] = stress[0];
-         stressTemp2[1] = stress[1];
-         stressTemp2[2] = stress[2];
-         stressTemp2[3] = stress[5];
-         stressTemp2[4] = stress[4];
-         stressTemp2[5] = stress[3];
-
-         SetElementStress(elemID, ipID, false, stressTemp2, ntens);
-
-         // set the updated statevars
-         SetElementStateVars(elemID, ipID, false, statev, nstatv);
+         for (int i = 0; i < ntens; i++) {
+            stress[i * nbatch + ib] = stress_pt[i];
+         }
+         for (int i = 0; i < ntens * ntens; i++) {
+            ddsdde[i * nbatch + ib] = ddsdde_pt[i];
+         }
+         for (int i = 0; i < *nstatv; i++) {
+            statev[i * nbatch + ib] = statev_pt[i];
+         }
       }
    }
 }
-
-void AbaqusUmatModel::CalcElemLength(const double elemVol)
-{
-   // It can also be approximated as the cube root of the element's volume.
-   // I think this one might be a little nicer to use because for distorted elements
-   // you might not want the largest length.
-   // According to https://abaqus-docs.mit.edu/2017/English/SIMACAEKEYRefMap/simakey-r-characteristiclength.htm
-   // it looks like this might be the right way to do it...
-   // although this does change from integration to integration point
-   // since we're using the determinate instead of the actual volume. However,
-   // it should be good enough for our needs...
-   elemLength = cbrt(elemVol);
-
-   return;
-}
@@ -3,7 +3,7 @@
 
 #include "mfem.hpp"
 #include "mechanics_model.hpp"
-#include "userumat.h"
+#include "uservumat.h"
 
 
 // Abaqus Umat class.
@@ -11,11 +11,30 @@ class AbaqusUmatModel : public ExaModel
 {
    protected:
 
-      // add member variables.
-      double elemLength;
+      // If true the quadrature points are split up across the OpenMP threads
+      // when the UMAT is called.
+      bool threaded = false;
 
-      // The initial local shape function gradients.
-      mfem::QuadratureFunction loc0_sf_grad;
+      // If greater than 0 the batched user material is called on blocks of
+      // this many points rather than the per point UMAT.
+      int batch_size = 0;
+
+      // The min pnewdt returned by the UMAT over all of the points during
+      // the last ModelSetup call.
+      double pnewdt_min = 10.0;
+
+      // The reference configuration Jacobians at the quadrature points.
+      mfem::Vector ref_jacobian;
+
+      // The element restriction used to get our end step coordinates E-vector.
+      const mfem::Operator *elem_restrict;
+      mfem::Vector el_end_coords;
+
+      // The Eulerian strain and strain increment and the element length at the
+      // quadrature points that get passed to the UMAT.
+      mfem::Vector strain;
+      mfem::Vector strain_incr;
+      mfem::Vector elem_length;
 
       // The incremental deformation gradients.
       mfem::QuadratureFunction incr_def_grad;
@@ -46,14 +65,13 @@ class AbaqusUmatModel : public ExaModel
       void CalcEulerianStrainIncr(mfem::DenseMatrix& dE, const mfem::DenseMatrix &Jpt);
       void CalcLagrangianStrainIncr(mfem::DenseMatrix& dE, const mfem::DenseMatrix &Jpt);
 
-      // calculates the element length
-      void CalcElemLength(const double elemVol);
-
-      void init_loc_sf_grads(mfem::ParFiniteElementSpace *fes);
+      void init_ref_jacobian(mfem::ParFiniteElementSpace *fes);
       void init_incr_end_def_grad();
 
-      // For when the ParFinitieElementSpace is stored on the class...
-      virtual void calc_incr_end_def_grad(const mfem::Vector &x0);
+      // Computes the end step and incremental deformation gradients along with
+      // the strains and element lengths that get passed to the UMAT.
+      virtual void calc_incr_end_def_grad(const int nqpts, const int nelems, const int nnodes,
+                                          const mfem::Vector &jacobian, const mfem::Vector &loc_grad);
       virtual void calcDpMat(mfem::QuadratureFunction &/* DpMat */) const {};
 
    public:
@@ -70,7 +88,7 @@ class AbaqusUmatModel : public ExaModel
                   _props, _nProps, _nStateVars, _PA), loc_fes(fes),
          defGrad0(_q_defGrad0)
       {
-         init_loc_sf_grads(fes);
+         init_ref_jacobian(fes);
          init_incr_end_def_grad();
       }
 
@@ -78,9 +96,21 @@ class AbaqusUmatModel : public ExaModel
 
       virtual void UpdateModelVars();
 
-      virtual void ModelSetup(const int nqpts, const int nelems, const int space_dim,
-                              const int /*nnodes*/, const mfem::Vector &jacobian,
-                              const mfem::Vector & /*loc_grad*/, const mfem::Vector &vel);
+      // Our UMATs need to be thread safe for this to be turned on. It's only
+      // available when we're built with OpenMP support.
+      void SetThreaded(const bool thread) { threaded = thread; }
+
+      // The batched user material interface in uservumat.h gets called on
+      // blocks of _batch_size points at a time if this is greater than 0.
+      void SetBatchSize(const int _batch_size) { batch_size = _batch_size; }
+
+      // Abaqus' pnewdt is the ratio of the suggested new time step to the
+      // current one.
+      virtual double GetSuggestedDtRatio() const { return pnewdt_min; }
+
+      virtual void ModelSetup(const int nqpts, const int nelems, const int /*space_dim*/,
+                              const int nnodes, const mfem::Vector &jacobian,
+                              const mfem::Vector &loc_grad, const mfem::Vector & /*vel*/);
 };
 
 #endif
@@ -21,6 +21,77 @@ namespace {
    typedef ecmech::evptn::matModel<ecmech::SlipGeom_BCC_A, ecmech::Kin_FCC_AH, 
             ecmech::evptn::ThermoElastNCubic, ecmech::EosModelConst<false>>
             VoceNLBCCModel;
+
+   XtalType parse_xtal_type(const std::string &xtal)
+   {
+      if ((xtal == "fcc") || (xtal == "FCC")) {
+         return XtalType::FCC;
+      }
+      else if ((xtal == "bcc") || (xtal == "BCC")) {
+         return XtalType::BCC;
+      }
+      else if ((xtal == "hcp") || (xtal == "HCP")) {
+         return XtalType::HCP;
+      }
+      return XtalType::NOTYPE;
+   }
+
+   SlipType parse_slip_type(const std::string &slip)
+   {
+      if ((slip == "mts") || (slip == "MTS") || (slip == "mtsdd") || (slip == "MTSDD")) {
+         return SlipType::MTSDD;
+      }
+      else if ((slip == "powervoce") || (slip == "PowerVoce") || (slip == "POWERVOCE")) {
+         return SlipType::POWERVOCE;
+      }
+      else if ((slip == "powervocenl") || (slip == "PowerVoceNL") || (slip == "POWERVOCENL")) {
+         return SlipType::POWERVOCENL;
+      }
+      return SlipType::NOTYPE;
+   }
+
+   // Returns the number of parameters and history variables of the ExaCMech
+   // model that goes with the crystal and slip types. Both are -1 for
+   // combinations that aren't supported.
+   void ecmech_model_sizes(const XtalType xtal, const SlipType slip, int &nparams, int &nhist)
+   {
+      nparams = -1;
+      nhist = -1;
+      if (xtal == XtalType::FCC) {
+         if (slip == SlipType::MTSDD) {
+            nparams = ecmech::matModelEvptn_FCC_B::nParams;
+            nhist = ecmech::matModelEvptn_FCC_B::numHist;
+         }
+         else if (slip == SlipType::POWERVOCE) {
+            nparams = ecmech::matModelEvptn_FCC_A::nParams;
+            nhist = ecmech::matModelEvptn_FCC_A::numHist;
+         }
+         else if (slip == SlipType::POWERVOCENL) {
+            nparams = ecmech::matModelEvptn_FCC_AH::nParams;
+            nhist = ecmech::matModelEvptn_FCC_AH::numHist;
+         }
+      }
+      else if (xtal == XtalType::BCC) {
+         if (slip == SlipType::MTSDD) {
+            nparams = ecmech::matModelEvptn_BCC_A::nParams;
+            nhist = ecmech::matModelEvptn_BCC_A::numHist;
+         }
+         else if (slip == SlipType::POWERVOCE) {
+            nparams = VoceBCCModel::nParams;
+            nhist = VoceBCCModel::numHist;
+         }
+         else if (slip == SlipType::POWERVOCENL) {
+            nparams = VoceNLBCCModel::nParams;
+            nhist = VoceNLBCCModel::numHist;
+         }
+      }
+      else if (xtal == XtalType::HCP) {
+         if (slip == SlipType::MTSDD) {
+            nparams = ecmech::matModelEvptn_HCP_A::nParams;
+            nhist = ecmech::matModelEvptn_HCP_A::numHist;
+         }
+      }
+   }
 }
 // my_id corresponds to the processor id.
 void ExaOptions::parse_options(int my_id)
@@ -40,6 +111,8 @@ void ExaOptions::parse_options(int my_id)
    get_solvers();
    // From the toml file it finds all the values related to the mesh
    get_mesh();
+   // From the toml file it finds all the values related to the checkpoints
+   get_checkpoint();
    // If the processor is set 0 then the options are printed out.
    if (my_id == 0) {
       print_options();
@@ -338,6 +411,9 @@ void ExaOptions::get_model()
    else if ((_mech_type == "exacmech") || (_mech_type == "Exacmech") || (_mech_type == "ExaCMech") || (_mech_type == "EXACMECH")) {
       mech_type = MechType::EXACMECH;
    }
+   else if ((_mech_type == "surrogate") || (_mech_type == "Surrogate") || (_mech_type == "SURROGATE")) {
+      mech_type = MechType::SURROGATE;
+   }
    else {
       MFEM_ABORT("Model.mech_type was not provided a valid type.");
       mech_type = MechType::NOTYPE;
@@ -345,6 +421,31 @@ void ExaOptions::get_model()
 
    cp = toml::find_or<bool>(table, "cp", false);
 
+   if (mech_type == MechType::UMAT) {
+      if (table.contains("UMAT")) {
+         const auto& umat_table = toml::find(table, "UMAT");
+         umat_threaded = toml::find_or<bool>(umat_table, "threaded", false);
+         umat_batch_size = toml::find_or<int>(umat_table, "batch_size", 0);
+         if (umat_batch_size < 0) {
+            MFEM_ABORT("Model.UMAT.batch_size can not be negative.");
+         }
+         umat_honor_pnewdt = toml::find_or<bool>(umat_table, "honor_pnewdt", false);
+      }
+   }
+
+   if (mech_type == MechType::SURROGATE) {
+      if (table.contains("Surrogate")) {
+         const auto& surrogate_table = toml::find(table, "Surrogate");
+         surrogate_weights_file = toml::find_or<std::string>(surrogate_table, "weights_floc", "surrogate.bin");
+         if (!if_file_exists(surrogate_weights_file)) {
+            MFEM_ABORT("Model.Surrogate.weights_floc file does not exist");
+         }
+      }
+      else {
+         MFEM_ABORT("The table Model.Surrogate does not exist, but the model being used is a surrogate.");
+      }
+   }
+
    if (mech_type == MechType::EXACMECH) {
       if (!cp) {
          MFEM_ABORT("Model.cp needs to be set to true when using ExaCMech based models.");
@@ -469,10 +570,117 @@ void ExaOptions::get_model()
                }
             }
          }
+
+         ecmech_elastic_fast = toml::find_or<bool>(exacmech_table, "elastic_fast_path", false);
+         ecmech_elastic_ratio = toml::find_or<double>(exacmech_table, "elastic_ratio", 0.5);
+         if (ecmech_elastic_fast) {
+            if ((slip_type != SlipType::POWERVOCE) && (slip_type != SlipType::POWERVOCENL)) {
+               MFEM_ABORT("Model.ExaCMech.elastic_fast_path is only available for the PowerVoce and PowerVoceNL slip types.");
+            }
+            if ((ecmech_elastic_ratio <= 0.0) || (ecmech_elastic_ratio >= 1.0)) {
+               MFEM_ABORT("Model.ExaCMech.elastic_ratio needs to be between 0 and 1.");
+            }
+         }
+
+         ecmech_chunk_size = toml::find_or<int>(exacmech_table, "chunk_size", 0);
+         if (ecmech_chunk_size < 0) {
+            MFEM_ABORT("Model.ExaCMech.chunk_size can not be negative.");
+         }
+         std::string _chunk_schedule = toml::find_or<std::string>(exacmech_table, "chunk_schedule", "dynamic");
+         if ((_chunk_schedule == "dynamic") || (_chunk_schedule == "Dynamic") || (_chunk_schedule == "DYNAMIC")) {
+            ecmech_chunk_dynamic = true;
+         }
+         else if ((_chunk_schedule == "static") || (_chunk_schedule == "Static") || (_chunk_schedule == "STATIC")) {
+            ecmech_chunk_dynamic = false;
+         }
+         else {
+            MFEM_ABORT("Model.ExaCMech.chunk_schedule was not provided a valid type.");
+         }
+
+         ecmech_soa_state = toml::find_or<bool>(exacmech_table, "soa_state_vars", false);
+         ecmech_float_gdot = toml::find_or<bool>(exacmech_table, "float_gdot", false);
+         if (ecmech_float_gdot && ecmech_soa_state) {
+            MFEM_ABORT("Model.ExaCMech.float_gdot can not be used with Model.ExaCMech.soa_state_vars.");
+         }
+
+         ecmech_batch_size = toml::find_or<int>(exacmech_table, "batch_size", 4096);
+         if (ecmech_batch_size < 0) {
+            MFEM_ABORT("Model.ExaCMech.batch_size can not be negative.");
+         }
+         ecmech_substep_max_evals = toml::find_or<int>(exacmech_table, "substep_max_evals", 0);
+         ecmech_max_substeps = toml::find_or<int>(exacmech_table, "max_substeps", 8);
+         if (ecmech_substep_max_evals < 0) {
+            MFEM_ABORT("Model.ExaCMech.substep_max_evals can not be negative.");
+         }
+         if (ecmech_substep_max_evals > 0 && ecmech_max_substeps < 2) {
+            MFEM_ABORT("Model.ExaCMech.max_substeps needs to be at least 2.");
+         }
+
+         ecmech_surrogate_samples = toml::find_or<std::string>(exacmech_table, "surrogate_samples_floc", "");
+         ecmech_surrogate_stride = toml::find_or<int>(exacmech_table, "surrogate_sample_stride", 1);
+         if (ecmech_surrogate_stride < 1) {
+            MFEM_ABORT("Model.ExaCMech.surrogate_sample_stride needs to be at least 1.");
+         }
       } 
       else {
          MFEM_ABORT("The table Model.ExaCMech does not exist, but the model being used is ExaCMech.");
       }// End if ExaCMech Table Exists
+
+      // Multi-region materials get their own model for each range of element attributes.
+      // All of the regions share the state variable layout of the main model, since
+      // they all live on the same quadrature functions.
+      if (table.contains("Regions")) {
+         int main_nparams, main_nhist;
+         ecmech_model_sizes(xtal_type, slip_type, main_nparams, main_nhist);
+         const auto region_tables = toml::find<std::vector<toml::value>>(table, "Regions");
+         for (const auto &region_table : region_tables) {
+            RegionOptions region;
+            region.attr_min = toml::find_or<int>(region_table, "attr_min", 1);
+            region.attr_max = toml::find_or<int>(region_table, "attr_max", region.attr_min);
+            if (region.attr_max < region.attr_min) {
+               MFEM_ABORT("Model.Regions.attr_max needs to be greater than or equal to attr_min.");
+            }
+            for (const auto &other : regions) {
+               if ((region.attr_min <= other.attr_max) && (other.attr_min <= region.attr_max)) {
+                  MFEM_ABORT("Model.Regions element attribute ranges can not overlap.");
+               }
+            }
+
+            std::string _xtal_type = toml::find_or<std::string>(region_table, "xtal_type", "");
+            std::string _slip_type = toml::find_or<std::string>(region_table, "slip_type", "");
+            region.xtal_type = parse_xtal_type(_xtal_type);
+            region.slip_type = parse_slip_type(_slip_type);
+            int nparams, nhist;
+            ecmech_model_sizes(region.xtal_type, region.slip_type, nparams, nhist);
+            if (nparams < 0) {
+               MFEM_ABORT("Model.Regions was not provided a valid xtal_type and slip_type combination.");
+            }
+            if (nhist != main_nhist) {
+               MFEM_ABORT("Model.Regions models need the same number of state variables as the Model.ExaCMech model.");
+            }
+            // The elastic fast path reads the state as a Voce hardness and the
+            // properties as cubic elastic constants for every region's points
+            if (ecmech_elastic_fast && ((region.xtal_type == XtalType::HCP) ||
+                ((region.slip_type != SlipType::POWERVOCE) && (region.slip_type != SlipType::POWERVOCENL)))) {
+               MFEM_ABORT("Model.ExaCMech.elastic_fast_path is only available if every Model.Regions model "
+                          "is a cubic PowerVoce or PowerVoceNL model.");
+            }
+
+            region.props_file = toml::find_or<std::string>(region_table, "props_floc", "props.txt");
+            if (!if_file_exists(region.props_file)) {
+               MFEM_ABORT("Model.Regions property file does not exist");
+            }
+            region.nProps = toml::find_or<int>(region_table, "num_props", 1);
+            if (region.nProps != nparams) {
+               MFEM_ABORT("Model.Regions.num_props needs " << nparams << " values for the region's "
+                          "xtal_type and slip_type");
+            }
+            regions.push_back(region);
+         }
+      }
+   }
+   else if (table.contains("Regions")) {
+      MFEM_ABORT("Model.Regions is only available for ExaCMech models.");
    }
 } // end of model parsing
 
@@ -506,6 +714,25 @@ void ExaOptions::get_time_steps()
       dt_min = toml::find_or<double>(auto_table, "dt_min", 1.0);
       t_final = toml::find_or<double>(auto_table, "t_final", 1.0);
       dt_file = toml::find_or<std::string>(auto_table, "auto_dt_file", "auto_dt_out.txt");
+      dt_max = toml::find_or<double>(auto_table, "dt_max", t_final);
+      if (dt_max < dt_min) {
+         MFEM_ABORT("dt_max for auto time stepping needs to be greater than or equal to dt_min.");
+      }
+      std::string _controller = toml::find_or<std::string>(auto_table, "controller", "iter");
+      if ((_controller == "iter") || (_controller == "ITER")) {
+         dt_controller = TimeStepController::ITER;
+      }
+      else if ((_controller == "pi") || (_controller == "PI")) {
+         dt_controller = TimeStepController::PI;
+      }
+      else {
+         MFEM_ABORT("Time.Auto.controller was not provided a valid type.");
+         dt_controller = TimeStepController::NOTYPE;
+      }
+      dt_growth_max = toml::find_or<double>(auto_table, "dt_growth_max", 2.0);
+      if (dt_growth_max < 1.0) {
+         MFEM_ABORT("dt_growth_max for auto time stepping needs to be greater than or equal to 1.");
+      }
    }
    // Time to look at our custom time table stuff
    // check to see if our table exists
@@ -554,6 +781,21 @@ void ExaOptions::get_visualizations()
    std::string _avg_dp_tensor_fname = toml::find_or<std::string>(table, "avg_dp_tensor_fname", "avg_dp_tensor.txt");
    avg_dp_tensor_fname = _avg_dp_tensor_fname;
    light_up = toml::find_or<bool>(table, "light_up", false);
+   avg_binary_fname = toml::find_or<std::string>(table, "avg_binary_fname", "");
+   avg_flush_steps = toml::find_or<int>(table, "avg_flush_steps", 100);
+   if (avg_flush_steps < 1) {
+      MFEM_ABORT("Visualizations.avg_flush_steps needs to be at least 1.");
+   }
+   vis_async = toml::find_or<bool>(table, "async_output", false);
+   vis_async_queue = toml::find_or<int>(table, "async_queue_size", 2);
+   if (vis_async_queue < 1) {
+      MFEM_ABORT("Visualizations.async_queue_size needs to be at least 1.");
+   }
+   vis_aggregate = toml::find_or<bool>(table, "aggregated_output", false);
+   vis_agg_group_size = toml::find_or<int>(table, "io_group_size", 32);
+   if (vis_agg_group_size < 1) {
+      MFEM_ABORT("Visualizations.io_group_size needs to be at least 1.");
+   }
 } // end of visualization parsing
 
 // From the toml file it finds all the values related to the Solvers
@@ -628,6 +870,11 @@ void ExaOptions::get_solvers()
       }
    }
 
+   static_cond = toml::find_or<bool>(table, "static_condensation", false);
+   if (static_cond && assembly == Assembly::PA) {
+      MFEM_ABORT("Solvers.static_condensation is only available with FULL or EA assembly.");
+   }
+
    if (table.contains("Krylov")) {
       // Now getting information about the Krylov solvers used to the linearized
       // system of equations of the nonlinear problem.
@@ -645,10 +892,42 @@ void ExaOptions::get_solvers()
       else if ((_solver == "MINRES") || (_solver == "minres")) {
          solver = KrylovSolver::MINRES;
       }
+#if defined(MFEM_USE_SUPERLU)
+      else if ((_solver == "SUPERLU") || (_solver == "SuperLU") || (_solver == "superlu")) {
+         solver = KrylovSolver::SUPERLU;
+      }
+#endif
+#if defined(MFEM_USE_MUMPS)
+      else if ((_solver == "MUMPS") || (_solver == "mumps")) {
+         solver = KrylovSolver::MUMPS;
+      }
+#endif
+#if defined(MFEM_USE_STRUMPACK)
+      else if ((_solver == "STRUMPACK") || (_solver == "strumpack")) {
+         solver = KrylovSolver::STRUMPACK;
+      }
+#endif
       else {
          MFEM_ABORT("Solvers.Krylov.solver was not provided a valid type.");
          solver = KrylovSolver::NOTYPE;
       }
+
+      krylov_mixed_prec = toml::find_or<bool>(iter_table, "mixed_precision", false);
+      if (krylov_mixed_prec && solver != KrylovSolver::GMRES) {
+         MFEM_ABORT("Solvers.Krylov.mixed_precision is only available with the GMRES solver.");
+      }
+      // Only the PA and EA Jacobi preconditioner has a single precision version
+      if (krylov_mixed_prec && (assembly == Assembly::FULL || static_cond)) {
+         MFEM_ABORT("Solvers.Krylov.mixed_precision is only available with PA or EA assembly "
+                    "without static condensation.");
+      }
+
+      const bool direct_solver = (solver == KrylovSolver::SUPERLU) ||
+                                 (solver == KrylovSolver::MUMPS) ||
+                                 (solver == KrylovSolver::STRUMPACK);
+      if (direct_solver && assembly != Assembly::FULL && !static_cond) {
+         MFEM_ABORT("Solvers.Krylov.solver can only be a direct solver with FULL assembly or static condensation.");
+      }
    } // end of krylov solver info
 } // end of solver parsing
 
@@ -660,6 +939,20 @@ void ExaOptions::get_mesh()
    const auto& table = toml::find(data, "Mesh");
    ser_ref_levels = toml::find_or<int>(table, "ref_ser", 0);
    par_ref_levels = toml::find_or<int>(table, "ref_par", 0);
+   // Weighted partitioning of the mesh and the per-element material cost output
+   // used to generate those weights
+   part_weights_file = toml::find_or<std::string>(table, "partition_weights_floc", "");
+   part_cost_steps = toml::find_or<int>(table, "partition_cost_steps", 0);
+   part_cost_file = toml::find_or<std::string>(table, "partition_cost_floc", "elem_costs.txt");
+   if (part_weights_file != "" && !if_file_exists(part_weights_file)) {
+      MFEM_ABORT("Mesh.partition_weights_floc file does not exist");
+   }
+   if ((part_weights_file != "" || part_cost_steps > 0) && par_ref_levels > 0) {
+      MFEM_ABORT("Mesh.partition_weights_floc and Mesh.partition_cost_steps can not be used with Mesh.ref_par.");
+   }
+   if (part_cost_steps > 0 && mech_type != MechType::EXACMECH) {
+      MFEM_ABORT("Mesh.partition_cost_steps is only available for ExaCMech models.");
+   }
    order = toml::find_or<int>(table, "p_refinement", 1);
    // file location of the mesh
    std::string _mesh_file = toml::find_or<std::string>(table, "floc", "../../data/cube-hex-ro.mesh");
@@ -709,6 +1002,31 @@ void ExaOptions::get_mesh()
    }
 } // End of mesh parsing
 
+// From the toml file it finds all the values related to the checkpoints, which
+// is an optional table
+void ExaOptions::get_checkpoint()
+{
+   const auto data = toml::parse(floc);
+   if (!data.contains("Checkpoint")) {
+      return;
+   }
+   const auto& table = toml::find(data, "Checkpoint");
+   chkpt_steps = toml::find_or<int>(table, "steps", 0);
+   chkpt_basename = toml::find_or<std::string>(table, "floc", "checkpoints/exaconstit");
+   chkpt_async = toml::find_or<bool>(table, "async", true);
+   restart_file = toml::find_or<std::string>(table, "restart_floc", "");
+   if (chkpt_steps < 0) {
+      MFEM_ABORT("Checkpoint.steps needs to be 0 or greater.");
+   }
+   if (restart_file != "" && !if_file_exists(restart_file)) {
+      MFEM_ABORT("Checkpoint.restart_floc file does not exist");
+   }
+   // The checkpoints identify the elements through the serial mesh element ids
+   if ((chkpt_steps > 0 || restart_file != "") && par_ref_levels > 0) {
+      MFEM_ABORT("Checkpoint.steps and Checkpoint.restart_floc can not be used with Mesh.ref_par.");
+   }
+} // End of checkpoint parsing
+
 void ExaOptions::print_options()
 {
    std::cout << "Mesh file location: " << mesh_file << std::endl;
@@ -729,7 +1047,22 @@ void ExaOptions::print_options()
 
    std::cout << "Serial Refinement level: " << ser_ref_levels << std::endl;
    std::cout << "Parallel Refinement level: " << par_ref_levels << std::endl;
+   if (part_weights_file != "") {
+      std::cout << "Partition weights file location: " << part_weights_file << std::endl;
+   }
+   std::cout << "Element material cost output steps: " << part_cost_steps << std::endl;
+   if (part_cost_steps > 0) {
+      std::cout << "Element material cost file location: " << part_cost_file << std::endl;
+   }
    std::cout << "P-refinement level: " << order << std::endl;
+   std::cout << "Checkpoint steps: " << chkpt_steps << std::endl;
+   if (chkpt_steps > 0) {
+      std::cout << "Checkpoint file location: " << chkpt_basename << std::endl;
+      std::cout << "Checkpoints written with non-blocking writes: " << chkpt_async << std::endl;
+   }
+   if (restart_file != "") {
+      std::cout << "Restarting from the checkpoint: " << restart_file << std::endl;
+   }
 
    std::cout << std::boolalpha;
    if (dt_cust) {
@@ -743,7 +1076,15 @@ void ExaOptions::print_options()
       std::cout << "Final time (t_final): " << t_final << std::endl;
       std::cout << "Initial time step (dt): " << dt << std::endl;
       std::cout << "Minimum time step (dt): " << dt_min << std::endl;
+      std::cout << "Maximum time step (dt): " << dt_max << std::endl;
       std::cout << "Time step scale factor: " << dt_scale << std::endl;
+      if (dt_controller == TimeStepController::ITER) {
+         std::cout << "Time step controller is Newton iteration scaling" << std::endl;
+      }
+      else if (dt_controller == TimeStepController::PI) {
+         std::cout << "Time step controller is PI" << std::endl;
+         std::cout << "Maximum time step growth factor: " << dt_growth_max << std::endl;
+      }
       std::cout << "Auto time step output file: " << dt_file << std::endl;
    }
    else
@@ -759,6 +1100,14 @@ void ExaOptions::print_options()
    std::cout << "ADIOS2 flag: " << adios2 << std::endl;
    std::cout << "Visualization steps: " << vis_steps << std::endl;
    std::cout << "Visualization directory: " << basename << std::endl;
+   std::cout << "Visualization files written in the background: " << vis_async << std::endl;
+   if (vis_async) {
+      std::cout << "Visualization snapshot queue size: " << vis_async_queue << std::endl;
+   }
+   std::cout << "Element fields written through aggregator processes: " << vis_aggregate << std::endl;
+   if (vis_aggregate) {
+      std::cout << "Number of processes per aggregator: " << vis_agg_group_size << std::endl;
+   }
 
    std::cout << "Average stress filename: " << avg_stress_fname << std::endl;
    if (additional_avgs)
@@ -773,6 +1122,10 @@ void ExaOptions::print_options()
       std::cout << "No additional averages being computed" << std::endl;
    }
    std::cout << "Average stress filename: " << avg_stress_fname << std::endl;
+   if (avg_binary_fname != "") {
+      std::cout << "Averages written to the binary time series file: " << avg_binary_fname << std::endl;
+      std::cout << "Binary time series steps between writes: " << avg_flush_steps << std::endl;
+   }
    std::cout << "Light-up flag: " << light_up << std::endl;
 
    if (nl_solver == NLSolver::NR) {
@@ -801,14 +1154,24 @@ void ExaOptions::print_options()
    else if (solver == KrylovSolver::PCG) {
       std::cout << "PCG";
    }
-   else {
+   else if (solver == KrylovSolver::MINRES) {
       std::cout << "MINRES";
    }
+   else if (solver == KrylovSolver::SUPERLU) {
+      std::cout << "SuperLU_DIST (direct)";
+   }
+   else if (solver == KrylovSolver::MUMPS) {
+      std::cout << "MUMPS (direct)";
+   }
+   else {
+      std::cout << "STRUMPACK (direct)";
+   }
    std::cout << std::endl;
 
    std::cout << "Krylov solver rel. tol.: " << krylov_rel_tol << std::endl;
    std::cout << "Krylov solver abs. tol.: " << krylov_abs_tol << std::endl;
    std::cout << "Krylov solver # of iter.: " << krylov_iter << std::endl;
+   std::cout << "Krylov solver mixed precision: " << krylov_mixed_prec << std::endl;
 
    std::cout << "Matrix Assembly is: ";
    if (assembly == Assembly::FULL) {
@@ -820,6 +1183,7 @@ void ExaOptions::print_options()
    else {
       std::cout << "Element Assembly" << std::endl;
    }
+   std::cout << "Static condensation: " << static_cond << std::endl;
 
    std::cout << "Runtime model is: ";
    if (rtmodel == RTModel::CPU) {
@@ -836,6 +1200,13 @@ void ExaOptions::print_options()
 
    if (mech_type == MechType::UMAT) {
       std::cout << "UMAT" << std::endl;
+      std::cout << "UMAT calls split across the OpenMP threads: " << umat_threaded << std::endl;
+      std::cout << "Batched user material block size: " << umat_batch_size << std::endl;
+      std::cout << "UMAT pnewdt used by the automatic time stepping: " << umat_honor_pnewdt << std::endl;
+   }
+   else if (mech_type == MechType::SURROGATE) {
+      std::cout << "Surrogate" << std::endl;
+      std::cout << "Surrogate model weights file location: " << surrogate_weights_file << std::endl;
    }
    else if (mech_type == MechType::EXACMECH) {
       std::cout << "ExaCMech" << std::endl;
@@ -861,6 +1232,33 @@ void ExaOptions::print_options()
       else if (slip_type == SlipType::POWERVOCENL) {
          std::cout << "Power law slip kinetics with a nonlinear Voce hardening law" << std::endl;
       }
+
+      std::cout << "Elastic fast path being used: " << ecmech_elastic_fast << std::endl;
+      if (ecmech_elastic_fast) {
+         std::cout << "Elastic fast path resolved shear stress ratio: " << ecmech_elastic_ratio << std::endl;
+      }
+      std::cout << "Material kernel chunk size: " << ecmech_chunk_size << std::endl;
+      if (ecmech_chunk_size > 0) {
+         std::cout << "Material kernel chunk schedule: " << (ecmech_chunk_dynamic ? "dynamic" : "static") << std::endl;
+      }
+      std::cout << "State variables stored as a structure of arrays: " << ecmech_soa_state << std::endl;
+      std::cout << "Shear rates stored in single precision: " << ecmech_float_gdot << std::endl;
+      std::cout << "Max compacted material batch size: " << ecmech_batch_size << std::endl;
+      std::cout << "Material update sub-stepping evaluation limit: " << ecmech_substep_max_evals << std::endl;
+      if (ecmech_substep_max_evals > 0) {
+         std::cout << "Material update max number of sub-steps: " << ecmech_max_substeps << std::endl;
+      }
+      if (ecmech_surrogate_samples != "") {
+         std::cout << "Surrogate model training data file location: " << ecmech_surrogate_samples << std::endl;
+         std::cout << "Surrogate model training data point stride: " << ecmech_surrogate_stride << std::endl;
+      }
+
+      std::cout << "Number of additional material regions: " << regions.size() << std::endl;
+      for (const auto &region : regions) {
+         std::cout << "Region element attributes: " << region.attr_min << " - " << region.attr_max << std::endl;
+         std::cout << "Region property file location: " << region.props_file << std::endl;
+         std::cout << "Region number of properties: " << region.nProps << std::endl;
+      }
    }
 
    std::cout << "Xtal Plasticity being used: " << cp << std::endl;
@@ -916,3 +1314,18 @@ void ExaOptions::print_options()
       std::cout << std::endl;
    }
 } // End of printing out options
+
+bool async_output_requested(const std::string &floc)
+{
+   try {
+      const auto data = toml::parse(floc);
+      if (!data.contains("Visualizations")) {
+         return false;
+      }
+      const auto& table = toml::find(data, "Visualizations");
+      return toml::find_or<bool>(table, "async_output", false);
+   }
+   catch (const std::exception &) {
+      return false;
+   }
+}
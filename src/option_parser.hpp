@@ -11,6 +11,18 @@
 
 typedef std::map<std::string, std::unordered_map<int, std::vector<int> >> map_of_imap;
 
+// An ExaCMech material region made up of all the elements whose attribute
+// falls within [attr_min, attr_max]. Each region has its own crystal type,
+// slip kinetics, and material properties.
+struct RegionOptions {
+   int attr_min;
+   int attr_max;
+   XtalType xtal_type;
+   SlipType slip_type;
+   std::string props_file;
+   int nProps;
+};
+
 class ExaOptions {
    public:
 
@@ -25,15 +37,34 @@ class ExaOptions {
       int ser_ref_levels;
       int par_ref_levels;
 
+      // element weights used to partition the mesh across the processes
+      std::string part_weights_file;
+      // how often the per-element material cost is written out, 0 is never
+      int part_cost_steps;
+      std::string part_cost_file;
+
       // polynomial interpolation order
       int order;
 
+      // how often a checkpoint of the simulation state is written out, 0 is never
+      int chkpt_steps;
+      // where the checkpoint files are written to
+      std::string chkpt_basename;
+      // write the checkpoints with non-blocking MPI-IO calls
+      bool chkpt_async;
+      // manifest file of the checkpoint to restart the simulation from
+      std::string restart_file;
+
       // final simulation time and time step (set each to 1.0 for
       // single step debug)
       double t_final;
       double dt;
       double dt_min;
+      double dt_max;
       double dt_scale;
+      // Maximum factor the PI controller is allowed to grow dt by in a step
+      double dt_growth_max;
+      TimeStepController dt_controller;
       // We have a custom dt flag
       bool dt_cust;
       bool dt_auto;
@@ -59,8 +90,21 @@ class ExaOptions {
       std::string avg_dp_tensor_fname;
       std::string avg_def_grad_fname;
       bool additional_avgs;
+      // If set the averages are written to this buffered binary time series
+      // file instead of the above text files
+      std::string avg_binary_fname;
+      // Number of time steps buffered between writes of the binary time series file
+      int avg_flush_steps;
       // light up values
       bool light_up = false;
+      // Write the visit, conduit, and paraview files on a background thread
+      bool vis_async;
+      // Max number of snapshots waiting to be written by the background thread
+      int vis_async_queue;
+      // Write the element fields out through aggregator processes
+      bool vis_aggregate;
+      // Number of processes in each aggregator's group
+      int vis_agg_group_size;
 
       // newton input args
       double newton_rel_tol;
@@ -80,6 +124,10 @@ class ExaOptions {
       int krylov_iter;
 
       KrylovSolver solver;
+      // Apply the Jacobi preconditioner in single precision within GMRES
+      bool krylov_mixed_prec;
+      // Statically condense out the element interior dofs before the linear solve
+      bool static_cond;
 
       // input arg to specify crystal plasticity
       bool cp;
@@ -92,6 +140,40 @@ class ExaOptions {
       XtalType xtal_type;
       // Specify the temperature of the material
       double temp_k;
+      // Elastic points are updated in closed form rather than by ExaCMech
+      bool ecmech_elastic_fast;
+      // Ratio of the max resolved shear stress to the CRSS below which a point is elastic
+      double ecmech_elastic_ratio;
+      // Number of points per chunk when the material kernel is split up across
+      // the OpenMP threads by us, 0 leaves it up to ExaCMech
+      int ecmech_chunk_size;
+      // Dynamic cost ordered scheduling of the chunks if true and static if false
+      bool ecmech_chunk_dynamic;
+      // Store the state variables as a structure of arrays rather than an array of structures
+      bool ecmech_soa_state;
+      // Store the shear rates in single precision
+      bool ecmech_float_gdot;
+      // Max number of points compacted into a batch for ExaCMech at once, 0 is no limit
+      int ecmech_batch_size;
+      // Points that take more than this many evaluations are sub-stepped, 0 is off
+      int ecmech_substep_max_evals;
+      // Max number of sub-steps a point's material update can be split into
+      int ecmech_max_substeps;
+      // Binary file that ExaCMech stress updates are saved to as surrogate model training data
+      std::string ecmech_surrogate_samples;
+      // Only every this many quadrature points are saved to the training data file
+      int ecmech_surrogate_stride;
+      // Split the UMAT calls up across the OpenMP threads
+      bool umat_threaded;
+      // Number of points per block sent to the batched user material, 0 uses the per point UMAT
+      int umat_batch_size;
+      // Use the UMAT's pnewdt when cutting back or growing the time step
+      bool umat_honor_pnewdt;
+      // Network weights file used by the surrogate model
+      std::string surrogate_weights_file;
+      // Additional ExaCMech material regions. Elements outside of all of these
+      // use the model given by Model.ExaCMech and Properties.Matl_Props.
+      std::vector<RegionOptions> regions;
 
 
       // grain input arguments
@@ -168,6 +250,21 @@ class ExaOptions {
          xtal_type = XtalType::NOTYPE;
          // Specify the temperature of the material
          temp_k = 298.;
+         ecmech_elastic_fast = false;
+         ecmech_elastic_ratio = 0.5;
+         ecmech_chunk_size = 0;
+         ecmech_chunk_dynamic = true;
+         ecmech_soa_state = false;
+         ecmech_float_gdot = false;
+         ecmech_batch_size = 4096;
+         ecmech_substep_max_evals = 0;
+         ecmech_max_substeps = 8;
+         ecmech_surrogate_samples = "";
+         ecmech_surrogate_stride = 1;
+         umat_threaded = false;
+         umat_batch_size = 0;
+         umat_honor_pnewdt = false;
+         surrogate_weights_file = "";
 
          // Krylov Solver related variables
          // We set the default solver as GMRES in case we accidentally end up dealing
@@ -176,6 +273,7 @@ class ExaOptions {
          krylov_rel_tol = 1.0e-10;
          krylov_abs_tol = 1.0e-30;
          krylov_iter = 200;
+         krylov_mixed_prec = false;
 
          // NR parameters
          newton_rel_tol = 1.0e-5;
@@ -194,6 +292,12 @@ class ExaOptions {
          paraview = false;
          adios2 = false;
          vis_steps = 1;
+         vis_async = false;
+         vis_async_queue = 2;
+         vis_aggregate = false;
+         avg_binary_fname = "";
+         avg_flush_steps = 100;
+         vis_agg_group_size = 32;
          //
          avg_stress_fname = "avg_stress.txt";
          avg_pl_work_fname = "avg_pl_work.txt";
@@ -205,6 +309,10 @@ class ExaOptions {
          t_final = 1.0;
          dt = 1.0;
          dt_min = dt;
+         dt_max = t_final;
+         dt_scale = 0.25;
+         dt_growth_max = 2.0;
+         dt_controller = TimeStepController::ITER;
          dt_cust = false;
          dt_auto = false;
          nsteps = 1;
@@ -213,6 +321,9 @@ class ExaOptions {
          // Mesh related variables
          ser_ref_levels = 0;
          par_ref_levels = 0;
+         part_weights_file = "";
+         part_cost_steps = 0;
+         part_cost_file = "elem_costs.txt";
          order = 1;
          mesh_file = "../../data/cube-hex-ro.mesh";
          mesh_type = MeshType::OTHER;
@@ -225,8 +336,15 @@ class ExaOptions {
          nxyz[1] = 1;
          nxyz[2] = 1;
 
+         // Checkpoint related variables
+         chkpt_steps = 0;
+         chkpt_basename = "checkpoints/exaconstit";
+         chkpt_async = true;
+         restart_file = "";
+
          assembly = Assembly::FULL;
          rtmodel = RTModel::CPU;
+         static_cond = false;
       } // End of ExaOptions constructor
 
       virtual ~ExaOptions() {}
@@ -255,10 +373,18 @@ class ExaOptions {
       // From the toml file it finds all the values related to the mesh
       void get_mesh();
 
+      // From the toml file it finds all the values related to the checkpoints
+      void get_checkpoint();
+
       // Prints out a list of all the options being used
       void print_options();
 };
 
+// Checks whether the option file turns on Visualizations.async_output without
+// parsing the rest of it, so it can be called before MPI is initialized. If the
+// file can't be read false is returned, and the full parse reports the problem.
+bool async_output_requested(const std::string &floc);
+
 
 
 
@@ -2,7 +2,9 @@
 #define OPTION_TYPES
 
 // Taking advantage of C++11 to make it much clearer that we're using enums
-enum class KrylovSolver { GMRES, PCG, MINRES, NOTYPE };
+// SUPERLU, MUMPS, and STRUMPACK are sparse direct solvers that are only available
+// if MFEM was built with them and require an assembled system.
+enum class KrylovSolver { GMRES, PCG, MINRES, SUPERLU, MUMPS, STRUMPACK, NOTYPE };
 enum class OriType { EULER, QUAT, CUSTOM, NOTYPE };
 enum class MeshType { CUBIT, AUTO, OTHER, NOTYPE };
 // Later on we'll want to support multiple different types here like
@@ -11,7 +13,7 @@ enum class MeshType { CUBIT, AUTO, OTHER, NOTYPE };
 enum class XtalType { FCC, BCC, HCP, NOTYPE };
 // We currently only have support for UMATs and ExaCMech later on this might change
 // to add support for more systems.
-enum class MechType { UMAT, EXACMECH, NOTYPE };
+enum class MechType { UMAT, EXACMECH, SURROGATE, NOTYPE };
 // Hardening law and slip kinetics we'll be using if ExaCMech is specified
 // MTSDD refers to a MTS like slip kinetics with DD hardening evolution
 // POWERVOCE refers to power law slip kinetics with a linear voce hardening law
@@ -43,4 +45,10 @@ enum class NLSolver { NR, NRLS, NOTYPE };
 // Integration formulation that we want to use
 enum class IntegrationType { FULL, BBAR, NOTYPE };
 
+// The controller used to pick the next time step when auto time stepping is on.
+// ITER is the original Newton iteration ratio scaling and PI is a
+// proportional-integral controller based on the Newton iteration count and
+// residual contraction history.
+enum class TimeStepController { ITER, PI, NOTYPE };
+
 #endif
\ No newline at end of file
@@ -4,11 +4,16 @@
 #include "system_driver.hpp"
 #include "RAJA/RAJA.hpp"
 #include "mechanics_kernels.hpp"
+#include "mechanics_ecmech.hpp"
 #include "BCData.hpp"
 #include "BCManager.hpp"
 
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
 #include "ECMech_const.h"
 
 using namespace mfem;
@@ -85,6 +90,10 @@ SystemDriver::SystemDriver(ParFiniteElementSpace &fes,
                                              beg_crds, end_crds, matProps,
                                              nStateVars);
    model = mech_operator->GetModel();
+   // Single precision state variables shrink the number of stored state variables
+   if (evec->GetVDim() != model->GetMatVars0()->GetVDim()) {
+      evec->SetVDim(model->GetMatVars0()->GetVDim());
+   }
 
    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
@@ -101,15 +110,56 @@ SystemDriver::SystemDriver(ParFiniteElementSpace &fes,
    if (auto_time) {
       dt_min = options.dt_min;
       dt_class = options.dt;
+      dt_max = options.dt_max;
       dt_scale = options.dt_scale;
+      dt_growth_max = options.dt_growth_max;
+      dt_controller = options.dt_controller;
+      newton_rel_tol = options.newton_rel_tol;
       auto_dt_fname = options.dt_file;
+      if (myid == 0 && options.avg_binary_fname == "") {
+         auto_dt_file.open(auto_dt_fname, std::ios_base::app);
+      }
+   }
+
+   // The binary time series file holds everything that would have gone to the
+   // average and dt text files
+   if (myid == 0 && options.avg_binary_fname != "") {
+      std::vector<std::string> columns = { "time", "dt", "step", "newton_iters", "krylov_iters" };
+      const std::vector<std::string> voigt = { "11", "22", "33", "23", "13", "12" };
+      const std::vector<std::string> tens = { "11", "21", "31", "12", "22", "32", "13", "23", "33" };
+      for (const auto &comp : voigt) {
+         columns.push_back("stress_" + comp);
+      }
+      if (mech_type == MechType::EXACMECH && additional_avgs) {
+         columns.push_back("pl_work");
+      }
+      if (additional_avgs) {
+         for (const auto &comp : tens) {
+            columns.push_back("def_grad_" + comp);
+         }
+      }
+      if (mech_type == MechType::EXACMECH && additional_avgs) {
+         for (const auto &comp : voigt) {
+            columns.push_back("dp_tensor_" + comp);
+         }
+      }
+      // On a restart the records from before the checkpoint are kept, which is
+      // sorted out once we know the checkpoint's step in SetCheckpointState
+      avg_writer.reset(new TimeSeriesWriter(options.avg_binary_fname, columns, options.avg_flush_steps,
+                                            options.dt_auto, options.restart_file != ""));
    }
 
    // Partial assembly we need to use a matrix free option instead for our preconditioner
-   // Everything else remains the same.
-   if (options.assembly != Assembly::FULL) {
+   // Everything else remains the same. The statically condensed system is always
+   // assembled, so it can make use of the full assembly preconditioners.
+   if (options.assembly != Assembly::FULL && !options.static_cond) {
       J_prec = mech_operator->GetPAPreconditioner();
    }
+   else if (options.solver == KrylovSolver::SUPERLU || options.solver == KrylovSolver::MUMPS ||
+            options.solver == KrylovSolver::STRUMPACK) {
+      // The direct solvers don't need a preconditioner
+      J_prec = nullptr;
+   }
    else {
       if (options.solver == KrylovSolver::GMRES || options.solver == KrylovSolver::PCG) {
          HypreBoomerAMG *prec_amg = new HypreBoomerAMG();
@@ -149,6 +199,10 @@ SystemDriver::SystemDriver(ParFiniteElementSpace &fes,
       }
    }
    if (options.solver == KrylovSolver::GMRES) {
+      // The single precision Jacobi preconditioner is still a diagonal scaling,
+      // just with a relative rounding error around 6e-8 on each entry. That's far
+      // below the Newton tolerances the linear solves feed into, so plain GMRES
+      // is used rather than paying for the second basis a flexible GMRES keeps.
       GMRESSolver *J_gmres = new GMRESSolver(fe_space.GetComm());
       // These tolerances are currently hard coded while things are being debugged
       // but they should eventually be moved back to being set by the options
@@ -175,6 +229,10 @@ SystemDriver::SystemDriver(ParFiniteElementSpace &fes,
       J_pcg->SetPreconditioner(*J_prec);
       J_solver = J_pcg;
    }
+   else if (options.solver == KrylovSolver::SUPERLU || options.solver == KrylovSolver::MUMPS ||
+            options.solver == KrylovSolver::STRUMPACK) {
+      J_solver = new ExaDirectSolver(fe_space.GetComm(), options.solver);
+   }
    else {
       MINRESSolver *J_minres = new MINRESSolver(fe_space.GetComm());
       J_minres->SetRelTol(options.krylov_rel_tol);
@@ -195,15 +253,39 @@ SystemDriver::SystemDriver(ParFiniteElementSpace &fes,
       newton_solver = new ExaNewtonLSSolver(fes.GetComm());
    }
 
+   if (options.static_cond) {
+      J_sc_solver = new MechStaticCondSolver(fes, mech_operator->GetEssTDofList(), *J_solver);
+      if (myid == 0 && !J_sc_solver->ReducesTrueVSize()) {
+         MFEM_WARNING("Static condensation does not reduce the system size for this mesh / element order");
+      }
+   }
+
    // Set the newton solve parameters
    newton_solver->iterative_mode = true;
-   newton_solver->SetSolver(*J_solver);
+   if (J_sc_solver != nullptr) {
+      newton_solver->SetSolver(*J_sc_solver);
+   }
+   else {
+      newton_solver->SetSolver(*J_solver);
+   }
    newton_solver->SetOperator(*mech_operator);
    newton_solver->SetPrintLevel(1);
    newton_solver->SetRelTol(options.newton_rel_tol);
    newton_solver->SetAbsTol(options.newton_abs_tol);
    newton_solver->SetMaxIter(options.newton_iter);
-   if (options.visit || options.conduit || options.paraview || options.adios2) {
+   if (auto_time && mech_type == MechType::UMAT && options.umat_honor_pnewdt) {
+      honor_dt_ratio = true;
+      newton_solver->SetDtRatioCheck(true);
+   }
+   if (mech_type == MechType::EXACMECH && options.ecmech_surrogate_samples != "") {
+      surrogate_stride = options.ecmech_surrogate_stride;
+      surrogate_samples_file.open(options.ecmech_surrogate_samples + "." + std::to_string(myid),
+                                  std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+      if (!surrogate_samples_file) {
+         MFEM_ABORT("Cannot open the surrogate model training data file: " << options.ecmech_surrogate_samples);
+      }
+   }
+   if (options.visit || options.conduit || options.paraview || options.adios2 || options.vis_aggregate) {
       postprocessing = true;
       CalcElementAvg(evec, model->GetMatVars0());
    } else {
@@ -220,56 +302,71 @@ const Array<int> &SystemDriver::GetEssTDofList()
 void SystemDriver::Solve(Vector &x)
 {
    Vector zero;
+   // The end step coordinates are about to change
+   geom_weights_valid = false;
 
    if (auto_time) {
       // This would only happen on the last time step
       if (solVars.GetLastStep()) {
          dt_class = solVars.GetDTime();
       }
-      const double dt_old = dt_class;
-      Vector xprev(x); x.UseDevice(true);
+      const double beg_time = solVars.GetTime() - solVars.GetDTime();
+      // The beginning time step state (beg_coords, stress0, and matVars0) is never
+      // written to during the nonlinear solve as the models only ever update
+      // their end time step buffers. So, rolling back a failed step only requires
+      // us to reset our solution vector. The end coordinates are recomputed from
+      // the beginning time step coordinates and x at the start of the next solve.
+      Vector xprev(x); xprev.UseDevice(true);
       // We provide an initial guess for what our current coordinates will look like
       // based on what our last time steps solution was for our velocity field.
       // The end nodes are updated before the 1st step of the solution here so we're good.
       newton_solver->Mult(zero, x);
-      if (!newton_solver->GetConverged())
-      {
-         int iter = 0;
-         while (!newton_solver->GetConverged() && (iter < 2)) {
-            if (myid == 0) {
-               MFEM_WARNING("Solution did not converge decreasing dt by input scale factor");
+      bool cut_back = false;
+      while (!newton_solver->GetConverged()) {
+         double cut_scale = dt_scale;
+         // If the material model asked for a smaller time step we go with it
+         if (honor_dt_ratio) {
+            const double dt_ratio = mech_operator->GetSuggestedDtRatio();
+            if (dt_ratio < 1.0) {
+               cut_scale = dt_ratio;
             }
-            x = xprev;
-            // Decrease it by a quarter and try again
-            dt_class *= dt_scale;
-            if (dt_class < dt_min) { dt_class = dt_min; }
-            SetDt(dt_class);
-            newton_solver->Mult(zero, x);
-            iter += 1;
-         } // Do final converge check outside of this while loop
-         const double old_time = solVars.GetTime();
-         const double new_time = old_time - dt_old + dt_class;
-         solVars.SetTime(new_time);
-         solVars.SetDt(dt_class);
+         }
+         const double dt_cut = std::max(dt_class * cut_scale, dt_min);
+         // We can't cut back any further so we'll exit out below
+         if (dt_cut >= dt_class) {
+            break;
+         }
+         if (myid == 0) {
+            MFEM_WARNING("Solution did not converge decreasing dt by input scale factor");
+         }
+         cut_back = true;
+         x = xprev;
+         dt_class = dt_cut;
+         SetTime(beg_time + dt_class);
+         SetDt(dt_class);
+         newton_solver->Mult(zero, x);
+      } // Do final converge check outside of this while loop
+
+      if (newton_solver->GetConverged()) {
+         // Now we're going to save off the current dt value
+         if (myid == 0 && auto_dt_file.is_open()) {
+            auto_dt_file << std::setprecision(12) << dt_class << std::endl;
+         }
+         // update the dt
+         double factor = ComputeDtFactor(cut_back);
+         // The material model can also limit how much the time step grows
+         if (honor_dt_ratio) {
+            factor = std::min(factor, mech_operator->GetSuggestedDtRatio());
+         }
+         dt_class *= factor;
+         if (dt_class < dt_min) { dt_class = dt_min; }
+         if (dt_class > dt_max) { dt_class = dt_max; }
+         if (myid == 0) {
+            std::cout << "Time "<< solVars.GetTime() << " dt old was " << solVars.GetDTime() << " dt has been updated to " << dt_class << " and changed by a factor of " << factor << std::endl;
+         }
       }
-
-      // Now we're going to save off the current dt value
-      if (myid == 0 && newton_solver->GetConverged()) {
-         std::ofstream file;
-         file.open(auto_dt_fname, std::ios_base::app);
-         file << std::setprecision(12) << dt_class << std::endl;
-      }
-
-      // update the dt
-      const double niter_scale = ((double) newton_iter) * dt_scale;
-      const double nr_iter = (double) newton_solver->GetNumIterations();
-      // Will approach dt_scale as nr_iter -> newton_iter
-      // dt increases as long as nr_iter > niter_scale
-      const  double factor = niter_scale / nr_iter;
-      dt_class *= factor;
-      if (dt_class < dt_min) { dt_class = dt_min; }
-      if (myid == 0 && newton_solver->GetConverged()) {
-         std::cout << "Time "<< solVars.GetTime() << " dt old was " << solVars.GetDTime() << " dt has been updated to " << dt_class << " and changed by a factor of " << factor << std::endl;
+      else if (myid == 0) {
+         MFEM_WARNING("Solution did not converge with dt at Time.Auto.dt_min");
       }
    }
    else {
@@ -286,6 +383,50 @@ void SystemDriver::Solve(Vector &x)
    MFEM_VERIFY(newton_solver->GetConverged(), "Newton Solver did not converge.");
 }
 
+double SystemDriver::ComputeDtFactor(const bool cut_back)
+{
+   const double niter_scale = ((double) newton_iter) * dt_scale;
+   const double nr_iter = (double) newton_solver->GetNumIterations();
+
+   if (dt_controller == TimeStepController::ITER) {
+      // Will approach dt_scale as nr_iter -> newton_iter
+      // dt increases as long as nr_iter > niter_scale
+      return niter_scale / nr_iter;
+   }
+
+   // PI controller gains for a first order error estimate (Gustafsson's
+   // recommended kI = 0.3 and kP = 0.4)
+   const double k_i = 0.3;
+   const double k_p = 0.4;
+   const double niter_target = std::max(niter_scale, 1.0);
+   // Our error estimate is normalized such that it's 1 when we take our target
+   // number of iterations
+   double err = nr_iter / niter_target;
+   if (nr_iter > 0.0 && newton_solver->GetInitialNorm() > 0.0) {
+      // Average contraction of the residual per Newton iteration compared to the
+      // rate needed to reach our relative tolerance in niter_target iterations.
+      // A slowly contracting solve is close to failing even if it converged
+      // within the iteration target.
+      const double rho = std::pow(newton_solver->GetFinalNorm() / newton_solver->GetInitialNorm(),
+                                  1.0 / nr_iter);
+      const double rho_target = std::pow(newton_rel_tol, 1.0 / niter_target);
+      const double err_rho = (rho < 1.0) ? std::log(rho_target) / std::log(rho) : dt_growth_max;
+      err = std::max(err, err_rho);
+   }
+   // Keeps us from dividing by zero if the initial guess was already converged
+   err = std::max(err, 1.0 / dt_growth_max);
+
+   double factor = std::pow(1.0 / err, k_i) * std::pow(dt_err_prev / err, k_p);
+   dt_err_prev = err;
+
+   factor = std::min(std::max(factor, dt_scale), dt_growth_max);
+   // Don't grow the time step right after we had to cut it back
+   if (cut_back) {
+      factor = std::min(factor, 1.0);
+   }
+   return factor;
+}
+
 // Solve the Newton system for the 1st time step
 // It was found that for large meshes a ramp up to our desired applied BC might
 // be needed.
@@ -422,6 +563,37 @@ void SystemDriver::UpdateModel()
 {
    const ParFiniteElementSpace *fes = GetFESpace();
 
+   // The converged stress updates are saved off as training data for the surrogate
+   // model before the end step values get swapped into the beginning step ones.
+   if (surrogate_samples_file.is_open()) {
+      CALI_CXX_MARK_SCOPE("surrogate_samples_output");
+      const QuadratureFunction *qstress0 = model->GetStress0();
+      const QuadratureFunction *qstress1 = model->GetStress1();
+      QuadratureFunction vel_grad(qstress0->GetSpace(), 9);
+      mech_operator->CalculateVelocityGradient(vel_grad);
+
+      const double dt = model->GetModelDt();
+      const double* vgrad = vel_grad.HostRead();
+      const double* stress_beg = qstress0->HostRead();
+      const double* stress_end = qstress1->HostRead();
+      const int npts = qstress0->Size() / qstress0->GetVDim();
+
+      // Each sample is the strain increment in Voigt notation with engineering
+      // shear strains followed by the beginning and end step stress.
+      std::vector<double> samples;
+      samples.reserve(18 * (npts / surrogate_stride + 1));
+      for (int i = 0; i < npts; i += surrogate_stride) {
+         double dstrain[6];
+         exaconstit::kernel::strain_incr_voigt(&vgrad[i * 9], dt, dstrain);
+         samples.insert(samples.end(), dstrain, dstrain + 6);
+         samples.insert(samples.end(), &stress_beg[i * 6], &stress_beg[i * 6 + 6]);
+         samples.insert(samples.end(), &stress_end[i * 6], &stress_end[i * 6 + 6]);
+      }
+      surrogate_samples_file.write(reinterpret_cast<const char*>(samples.data()),
+                                   sizeof(double) * samples.size());
+      surrogate_samples_file.flush();
+   }
+
    model->UpdateModelVars();
 
    // internally these two Update methods swap the internal data of the end step
@@ -434,14 +606,62 @@ void SystemDriver::UpdateModel()
    }
 
    {
-      CALI_CXX_MARK_SCOPE("avg_stress_computation");
+      CALI_CXX_MARK_SCOPE("avg_computations");
+      // All of the volume averaged values are reduced together in a single pass
+      // over the quadrature points with a single MPI_Allreduce.
+      std::vector<const QuadratureFunction*> qfs;
+      std::vector<bool> vol_avg;
+
       // Here we're getting the average stress value
-      Vector stress(6);
-      stress = 0.0;
+      qfs.push_back(model->GetStress0());
+      vol_avg.push_back(true);
+
+      const bool ecmech_avgs = (mech_type == MechType::EXACMECH && additional_avgs);
+
+      // Only the plastic work is pulled out and summed up, which also lets us
+      // not care about how the state variables are laid out.
+      QuadratureFunction pl_work;
+      QuadratureFunction dp_mat;
+      if (ecmech_avgs) {
+         const QuadratureFunction *qstate_var = model->GetMatVars0();
+         std::string s_pl_work = "pl_work";
+         auto qf_mapping = model->GetQFMapping();
+         auto pair = qf_mapping->find(s_pl_work)->second;
+
+         pl_work.SetSpace(qstate_var->GetSpace(), 1);
+         {
+            const int npts = pl_work.Size();
+            const int pt_stride = model->GetStatePtStride();
+            const int ind = pair.first * model->GetStateVarStride();
+            const double* state_vars = qstate_var->Read();
+            double* pl_work_data = pl_work.Write();
+            MFEM_FORALL(i, npts, {
+               pl_work_data[i] = state_vars[i * pt_stride + ind];
+            });
+         }
+         qfs.push_back(&pl_work);
+         vol_avg.push_back(false);
+         mech_operator->CalculateDeformationGradient(def_grad);
+      }
 
-      const QuadratureFunction *qstress = model->GetStress0();
+      if (additional_avgs) {
+         qfs.push_back(&def_grad);
+         vol_avg.push_back(true);
+      }
+
+      if (ecmech_avgs) {
+         dp_mat.SetSpace(def_grad.GetSpace(), def_grad.GetVDim());
+         model->calcDpMat(dp_mat);
+         qfs.push_back(&dp_mat);
+         vol_avg.push_back(true);
+      }
 
-      exaconstit::kernel::ComputeVolAvgTensor<true>(fes, qstress, stress, 6, class_device);
+      // CalculateDeformationGradient swaps the mesh nodes around but puts the
+      // end step ones back, so the weights from before it are still good.
+      UpdateGeomWeights();
+      Vector avgs;
+      exaconstit::kernel::ComputeVolAvgTensors(fes->GetComm(), qpt_weights, qfs, vol_avg, avgs, class_device);
+      const double* avg_data = avgs.HostRead();
 
       std::cout.setf(std::ios::fixed);
       std::cout.setf(std::ios::showpoint);
@@ -449,124 +669,121 @@ void SystemDriver::UpdateModel()
 
       int my_id;
       MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
-      // Now we're going to save off the average stress tensor to a file
+      step_count++;
+      // Now we're going to save off the averages to their files
       if (my_id == 0) {
-         std::ofstream file;
-
-         file.open(avg_stress_fname, std::ios_base::app);
-
-         stress.Print(file, 6);
-      }
-   }
-
-   if (mech_type == MechType::EXACMECH && additional_avgs) {
-      CALI_CXX_MARK_SCOPE("extra_avgs_computations");
-      const QuadratureFunction *qstate_var = model->GetMatVars0();
-      // Here we're getting the average stress value
-      Vector state_var(qstate_var->GetVDim());
-      state_var = 0.0;
+         const int vdim = def_grad.GetVDim();
+         const int off_pl_work = 6;
+         const int off_dgrad = off_pl_work + (ecmech_avgs ? 1 : 0);
+         const int off_dp = off_dgrad + (additional_avgs ? vdim : 0);
+
+         // The plastic deformation rate tensor is saved in Voigt notation
+         Vector dpgrad(6);
+         if (ecmech_avgs) {
+            const double* dgrad = &avg_data[off_dp];
+            dpgrad(0) = dgrad[0];
+            dpgrad(1) = dgrad[4];
+            dpgrad(2) = dgrad[8];
+            dpgrad(3) = dgrad[5];
+            dpgrad(4) = dgrad[2];
+            dpgrad(5) = dgrad[1];
+         }
 
-      std::string s_pl_work = "pl_work";
-      auto qf_mapping = model->GetQFMapping();
-      auto pair = qf_mapping->find(s_pl_work)->second;
+         if (avg_writer) {
+            std::vector<double> record = { solVars.GetTime(), solVars.GetDTime(), (double) step_count,
+                                           (double) newton_solver->GetNumIterations(),
+                                           (double) newton_solver->GetKrylovIterations() };
+            record.insert(record.end(), avg_data, avg_data + off_dp);
+            if (ecmech_avgs) {
+               record.insert(record.end(), dpgrad.HostRead(), dpgrad.HostRead() + 6);
+            }
+            avg_writer->Append(record);
+         }
+         else {
+            {
+               Vector stress(const_cast<double*>(avg_data), 6);
+               std::ofstream file;
+               file.open(avg_stress_fname, std::ios_base::app);
+               stress.Print(file, 6);
+            }
 
-      exaconstit::kernel::ComputeVolAvgTensor<false>(fes, qstate_var, state_var, state_var.Size(), class_device);
+            if (ecmech_avgs) {
+               std::ofstream file;
+               file.open(avg_pl_work_fname, std::ios_base::app);
+               file << avg_data[off_pl_work] << std::endl;
+            }
 
-      std::cout.setf(std::ios::fixed);
-      std::cout.setf(std::ios::showpoint);
-      std::cout.precision(8);
+            if (additional_avgs) {
+               Vector dgrad(const_cast<double*>(&avg_data[off_dgrad]), vdim);
+               std::ofstream file;
+               file.open(avg_def_grad_fname, std::ios_base::app);
+               dgrad.Print(file, vdim);
+            }
 
-      int my_id;
-      MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
-      // Now we're going to save off the average stress tensor to a file
-      if (my_id == 0) {
-         std::ofstream file;
-         file.open(avg_pl_work_fname, std::ios_base::app);
-         file << state_var[pair.first] << std::endl;
+            if (ecmech_avgs) {
+               std::ofstream file;
+               file.open(avg_dp_tensor_fname, std::ios_base::app);
+               dpgrad.Print(file, dpgrad.Size());
+            }
+         }
       }
-      mech_operator->CalculateDeformationGradient(def_grad);
    }
 
-   if (additional_avgs)
-   {
-      CALI_CXX_MARK_SCOPE("extra_avgs_def_grad_computation");
-      const QuadratureFunction *qstate_var = &def_grad;
-      // Here we're getting the average stress value
-      Vector dgrad(qstate_var->GetVDim());
-      dgrad = 0.0;
-
-      exaconstit::kernel::ComputeVolAvgTensor<true>(fes, qstate_var, dgrad, dgrad.Size(), class_device);
-
-      std::cout.setf(std::ios::fixed);
-      std::cout.setf(std::ios::showpoint);
-      std::cout.precision(8);
+   if(postprocessing) {
+      CalcElementAvg(evec, model->GetMatVars0());
+   }
+}
 
-      int my_id;
-      MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
-      // Now we're going to save off the average stress tensor to a file
-      if (my_id == 0) {
-         std::ofstream file;
-         file.open(avg_def_grad_fname, std::ios_base::app);
-         dgrad.Print(file, dgrad.Size());
-      }
+void SystemDriver::UpdateGeomWeights()
+{
+   if (geom_weights_valid) {
+      return;
    }
+   CALI_CXX_MARK_SCOPE("geom_weights_update");
 
-   if (mech_type == MechType::EXACMECH && additional_avgs) {
-      CALI_CXX_MARK_SCOPE("extra_avgs_dp_tensor_computation");
+   const FiniteElement &el = *fe_space.GetFE(0);
+   const IntegrationRule *ir = &(IntRules.Get(el.GetGeomType(), 2 * el.GetOrder() + 1));
 
-      model->calcDpMat(def_grad);
-      const QuadratureFunction *qstate_var = &def_grad;
-      // Here we're getting the average stress value
-      Vector dgrad(qstate_var->GetVDim());
-      dgrad = 0.0;
+   const int nqpts = ir->GetNPoints();
+   const int nelems = fe_space.GetNE();
 
-      exaconstit::kernel::ComputeVolAvgTensor<true>(fes, qstate_var, dgrad, dgrad.Size(), class_device);
+   exaconstit::kernel::ComputeQptWeights(&fe_space, qpt_weights);
 
-      std::cout.setf(std::ios::fixed);
-      std::cout.setf(std::ios::showpoint);
-      std::cout.precision(8);
+   elem_volumes.SetSize(nelems, Device::GetMemoryType());
+   elem_volumes.UseDevice(true);
 
-      Vector dpgrad(6);
-      dpgrad(0) = dgrad(0);
-      dpgrad(1) = dgrad(4);
-      dpgrad(2) = dgrad(8);
-      dpgrad(3) = dgrad(5);
-      dpgrad(4) = dgrad(2);
-      dpgrad(5) = dgrad(1);
+   const double* wts = qpt_weights.Read();
+   double* vol_data = elem_volumes.Write();
 
-      int my_id;
-      MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
-      // Now we're going to save off the average dp tensor to a file
-      if (my_id == 0) {
-         std::ofstream file;
-         file.open(avg_dp_tensor_fname, std::ios_base::app);
-         dpgrad.Print(file, dpgrad.Size());
+   MFEM_FORALL(i, nelems, {
+      double vol = 0.0;
+      for(int j = 0; j < nqpts; j++) {
+         vol += wts[i * nqpts + j];
       }
-   }
+      vol_data[i] = vol;
+   });
 
-   if(postprocessing) {
-      CalcElementAvg(evec, model->GetMatVars0());
-   }
+   geom_weights_valid = true;
 }
 
 void SystemDriver::CalcElementAvg(mfem::Vector *elemVal, const mfem::QuadratureFunction *qf)
 {
-
-   Mesh *mesh = fe_space.GetMesh();
    const FiniteElement &el = *fe_space.GetFE(0);
    const IntegrationRule *ir = &(IntRules.Get(el.GetGeomType(), 2 * el.GetOrder() + 1));;
 
    const int nqpts = ir->GetNPoints();
    const int nelems = fe_space.GetNE();
    const int vdim = qf->GetVDim();
+   // The state variables might be stored as a structure of arrays
+   const bool soa = model->GetStateSoA() && qf == model->GetMatVars0();
 
-   const double* W = ir->GetWeights().Read();
-   const GeometricFactors *geom = mesh->GetGeometricFactors(*ir, GeometricFactors::DETERMINANTS);
+   UpdateGeomWeights();
 
    const int DIM2 = 2;
    const int DIM3 = 3;
    std::array<RAJA::idx_t, DIM2> perm2 {{ 1, 0 } };
-   std::array<RAJA::idx_t, DIM3> perm3 {{2, 1, 0}};
+   std::array<RAJA::idx_t, DIM3> perm3 = soa ? std::array<RAJA::idx_t, DIM3> {{0, 2, 1}}
+                                             : std::array<RAJA::idx_t, DIM3> {{2, 1, 0}};
 
    RAJA::Layout<DIM2> layout_geom = RAJA::make_permuted_layout({{ nqpts, nelems } }, perm2);
    RAJA::Layout<DIM2> layout_ev = RAJA::make_permuted_layout({{ vdim, nelems } }, perm2);
@@ -574,26 +791,106 @@ void SystemDriver::CalcElementAvg(mfem::Vector *elemVal, const mfem::QuadratureF
 
    (*elemVal) = 0.0;
 
-   RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > j_view(geom->detJ.Read(), layout_geom);
+   const double* vol_data = elem_volumes.Read();
+   RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > w_view(qpt_weights.Read(), layout_geom);
    RAJA::View<const double, RAJA::Layout<DIM3, RAJA::Index_type, 0> > qf_view(qf->Read(), layout_qf);
    RAJA::View<double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > ev_view(elemVal->ReadWrite(), layout_ev);
 
    MFEM_FORALL(i, nelems, {
-      double vol = 0.0;
       for(int j = 0; j < nqpts; j++) {
-         const double wts = j_view(j, i) * W[j];
-         vol += wts;
+         const double wts = w_view(j, i);
          for(int k = 0; k < vdim; k++) {
             ev_view(k, i) += qf_view(k, j, i) * wts;
          }
       }
-      const double ivol = 1.0 / vol;
+      const double ivol = 1.0 / vol_data[i];
       for(int k = 0; k < vdim; k++) {
          ev_view(k, i) *= ivol;
       }
    });
 }
 
+void SystemDriver::CalcElementCosts(mfem::Vector &elemCost)
+{
+   const QuadratureFunction *qstate_var = model->GetMatVars0();
+   auto qf_mapping = model->GetQFMapping();
+   auto it = qf_mapping->find("num_evals");
+   MFEM_VERIFY(it != qf_mapping->end(), "CalcElementCosts requires a model that tracks the number of evaluations");
+   const int ind_num_evals = it->second.first;
+
+   const int nelems = fe_space.GetNE();
+   const int vdim = qstate_var->GetVDim();
+   const int nqpts = (nelems > 0) ? qstate_var->Size() / (vdim * nelems) : 0;
+   const int pt_stride = model->GetStatePtStride();
+   const int ind = ind_num_evals * model->GetStateVarStride();
+
+   // This is only done every so often, so it's fine to do on the host.
+   const double* state_vars = qstate_var->HostRead();
+   elemCost.SetSize(nelems);
+   double* cost = elemCost.HostWrite();
+   for (int ie = 0; ie < nelems; ie++) {
+      cost[ie] = 0.0;
+      for (int iq = 0; iq < nqpts; iq++) {
+         cost[ie] += 1.0 + state_vars[(ie * nqpts + iq) * pt_stride + ind];
+      }
+   }
+}
+
+void SystemDriver::RegisterCheckpointFields(CheckpointManager &chkpt)
+{
+   // The state variables are saved in whatever layout and precision they're
+   // stored in, so a restart needs to use the same state variable options.
+   chkpt.RegisterField("matVars0", model->GetMatVars0(), model->GetStatePtStride(),
+                       model->GetStateVarStride());
+   chkpt.RegisterField("stress0", model->GetStress0());
+   chkpt.RegisterField("kinVars0", &def_grad);
+}
+
+void SystemDriver::GetCheckpointState(std::map<std::string, double> &state) const
+{
+   state["dt_controller_dt"] = dt_class;
+   state["dt_controller_err_prev"] = dt_err_prev;
+   state["step_count"] = step_count;
+}
+
+void SystemDriver::SetCheckpointState(const std::map<std::string, double> &state)
+{
+   dt_class = state.at("dt_controller_dt");
+   dt_err_prev = state.at("dt_controller_err_prev");
+   step_count = static_cast<int>(state.at("step_count"));
+   if (avg_writer) {
+      avg_writer->Restart(step_count);
+   }
+   // The coordinates have changed out from under us
+   geom_weights_valid = false;
+}
+
+void SystemDriver::PrintKernelThreadImbalance()
+{
+   std::vector<double> times;
+   if (auto region_model = dynamic_cast<ExaCMechRegionModel*>(model)) {
+      region_model->GetThreadTimes(times);
+   }
+   else if (auto ecmech_model = dynamic_cast<ExaCMechModel*>(model)) {
+      ecmech_model->GetThreadTimes(times);
+   }
+
+   double max_time = 0.0;
+   double sum_time = 0.0;
+   for (const double time : times) {
+      max_time = std::max(max_time, time);
+      sum_time += time;
+   }
+   double imbalance = (sum_time > 0.0) ? max_time * times.size() / sum_time : 1.0;
+   double max_imbalance;
+   MPI_Reduce(&imbalance, &max_imbalance, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+   if (myid == 0) {
+      std::cout << "Material kernel thread imbalance (max / mean thread time, worst process): "
+                << max_imbalance << std::endl;
+   }
+}
+
 void SystemDriver::ProjectCentroid(ParGridFunction &centroid)
 {
 
@@ -605,8 +902,9 @@ void SystemDriver::ProjectCentroid(ParGridFunction &centroid)
    const int nelems = fe_space.GetNE();
    const int vdim = mesh->SpaceDimension();
 
-   const double* W = ir->GetWeights().Read();
-   const GeometricFactors *geom = mesh->GetGeometricFactors(*ir, GeometricFactors::DETERMINANTS | GeometricFactors::COORDINATES);
+   UpdateGeomWeights();
+   // Only the physical coordinates of the quadrature points are needed from the mesh
+   const GeometricFactors *geom = mesh->GetGeometricFactors(*ir, GeometricFactors::COORDINATES);
 
    const int DIM2 = 2;
    const int DIM3 = 3;
@@ -619,20 +917,19 @@ void SystemDriver::ProjectCentroid(ParGridFunction &centroid)
 
    centroid = 0.0;
 
-   RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > j_view(geom->detJ.Read(), layout_geom);
+   const double* vol_data = elem_volumes.Read();
+   RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > w_view(qpt_weights.Read(), layout_geom);
    RAJA::View<const double, RAJA::Layout<DIM3, RAJA::Index_type, 0> > x_view(geom->X.Read(), layout_qf);
    RAJA::View<double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > ev_view(centroid.ReadWrite(), layout_ev);
 
    MFEM_FORALL(i, nelems, {
-      double vol = 0.0;
       for(int j = 0; j < nqpts; j++) {
-         const double wts = j_view(j, i) * W[j];
-         vol += wts;
+         const double wts = w_view(j, i);
          for(int k = 0; k < vdim; k++) {
             ev_view(k, i) += x_view(j, k, i) * wts;
          }
       }
-      const double ivol = 1.0 / vol;
+      const double ivol = 1.0 / vol_data[i];
       for(int k = 0; k < vdim; k++) {
          ev_view(k, i) *= ivol;
       }
@@ -641,28 +938,15 @@ void SystemDriver::ProjectCentroid(ParGridFunction &centroid)
 
 void SystemDriver::ProjectVolume(ParGridFunction &vol)
 {
-   Mesh *mesh = fe_space.GetMesh();
-   const FiniteElement &el = *fe_space.GetFE(0);
-   const IntegrationRule *ir = &(IntRules.Get(el.GetGeomType(), 2 * el.GetOrder() + 1));;
-
-   const int nqpts = ir->GetNPoints();
    const int nelems = fe_space.GetNE();
 
-   const double* W = ir->GetWeights().Read();
-   const GeometricFactors *geom = mesh->GetGeometricFactors(*ir, GeometricFactors::DETERMINANTS);
+   UpdateGeomWeights();
 
-   const int DIM2 = 2;
-   std::array<RAJA::idx_t, DIM2> perm2 {{ 1, 0 } };
-   RAJA::Layout<DIM2> layout_geom = RAJA::make_permuted_layout({{ nqpts, nelems } }, perm2);
-
-   double *vol_data = vol.ReadWrite();
-   RAJA::View<const double, RAJA::Layout<DIM2, RAJA::Index_type, 0> > j_view(geom->detJ.Read(), layout_geom);
+   const double* vol_beg = elem_volumes.Read();
+   double *vol_data = vol.Write();
 
    MFEM_FORALL(i, nelems, {
-      vol_data[i] = 0.0;
-      for(int j = 0; j < nqpts; j++) {
-         vol_data[i] += j_view(j, i) * W[j];
-      }
+      vol_data[i] = vol_beg[i];
    });
 }
 
@@ -756,11 +1040,27 @@ void SystemDriver::ProjectShearRate(ParGridFunction &gdot)
    if (mech_type == MechType::EXACMECH) {
       std::string s_gdot = "gdot";
       auto qf_mapping = model->GetQFMapping();
-      auto pair = qf_mapping->find(s_gdot)->second;
+      auto it = qf_mapping->find(s_gdot);
 
-      VectorQuadratureFunctionCoefficient qfvc(*evec);
-      qfvc.SetComponent(pair.first, pair.second);
-      gdot.ProjectDiscCoefficient(qfvc, mfem::GridFunction::ARITHMETIC);
+      if (it != qf_mapping->end()) {
+         auto pair = it->second;
+         VectorQuadratureFunctionCoefficient qfvc(*evec);
+         qfvc.SetComponent(pair.first, pair.second);
+         gdot.ProjectDiscCoefficient(qfvc, mfem::GridFunction::ARITHMETIC);
+      }
+      else {
+         // The shear rates are stored in single precision, so they need to be
+         // unpacked before they can be averaged over the elements.
+         const int nslip = model->GetNumReducedState();
+         QuadratureFunction q_gdot(model->GetMatVars0()->GetSpace(), nslip);
+         model->GetReducedState(q_gdot);
+         QuadratureFunction e_gdot(evec->GetSpace(), nslip);
+         CalcElementAvg(&e_gdot, &q_gdot);
+
+         VectorQuadratureFunctionCoefficient qfvc(e_gdot);
+         qfvc.SetComponent(0, nslip);
+         gdot.ProjectDiscCoefficient(qfvc, mfem::GridFunction::ARITHMETIC);
+      }
    }
    return;
 }
@@ -886,6 +1186,7 @@ void SystemDriver::SetDt(const double dt)
 SystemDriver::~SystemDriver()
 {
    delete ess_bdr_func;
+   delete J_sc_solver;
    delete J_solver;
    if (J_prec != NULL) {
       delete J_prec;
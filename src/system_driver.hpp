@@ -5,8 +5,14 @@
 #include "mechanics_model.hpp"
 #include "mechanics_operator.hpp"
 #include "mechanics_solver.hpp"
+#include "mechanics_static_cond.hpp"
 #include "option_parser.hpp"
+#include "mechanics_timeseries.hpp"
+#include "mechanics_checkpoint.hpp"
 #include <iostream>
+#include <fstream>
+#include <map>
+#include <memory>
 
 class SimVars
 {
@@ -40,6 +46,8 @@ class SystemDriver
       mfem::Solver *J_solver;
       /// Preconditioner for the Jacobian
       mfem::Solver *J_prec;
+      /// Static condensation wrapper around J_solver if requested
+      MechStaticCondSolver *J_sc_solver = nullptr;
       /// nonlinear model
       ExaModel *model;
       int newton_iter;
@@ -54,16 +62,48 @@ class SystemDriver
       bool auto_time = false;
       double dt_class = 0.0;
       double dt_min = 0.0;
+      double dt_max = 1.0;
       double dt_scale = 1.0;
+      double dt_growth_max = 1.0;
+      TimeStepController dt_controller = TimeStepController::ITER;
+      /// If set the time step ratio suggested by the material model is used
+      /// when cutting back or growing the time step
+      bool honor_dt_ratio = false;
+      double newton_rel_tol = 1.0e-5;
+      /// Normalized solver error estimate from the last converged step used by
+      /// the PI time step controller
+      double dt_err_prev = 1.0;
       mfem::QuadratureFunction &def_grad;
       std::string avg_stress_fname;
       std::string avg_pl_work_fname;
       std::string avg_def_grad_fname;
       std::string avg_dp_tensor_fname;
       std::string auto_dt_fname;
+      /// Only open on rank 0 when auto time stepping is on
+      std::ofstream auto_dt_file;
+      /// Only created on rank 0 when the averages go to a binary time series file
+      std::unique_ptr<TimeSeriesWriter> avg_writer;
+      /// Number of time steps that have been completed
+      int step_count = 0;
+      /// Every rank writes its own surrogate model training data file when
+      /// Model.ExaCMech.surrogate_samples_floc is provided
+      std::ofstream surrogate_samples_file;
+      int surrogate_stride = 1;
 
       mfem::QuadratureFunction *evec;
 
+      /// Quadrature point integration weights, detJ * W, and element volumes of the
+      /// current configuration. They're computed once after a step converges and
+      /// shared by all of the averaging and projection routines until the
+      /// coordinates change again.
+      mfem::Vector qpt_weights;
+      mfem::Vector elem_volumes;
+      bool geom_weights_valid = false;
+
+      /// Recomputes the quadrature point weights and element volumes if the
+      /// coordinates have changed since they were last computed
+      void UpdateGeomWeights();
+
       // define a boundary attribute array and initialize to 0
       std::unordered_map<std::string, mfem::Array<int> > ess_bdr;
       mfem::Array2D<double> ess_bdr_scale;
@@ -76,6 +116,10 @@ class SystemDriver
       const bool vgrad_origin_flag = false;
       mfem::Vector vgrad_origin;
 
+      /// Returns the factor that the time step should be scaled by for the next
+      /// step based on how the nonlinear solver performed during the current step.
+      double ComputeDtFactor(const bool cut_back);
+
    public:
       SystemDriver(mfem::ParFiniteElementSpace &fes,
                    ExaOptions &options,
@@ -144,6 +188,24 @@ class SystemDriver
       // Computes the element average of a quadrature function and stores it in a
       // vector. This is meant to be a helper function for the Project* methods.
       void CalcElementAvg(mfem::Vector *elemVal, const mfem::QuadratureFunction *qf);
+
+      // Computes the material model cost of each element, which is the number of
+      // material point solver evaluations summed over its quadrature points. Every
+      // point counts for at least 1 so purely elastic elements still have a cost.
+      // This is only available with ExaCMech type models.
+      void CalcElementCosts(mfem::Vector &elemCost);
+
+      // Registers the material state of the model with the checkpoints
+      void RegisterCheckpointFields(CheckpointManager &chkpt);
+
+      // The time step controller and step counter values that are saved in the
+      // checkpoints, and setting them back from a checkpoint
+      void GetCheckpointState(std::map<std::string, double> &state) const;
+      void SetCheckpointState(const std::map<std::string, double> &state);
+
+      // Prints the max / mean ratio of the time the OpenMP threads spent in the
+      // chunked material kernel, which is only tracked for ExaCMech type models.
+      void PrintKernelThreadImbalance();
       virtual ~SystemDriver();
 
 };
@@ -0,0 +1,21 @@
+
+#include "uservumat.h"
+
+extern "C" {
+
+   // The batched entry point for our test umat. It doesn't do anything
+   // vectorized and just hands each point over to the per point umat.
+   UMAT_API void
+   batch_umat(int *npts, int *nstatv, int *nprops, real8 *props,
+              real8 *time, real8 *deltaTime, real8 *celent,
+              real8 *stran, real8 *dstran, real8 *drot,
+              real8 *dfgrd0, real8 *dfgrd1, real8 *stress,
+              real8 *statev, real8 *ddsdde, real8 *pnewdt,
+              int *noel, int *npt)
+   {
+      umat_batch_adapter(npts, nstatv, nprops, props, time, deltaTime, celent,
+                         stran, dstran, drot, dfgrd0, dfgrd1, stress, statev,
+                         ddsdde, pnewdt, noel, npt);
+   }
+
+}
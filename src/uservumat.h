@@ -0,0 +1,40 @@
+#ifndef uservumat_h
+#define uservumat_h
+
+#include "userumat.h"
+
+// The batched user material interface. Rather than being called once per
+// point, the user material is handed a block of npts points at a time with
+// everything stored as a structure of arrays, so a model written against it
+// can vectorize over the points. Component c of point i of any of the per
+// point arrays below lives at array[c * npts + i]. All of the component
+// orderings follow the per point UMAT interface:
+//    stran, dstran, stress: Abaqus ordering (11, 22, 33, 12, 13, 23)
+//    drot, dfgrd0, dfgrd1: column major 3x3 matrices
+//    ddsdde: column major 6x6 matrix in the Abaqus ordering
+//    statev: nstatv state variables
+//    celent, pnewdt, noel, npt: 1 component
+// The props and time arrays are shared by every point in the block.
+extern "C" {
+   // The batched user material, which needs to be provided by the user.
+   // umat_tests/uservumat.cxx provides one that just calls the per point UMAT.
+   UMAT_API void
+   batch_umat(int *npts, int *nstatv, int *nprops, real8 *props,
+              real8 *time, real8 *deltaTime, real8 *celent,
+              real8 *stran, real8 *dstran, real8 *drot,
+              real8 *dfgrd0, real8 *dfgrd1, real8 *stress,
+              real8 *statev, real8 *ddsdde, real8 *pnewdt,
+              int *noel, int *npt);
+
+   // Calls the per point UMAT on each point of a block in the batched
+   // interface's layout, so the old UMATs can be driven by the batched code.
+   UMAT_API void
+   umat_batch_adapter(int *npts, int *nstatv, int *nprops, real8 *props,
+                      real8 *time, real8 *deltaTime, real8 *celent,
+                      real8 *stran, real8 *dstran, real8 *drot,
+                      real8 *dfgrd0, real8 *dfgrd1, real8 *stress,
+                      real8 *statev, real8 *ddsdde, real8 *pnewdt,
+                      int *noel, int *npt);
+}
+
+#endif /* uservumat_h */
@@ -0,0 +1,153 @@
+#include "mfem.hpp"
+#include "mfem/general/forall.hpp"
+#include "mechanics_ecmech.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace mfem;
+
+static int outputLevel = 0;
+
+// The properties from test/data/props_cp_voce.txt
+const double voce_props[17] = { 8.920e-6, 0.003435984, 1.0e-10, 168.4e0, 121.4e0, 75.2e0,
+                                44.0e0, 0.02e0, 1.0e0, 400.0e-3, 17.0e-3, 122.4e-3,
+                                0.0, 5.0e9, 17.0e-3, 0.0, -1.0307952 };
+
+// This function had to be moved out of the TEST() macro
+// as CUDA was now complains about it being a private function/variable.
+// Every point is given a small enough velocity gradient that it stays elastic,
+// and the material update is run once as a single step and once with every
+// point sub-stepped. It returns the max relative difference between the two
+// tangents in tangent_err, and the min number of evaluations of the single step
+// run in evals_step.
+void test_substep_body(double &tangent_err, double &evals_step)
+{
+   mfem::ParMesh *pmesh = nullptr;
+   {
+      mfem::Mesh mesh = Mesh::MakeCartesian3D(2, 1, 1, Element::HEXAHEDRON, 1.0, 1.0, 1.0, false);
+      pmesh = new mfem::ParMesh(MPI_COMM_WORLD, mesh);
+   }
+
+   const int nstatev = 24;
+   const int nsvec2 = 36;
+   QuadratureSpace qspace(pmesh, 3);
+   QuadratureFunction q_sigma0(&qspace, 6);
+   QuadratureFunction q_sigma1(&qspace, 6);
+   QuadratureFunction q_matGrad(&qspace, nsvec2);
+   QuadratureFunction q_matVars0(&qspace, nstatev);
+   QuadratureFunction q_matVars1(&qspace, nstatev);
+   Vector matProps(17);
+   for (int i = 0; i < 17; i++) {
+      matProps(i) = voce_props[i];
+   }
+
+   const int npts = q_sigma0.Size() / 6;
+   // The model initializes everything but the orientations, which are all
+   // set to the identity
+   q_matVars0 = 0.0;
+   q_sigma0 = 0.0;
+   {
+      double* state_vars = q_matVars0.HostReadWrite();
+      for (int ip = 0; ip < npts; ip++) {
+         state_vars[ip * nstatev + ecmech::evptn::iHistLbQ] = 1.0;
+      }
+   }
+
+   VoceFCCModel model(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
+                      nullptr, nullptr, &matProps, 17, nstatev, 298.0,
+                      ecmech::ExecutionStrategy::CPU, false);
+   const int ind_evals = model.GetQFMapping()->at("num_evals").first;
+
+   const double dt = 0.1;
+   const int nnodes = 3;
+   model.SetModelDt(dt);
+   model.SetTangentRequired(true);
+
+   // Each point gets its own element with an identity jacobian and 3 "nodes" whose
+   // local gradients are the unit vectors, so the element velocities are just the
+   // velocity gradient. The strain increments are around 1e-6, which is well within
+   // the elastic regime.
+   Vector jacobian(9 * npts), loc_grad(9), vel(9 * npts);
+   jacobian = 0.0;
+   loc_grad = 0.0;
+   for (int i = 0; i < 3; i++) {
+      loc_grad(i + 3 * i) = 1.0;
+      for (int ip = 0; ip < npts; ip++) {
+         jacobian(9 * ip + i + 3 * i) = 1.0;
+      }
+   }
+   {
+      double* vel_data = vel.HostWrite();
+      for (int ip = 0; ip < npts; ip++) {
+         for (int i = 0; i < 9; i++) {
+            vel_data[9 * ip + i] = 1.0e-5 * sin(1.0 + i + 2.3 * ip);
+         }
+      }
+   }
+
+   auto min_evals = [&]() {
+      const double* state_vars = q_matVars1.HostRead();
+      double evals = state_vars[ind_evals];
+      for (int ip = 1; ip < npts; ip++) {
+         evals = fmin(evals, state_vars[ip * nstatev + ind_evals]);
+      }
+      return evals;
+   };
+
+   model.ModelSetup(1, npts, 3, nnodes, jacobian, loc_grad, vel);
+   std::vector<double> ddsdde_step(q_matGrad.HostRead(), q_matGrad.HostRead() + nsvec2 * npts);
+   evals_step = min_evals();
+
+   // Every point took at least evals_step evaluations, so they're all redone
+   // with 2 sub-steps once the limit is below that
+   model.SetSubstepping(std::max(static_cast<int>(evals_step) - 1, 1), 2);
+   model.ModelSetup(1, npts, 3, nnodes, jacobian, loc_grad, vel);
+   const double* ddsdde_substep = q_matGrad.HostRead();
+
+   tangent_err = 0.0;
+   for (int i = 0; i < nsvec2 * npts; i++) {
+      tangent_err = fmax(tangent_err, fabs(ddsdde_substep[i] - ddsdde_step[i]) /
+                         fmax(1.0, fabs(ddsdde_step[i])));
+   }
+
+   delete pmesh;
+}
+
+TEST(ExaConstit, SubstepElasticTangent)
+{
+   double tangent_err, evals_step;
+   test_substep_body(tangent_err, evals_step);
+   // The smallest sub-stepping limit is 1 evaluation
+   ASSERT_GE(evals_step, 2.0) << "The elastic points don't take enough evaluations to be sub-stepped";
+   EXPECT_LT(tangent_err, 1e-4) << "The sub-stepped tangent doesn't match the single step tangent";
+}
+
+int main(int argc, char *argv[])
+{
+   // Initialize MPI.
+   int num_procs, myid;
+   MPI_Init(&argc, &argv);
+   MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+   MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+   Device device("cpu");
+   printf("\n");
+   device.Print();
+
+   ::testing::InitGoogleTest(&argc, argv);
+   if (argc > 1) {
+      outputLevel = atoi(argv[1]);
+   }
+   std::cout << "got outputLevel : " << outputLevel << std::endl;
+
+   int i = RUN_ALL_TESTS();
+
+   MPI_Finalize();
+
+   return i;
+}
@@ -0,0 +1,214 @@
+#include "mfem.hpp"
+#include "mfem/general/forall.hpp"
+#include "mechanics_surrogate.hpp"
+#include "mechanics_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace mfem;
+
+static int outputLevel = 0;
+
+// A small 12-8-6 network with random weights that's written out in the layout
+// documented in mechanics_surrogate.hpp
+#ifndef SURROGATE_WEIGHTS_FILE
+#define SURROGATE_WEIGHTS_FILE "surrogate_weights.bin"
+#endif
+
+// A plain host version of the network's forward pass that the model is checked against
+void reference_forward(const std::string &fname, const double* x, double* y)
+{
+   std::ifstream ifile(fname, std::ios::binary);
+   int32_t nlayers = 0;
+   ifile.read(reinterpret_cast<char*>(&nlayers), sizeof(int32_t));
+   std::vector<int32_t> widths(nlayers + 1);
+   ifile.read(reinterpret_cast<char*>(widths.data()), sizeof(int32_t) * (nlayers + 1));
+
+   std::vector<double> in_mean(12), in_scale(12), out_mean(6), out_scale(6);
+   ifile.read(reinterpret_cast<char*>(in_mean.data()), sizeof(double) * 12);
+   ifile.read(reinterpret_cast<char*>(in_scale.data()), sizeof(double) * 12);
+   ifile.read(reinterpret_cast<char*>(out_mean.data()), sizeof(double) * 6);
+   ifile.read(reinterpret_cast<char*>(out_scale.data()), sizeof(double) * 6);
+
+   std::vector<double> a(12);
+   for (int i = 0; i < 12; i++) {
+      a[i] = (x[i] - in_mean[i]) / in_scale[i];
+   }
+   for (int l = 0; l < nlayers; l++) {
+      std::vector<double> W(widths[l + 1] * widths[l]), b(widths[l + 1]);
+      ifile.read(reinterpret_cast<char*>(W.data()), sizeof(double) * W.size());
+      ifile.read(reinterpret_cast<char*>(b.data()), sizeof(double) * b.size());
+      std::vector<double> z(b);
+      for (int o = 0; o < widths[l + 1]; o++) {
+         for (int i = 0; i < widths[l]; i++) {
+            z[o] += W[o * widths[l] + i] * a[i];
+         }
+         if (l < nlayers - 1) {
+            z[o] = tanh(z[o]);
+         }
+      }
+      a.swap(z);
+   }
+   for (int i = 0; i < 6; i++) {
+      y[i] = a[i] * out_scale[i] + out_mean[i];
+   }
+}
+
+// Each point gets its own element with an identity jacobian and 3 "nodes" whose
+// local gradients are the unit vectors. The element velocities are then just the
+// velocity gradient, so any velocity gradient can be given to the model directly.
+void set_vel_grad(const int npts, const double* vgrads, Vector &vel)
+{
+   double* vel_data = vel.HostWrite();
+   for (int ip = 0; ip < npts; ip++) {
+      for (int q = 0; q < 3; q++) {
+         for (int r = 0; r < 3; r++) {
+            vel_data[9 * ip + r + 3 * q] = vgrads[9 * ip + q + 3 * r];
+         }
+      }
+   }
+}
+
+// This function had to be moved out of the TEST() macro
+// as CUDA was now complains about it being a private function/variable.
+// It returns the max error of the stress against the reference network in
+// stress_err and the max error of the tangent against central differences of
+// the model's stress in tangent_err.
+void test_surrogate_body(double &stress_err, double &tangent_err)
+{
+   mfem::ParMesh *pmesh = nullptr;
+   {
+      mfem::Mesh mesh = Mesh::MakeCartesian3D(2, 1, 1, Element::HEXAHEDRON, 1.0, 1.0, 1.0, false);
+      pmesh = new mfem::ParMesh(MPI_COMM_WORLD, mesh);
+   }
+
+   QuadratureSpace qspace(pmesh, 3);
+   QuadratureFunction q_sigma0(&qspace, 6);
+   QuadratureFunction q_sigma1(&qspace, 6);
+   QuadratureFunction q_matGrad(&qspace, 36);
+   QuadratureFunction q_matVars0(&qspace, 1);
+   QuadratureFunction q_matVars1(&qspace, 1);
+   Vector matProps(1);
+   q_matVars0 = 0.0;
+
+   SurrogateModel model(&q_sigma0, &q_sigma1, &q_matGrad, &q_matVars0, &q_matVars1,
+                        nullptr, nullptr, &matProps, 0, 1, SURROGATE_WEIGHTS_FILE, false);
+
+   const double dt = 0.1;
+   const int npts = q_sigma0.Size() / 6;
+   const int nnodes = 3;
+   model.SetModelDt(dt);
+
+   Vector jacobian(9 * npts), loc_grad(9), vel(9 * npts);
+   jacobian = 0.0;
+   loc_grad = 0.0;
+   for (int i = 0; i < 3; i++) {
+      loc_grad(i + 3 * i) = 1.0;
+      for (int ip = 0; ip < npts; ip++) {
+         jacobian(9 * ip + i + 3 * i) = 1.0;
+      }
+   }
+
+   // Every point gets a different velocity gradient and beginning step stress
+   std::vector<double> vgrads(9 * npts);
+   double* stress0 = q_sigma0.HostWrite();
+   for (int ip = 0; ip < npts; ip++) {
+      for (int i = 0; i < 9; i++) {
+         vgrads[9 * ip + i] = 1.0e-3 * sin(1.0 + i + 2.3 * ip);
+      }
+      for (int i = 0; i < 6; i++) {
+         stress0[6 * ip + i] = 0.05 * cos(0.5 + i + 1.7 * ip);
+      }
+   }
+   set_vel_grad(npts, vgrads.data(), vel);
+
+   model.SetTangentRequired(true);
+   model.ModelSetup(1, npts, 3, nnodes, jacobian, loc_grad, vel);
+   std::vector<double> stress1(q_sigma1.HostRead(), q_sigma1.HostRead() + 6 * npts);
+   std::vector<double> ddsdde(q_matGrad.HostRead(), q_matGrad.HostRead() + 36 * npts);
+
+   stress_err = 0.0;
+   for (int ip = 0; ip < npts; ip++) {
+      double x[12], y[6];
+      exaconstit::kernel::strain_incr_voigt(&vgrads[9 * ip], dt, x);
+      for (int i = 0; i < 6; i++) {
+         x[6 + i] = stress0[6 * ip + i];
+      }
+      reference_forward(SURROGATE_WEIGHTS_FILE, x, y);
+      for (int i = 0; i < 6; i++) {
+         stress_err = fmax(stress_err, fabs(stress1[6 * ip + i] - y[i]));
+      }
+   }
+
+   // The tangent is the derivative with respect to the strain increment, so each
+   // Voigt component of D dt is perturbed through the velocity gradient. The shear
+   // components are engineering strains, so perturbing one of the two off diagonal
+   // entries changes them by the full amount.
+   const int vgrad_comp[6] = { 0, 4, 8, 5, 2, 1 };
+   const double h = 1.0e-6;
+   model.SetTangentRequired(false);
+   tangent_err = 0.0;
+   for (int k = 0; k < 6; k++) {
+      std::vector<double> stress_p(6 * npts), stress_m(6 * npts);
+      for (int sgn = -1; sgn <= 1; sgn += 2) {
+         std::vector<double> vgrads_pert(vgrads);
+         for (int ip = 0; ip < npts; ip++) {
+            vgrads_pert[9 * ip + vgrad_comp[k]] += sgn * h / dt;
+         }
+         set_vel_grad(npts, vgrads_pert.data(), vel);
+         model.ModelSetup(1, npts, 3, nnodes, jacobian, loc_grad, vel);
+         const double* stress = q_sigma1.HostRead();
+         std::copy(stress, stress + 6 * npts, (sgn > 0) ? stress_p.begin() : stress_m.begin());
+      }
+      for (int ip = 0; ip < npts; ip++) {
+         for (int i = 0; i < 6; i++) {
+            const double fd = (stress_p[6 * ip + i] - stress_m[6 * ip + i]) / (2.0 * h);
+            // The tangent is saved in column major order
+            const double dsde = ddsdde[36 * ip + i + 6 * k];
+            tangent_err = fmax(tangent_err, fabs(fd - dsde) / fmax(1.0, fabs(dsde)));
+         }
+      }
+   }
+
+   delete pmesh;
+}
+
+TEST(ExaConstit, SurrogateStressAndTangent)
+{
+   double stress_err, tangent_err;
+   test_surrogate_body(stress_err, tangent_err);
+   EXPECT_LT(stress_err, 1e-12) << "Surrogate stress doesn't match the reference network";
+   EXPECT_LT(tangent_err, 1e-5) << "Surrogate tangent doesn't match finite differences";
+}
+
+int main(int argc, char *argv[])
+{
+   // Initialize MPI.
+   int num_procs, myid;
+   MPI_Init(&argc, &argv);
+   MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+   MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+   Device device("cpu");
+   printf("\n");
+   device.Print();
+
+   ::testing::InitGoogleTest(&argc, argv);
+   if (argc > 1) {
+      outputLevel = atoi(argv[1]);
+   }
+   std::cout << "got outputLevel : " << outputLevel << std::endl;
+
+   int i = RUN_ALL_TESTS();
+
+   MPI_Finalize();
+
+   return i;
+}
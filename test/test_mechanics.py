@@ -7,13 +7,15 @@ import multiprocessing
 import numpy as np
 import unittest
 
-def check_stress(ans_pwd, test_pwd, test_case):
+def check_stress(ans_pwd, test_pwd, test_case, tol=1.0e-10, ans_skip=0):
     answers = []
     tests = []
     with open(ans_pwd) as csvfile:
         readcsv = csv.reader(csvfile, delimiter=' ')
         for row in readcsv:
             answers.append(row)
+    # A restarted run only has the steps after its checkpoint
+    answers = answers[ans_skip:]
     with open(test_pwd) as csvfile:
         readcsv = csv.reader(csvfile, delimiter=' ')
         for row in readcsv:
@@ -25,7 +27,7 @@ def check_stress(ans_pwd, test_pwd, test_case):
         for a, t in zip(ans, test):
             err += abs(float(a) - float(t))
     err = err / i
-    if (err > 1.0e-10):
+    if (err > tol):
         raise ValueError("The following test case failed: ", test_case)
     return True
 
@@ -39,18 +41,35 @@ def runSystemCommands(params):
     ans_pwd = pwd.rstrip() + '/' + ans
     tresult = test.split(".")[0]
     test_pwd = pwd.rstrip() + '/test_'+tresult+'_stress.txt'
-    check_stress(ans_pwd, test_pwd, test)
+    check_stress(ans_pwd, test_pwd, test, test_tols.get(test, 1.0e-10))
     cmd = 'rm ' + pwd.rstrip() + '/test_'+tresult+'_stress.txt'
     subprocess.run(cmd.rstrip(), stdout=subprocess.PIPE, shell=True)
     return True
 
+# Test cases that don't use the default tolerance against their answers
+# The single precision and mixed precision cases aren't expected to match the
+# full precision answers to round off, and the mixed precision case solves with
+# a different Krylov solver than its answer
+# The structure of arrays layout only changes where the state variables are
+# stored, so it has to match its answers exactly
+# The sub-stepped case integrates the material update with smaller steps, so it
+# only needs to stay close to the full step answers
+test_tols = {"voce_full_float_gdot.toml" : 1.0e-7,
+             "voce_ea_mixed_prec.toml" : 1.0e-5,
+             "voce_full_soa.toml" : 0.0,
+             "voce_full_substep.toml" : 1.0e-4}
+
 def run():
     test_cases = ["voce_pa.toml", "voce_full.toml", "voce_nl_full.toml",
-                "voce_bcc.toml", "voce_full_cyclic.toml", "mtsdd_bcc.toml", "mtsdd_full.toml", "mtsdd_full_auto.toml"]
+                "voce_bcc.toml", "voce_full_cyclic.toml", "mtsdd_bcc.toml", "mtsdd_full.toml", "mtsdd_full_auto.toml",
+                "voce_full_float_gdot.toml", "voce_ea_mixed_prec.toml", "voce_full_soa.toml",
+                "voce_full_substep.toml"]
 
     test_results = ["voce_pa_stress.txt", "voce_full_stress.txt",
                     "voce_full_stress.txt", "voce_bcc_stress.txt", "voce_full_cyclic_stress.txt",
-                    "mtsdd_bcc_stress.txt", "mtsdd_full_stress.txt", "mtsdd_full_auto_stress.txt"]
+                    "mtsdd_bcc_stress.txt", "mtsdd_full_stress.txt", "mtsdd_full_auto_stress.txt",
+                    "voce_full_stress.txt", "voce_ea_stress.txt", "voce_full_stress.txt",
+                    "voce_full_stress.txt"]
 
     result = subprocess.run('pwd', stdout=subprocess.PIPE)
 
@@ -141,12 +160,44 @@ def runExtra():
     pool.join()
     return True
 
+def runRestart():
+    # The full run writes a checkpoint halfway through its 40 steps, and the
+    # restart picks it back up on a different number of processes. Both of them
+    # should line up with the answers of the full run. The restart's partitioning
+    # differs, so the solver only converges to the same answers within its
+    # tolerances.
+    result = subprocess.run('pwd', stdout=subprocess.PIPE)
+    pwd = result.stdout.decode('utf-8').rstrip()
+    chkpt_step = 20
+    cmd = 'rm -f ' + pwd + '/test_voce_full_chkpt.* ' + pwd + '/test_voce_full_chkpt_stress.txt ' \
+        + pwd + '/test_voce_full_restart_stress.txt'
+    subprocess.run(cmd, stdout=subprocess.PIPE, shell=True)
+
+    print("Now running test case: voce_full_chkpt.toml")
+    cmd = 'mpirun -np 2 ' + pwd + '/../bin/mechanics -opt voce_full_chkpt.toml'
+    subprocess.run(cmd, stdout=subprocess.PIPE, shell=True)
+    check_stress(pwd + '/voce_full_stress.txt', pwd + '/test_voce_full_chkpt_stress.txt',
+                 "voce_full_chkpt.toml")
+
+    print("Now running test case: voce_full_restart.toml")
+    cmd = 'mpirun -np 1 ' + pwd + '/../bin/mechanics -opt voce_full_restart.toml'
+    subprocess.run(cmd, stdout=subprocess.PIPE, shell=True)
+    check_stress(pwd + '/voce_full_stress.txt', pwd + '/test_voce_full_restart_stress.txt',
+                 "voce_full_restart.toml", 1.0e-6, chkpt_step)
+
+    cmd = 'rm -f ' + pwd + '/test_voce_full_chkpt.* ' + pwd + '/test_voce_full_chkpt_stress.txt ' \
+        + pwd + '/test_voce_full_restart_stress.txt'
+    subprocess.run(cmd, stdout=subprocess.PIPE, shell=True)
+    return True
+
 class TestUnits(unittest.TestCase):
     def test_all_cases(self):
         actual = run()
         actualExtra = runExtra()
+        actualRestart = runRestart()
         self.assertTrue(actual)
         self.assertTrue(actualExtra)
+        self.assertTrue(actualRestart)
 
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file